@@ -11,75 +11,118 @@
 **  @{
 */
 
-/*! @brief Initialize the FIFO before first use.
- *
- *  @param fifo A pointer to the FIFO that needs initializing.
- *  @return bool - TRUE if the FIFO was successfully initialised
- */
-
 #include "FIFO.h"
 #include "Cpu.h"
 
-bool FIFO_Init(TFIFO *const fifo)
-{
-  fifo->Start = 0;
-  fifo->End = 0;
-  fifo->NbBytes = 0;
-  fifo->BufferAccess = OS_SemaphoreCreate(1);           //Create Semaphore (1 to indicate it is not being used)
-  fifo->SpaceAvailable = OS_SemaphoreCreate(FIFO_SIZE); //Create Semaphore which maintains space available in FIFO
-  fifo->ItemsAvailable = OS_SemaphoreCreate(0);         //Create Semaphore to wait on space available
-}
+// Index of a free-running count within the buffer
+#define FIFO_MASK (FIFO_SIZE - 1)
 
-/*! @brief Put one character into the FIFO.
+/*! @brief Wakes the other side if it is blocked waiting on us.
  *
- *  @param fifo A pointer to a FIFO struct where data is to be stored.
- *  @param data A byte of data to store in the FIFO buffer.
- *  @return bool - TRUE if data is successfully stored in the FIFO.
- *  @note Assumes that FIFO_Init has been called.
+ *  The flag is cleared before signalling, so a wait costs at most one signal.
+ *  @param waiting The other side's waiting flag.
+ *  @param semaphore The semaphore it is waiting on.
  */
-bool FIFO_Put(TFIFO *const fifo, const uint8_t data)
+static void wake(bool volatile * const waiting, OS_ECB * const semaphore)
 {
-  OS_SemaphoreWait(fifo->SpaceAvailable, 0); // Wait on space available
-  OS_SemaphoreWait(fifo->BufferAccess, 0);   // Get exclusive access
+  // Our index update must be visible before we look at the flag, and the waiter sets its flag before
+  // it looks at our index, so one of us always sees the other
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
 
-  if (fifo->NbBytes >= FIFO_SIZE) // Can't add more bytes than the FIFO size
+  if (*waiting)
   {
-    return false;
+    *waiting = false;
+    OS_SemaphoreSignal(semaphore);
   }
+}
+
+bool FIFO_Init(TFIFO *const fifo)
+{
+  fifo->Head = 0;
+  fifo->Tail = 0;
+  fifo->PutWaiting = false;
+  fifo->GetWaiting = false;
+  fifo->SpaceAvailable = OS_SemaphoreCreate(0); //Create Semaphore to wake a producer waiting for space
+  fifo->ItemsAvailable = OS_SemaphoreCreate(0); //Create Semaphore to wake a consumer waiting for bytes
+
+  return fifo->SpaceAvailable && fifo->ItemsAvailable;
+}
+
+uint16_t FIFO_Put(TFIFO *const fifo, const uint8_t data[], const uint16_t nbBytes)
+{
+  uint16_t head = fifo->Head;
+  uint16_t space = FIFO_SIZE - (uint16_t)(head - __atomic_load_n(&fifo->Tail, __ATOMIC_ACQUIRE));
+  uint16_t nbPut = (nbBytes < space) ? nbBytes : space;
 
-  fifo->NbBytes++;
-  fifo->Buffer[fifo->End] = data;
-  fifo->End = (fifo->End + 1) % FIFO_SIZE; // Cycle to the beginning if we reached the end
+  for (uint16_t byteNb = 0; byteNb < nbPut; byteNb++)
+    fifo->Buffer[(uint16_t)(head + byteNb) & FIFO_MASK] = data[byteNb];
 
-  OS_SemaphoreSignal(fifo->BufferAccess);   // Signal exclusive access
-  OS_SemaphoreSignal(fifo->ItemsAvailable); // Signal space available
-  return true;
+  // Publish the bytes only once they are all in the buffer
+  __atomic_store_n(&fifo->Head, (uint16_t)(head + nbPut), __ATOMIC_RELEASE);
+
+  if (nbPut > 0)
+    wake(&fifo->GetWaiting, fifo->ItemsAvailable);
+
+  return nbPut;
 }
 
-/*! @brief Get one character from the FIFO.
- *
- *  @param fifo A pointer to a FIFO struct with data to be retrieved.
- *  @param dataPtr A pointer to a memory location to place the retrieved byte.
- *  @return bool - TRUE if data is successfully retrieved from the FIFO.
- *  @note Assumes that FIFO_Init has been called.
- */
-bool FIFO_Get(TFIFO *const fifo, uint8_t *const dataPtr)
+uint16_t FIFO_Get(TFIFO *const fifo, uint8_t data[], const uint16_t nbBytes)
 {
-  OS_SemaphoreWait(fifo->ItemsAvailable, 0); //Wait on items available
-  OS_SemaphoreWait(fifo->BufferAccess, 0);   //Wait on exclusive access
+  uint16_t tail = fifo->Tail;
+  uint16_t available = (uint16_t)(__atomic_load_n(&fifo->Head, __ATOMIC_ACQUIRE) - tail);
+  uint16_t nbGot = (nbBytes < available) ? nbBytes : available;
 
-  if (fifo->NbBytes == 0) // Can't get bytes from empty FIFO
+  for (uint16_t byteNb = 0; byteNb < nbGot; byteNb++)
+    data[byteNb] = fifo->Buffer[(uint16_t)(tail + byteNb) & FIFO_MASK];
+
+  // Hand the space back only once the bytes have been copied out
+  __atomic_store_n(&fifo->Tail, (uint16_t)(tail + nbGot), __ATOMIC_RELEASE);
+
+  if (nbGot > 0)
+    wake(&fifo->PutWaiting, fifo->SpaceAvailable);
+
+  return nbGot;
+}
+
+void FIFO_PutWait(TFIFO *const fifo, const uint8_t data[], const uint16_t nbBytes)
+{
+  uint16_t nbPut = FIFO_Put(fifo, data, nbBytes);
+
+  while (nbPut < nbBytes)
   {
-    return false;
+    // Say we are waiting, then look again in case the consumer made space before it could see the flag
+    fifo->PutWaiting = true;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (FIFO_NbBytes(fifo) == FIFO_SIZE)
+      OS_SemaphoreWait(fifo->SpaceAvailable, 0);
+
+    fifo->PutWaiting = false;
+    nbPut += FIFO_Put(fifo, &data[nbPut], nbBytes - nbPut);
   }
+}
+
+void FIFO_GetWait(TFIFO *const fifo, uint8_t data[], const uint16_t nbBytes)
+{
+  uint16_t nbGot = FIFO_Get(fifo, data, nbBytes);
+
+  while (nbGot < nbBytes)
+  {
+    // Say we are waiting, then look again in case the producer put bytes before it could see the flag
+    fifo->GetWaiting = true;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
 
-  *dataPtr = fifo->Buffer[fifo->Start];
-  fifo->Start = (fifo->Start + 1) % FIFO_SIZE; // Cycle to the end if we reached the beginning
-  fifo->NbBytes--;
+    if (FIFO_NbBytes(fifo) == 0)
+      OS_SemaphoreWait(fifo->ItemsAvailable, 0);
 
-  OS_SemaphoreSignal(fifo->BufferAccess);   //Signal no exclusive access taking place
-  OS_SemaphoreSignal(fifo->SpaceAvailable); //Signal space available in FIFO
-  return true;
+    fifo->GetWaiting = false;
+    nbGot += FIFO_Get(fifo, &data[nbGot], nbBytes - nbGot);
+  }
+}
+
+uint16_t FIFO_NbBytes(const TFIFO *const fifo)
+{
+  return (uint16_t)(fifo->Head - fifo->Tail);
 }
 
 /*!
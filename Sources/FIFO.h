@@ -15,21 +15,28 @@
 #include "types.h"
 #include "OS.h"
 
-// Number of bytes in a FIFO
+// Number of bytes in a FIFO, a power of two so the free-running indices wrap cleanly
 #define FIFO_SIZE 256
 
+#if (FIFO_SIZE & (FIFO_SIZE - 1)) != 0 || FIFO_SIZE > 32768
+#error "FIFO_SIZE must be a power of two no larger than 32768"
+#endif
+
 /*!
  * @struct TFIFO
+ *
+ * A single-producer, single-consumer ring buffer. The producer only writes Head and the
+ * consumer only writes Tail, so one side may be an ISR and the other a thread without locks.
  */
 typedef struct
 {
-  uint16_t Start;		/*!< The index of the position of the oldest data in the FIFO */
-  uint16_t End; 		/*!< The index of the next available empty position in the FIFO */
-  uint16_t volatile NbBytes;	/*!< The number of bytes currently stored in the FIFO */
+  uint16_t volatile Head;	/*!< Free-running count of bytes put, written by the producer only */
+  uint16_t volatile Tail;	/*!< Free-running count of bytes got, written by the consumer only */
   uint8_t Buffer[FIFO_SIZE];	/*!< The actual array of bytes to store the data */
-  OS_ECB *BufferAccess;		/*!< Semaphore to enforce exclusive access to FIFOs */
-  OS_ECB *SpaceAvailable;	/*!< Semaphore to enforce whether FIFO has space available to put */
-  OS_ECB *ItemsAvailable;	/*!< Semaphore to enforce whether FIFO has items available to get */
+  bool volatile PutWaiting;	/*!< TRUE while the producer is blocked in FIFO_PutWait */
+  bool volatile GetWaiting;	/*!< TRUE while the consumer is blocked in FIFO_GetWait */
+  OS_ECB *SpaceAvailable;	/*!< Signalled to wake a blocked producer once bytes have been got */
+  OS_ECB *ItemsAvailable;	/*!< Signalled to wake a blocked consumer once bytes have been put */
 } TFIFO;
 
 /*! @brief Initialize the FIFO before first use.
@@ -39,22 +46,49 @@ typedef struct
  */
 bool FIFO_Init(TFIFO * const fifo);
 
-/*! @brief Put one character into the FIFO.
+/*! @brief Put as many bytes as there is space for into the FIFO, without waiting.
+ *
+ *  @param fifo A pointer to a FIFO struct where data is to be stored.
+ *  @param data The bytes to store in the FIFO buffer.
+ *  @param nbBytes The number of bytes to store.
+ *  @return uint16_t - The number of bytes stored, which is less than nbBytes if the FIFO filled.
+ *  @note Assumes that FIFO_Init has been called. Only one context may put into a FIFO.
+ */
+uint16_t FIFO_Put(TFIFO * const fifo, const uint8_t data[], const uint16_t nbBytes);
+
+/*! @brief Get as many bytes as are available from the FIFO, without waiting.
+ *
+ *  @param fifo A pointer to a FIFO struct with data to be retrieved.
+ *  @param data A place to put the retrieved bytes.
+ *  @param nbBytes The largest number of bytes to retrieve.
+ *  @return uint16_t - The number of bytes retrieved, which is less than nbBytes if the FIFO emptied.
+ *  @note Assumes that FIFO_Init has been called. Only one context may get from a FIFO.
+ */
+uint16_t FIFO_Get(TFIFO * const fifo, uint8_t data[], const uint16_t nbBytes);
+
+/*! @brief Put bytes into the FIFO, waiting for space as needed.
  *
  *  @param fifo A pointer to a FIFO struct where data is to be stored.
- *  @param data A byte of data to store in the FIFO buffer.
- *  @return bool - TRUE if data is successfully stored in the FIFO.
- *  @note Assumes that FIFO_Init has been called.
+ *  @param data The bytes to store in the FIFO buffer.
+ *  @param nbBytes The number of bytes to store.
+ *  @note Assumes that FIFO_Init has been called. Call from a thread only.
  */
-bool FIFO_Put(TFIFO * const fifo, const uint8_t data);
+void FIFO_PutWait(TFIFO * const fifo, const uint8_t data[], const uint16_t nbBytes);
 
-/*! @brief Get one character from the FIFO.
+/*! @brief Get bytes from the FIFO, waiting for them to arrive as needed.
  *
  *  @param fifo A pointer to a FIFO struct with data to be retrieved.
- *  @param dataPtr A pointer to a memory location to place the retrieved byte.
- *  @return bool - TRUE if data is successfully retrieved from the FIFO.
- *  @note Assumes that FIFO_Init has been called.
+ *  @param data A place to put the retrieved bytes.
+ *  @param nbBytes The number of bytes to retrieve.
+ *  @note Assumes that FIFO_Init has been called. Call from a thread only.
+ */
+void FIFO_GetWait(TFIFO * const fifo, uint8_t data[], const uint16_t nbBytes);
+
+/*! @brief Gets the number of bytes in the FIFO.
+ *
+ *  @param fifo A pointer to the FIFO.
+ *  @return uint16_t - The number of bytes waiting to be got.
  */
-bool FIFO_Get(TFIFO * const fifo, uint8_t * const dataPtr);
+uint16_t FIFO_NbBytes(const TFIFO * const fifo);
 
 #endif
@@ -18,6 +18,11 @@ static uint32_t ModuleClock;
 static uint32_t PIT0_Period;
 static uint32_t PIT1_Period;
 
+// Free-running time base state
+static uint32_t LastCount;        // Channel 2 count at the last read
+static uint64_t ElapsedTime;      // Microseconds elapsed up to the last read
+static uint64_t ElapsedRemainder; // Part of a microsecond left over from the last read, in cycles * 1e6
+
 bool PIT_Init(const uint32_t moduleClk)
 {
   PIT0Semaphore = OS_SemaphoreCreate(0); // Create PIT Semaphore for Channel 0
@@ -31,6 +36,7 @@ bool PIT_Init(const uint32_t moduleClk)
   PIT_MCR |= PIT_MCR_FRZ_MASK;  // Timers are stopped in Debug Mode
 
   PIT_TCTRL0 |= PIT_TCTRL_TIE_MASK; // Enable PIT interrupts
+  PIT_TCTRL1 |= PIT_TCTRL_TIE_MASK; // Enable PIT interrupts
 
   NVICICPR2 = (1 << (68 % 32)); // Clear any pending interrupts on PIT Channel 0
   NVICISER2 = (1 << (68 % 32)); // Enable PIT Channel 0 interrupts
@@ -40,13 +46,18 @@ bool PIT_Init(const uint32_t moduleClk)
 
   PIT_MCR &= ~PIT_MCR_MDIS_MASK; // Enable PIT timer (0 to enable)
 
+  // Channel 2 free-runs over its full range without interrupts as the time base
+  PIT_LDVAL2 = PIT_LDVAL_TSV(0xFFFFFFFF);
+  PIT_TCTRL2 = PIT_TCTRL_TEN_MASK;
+  LastCount = PIT_CVAL2;
+
   return true;
 }
 
 void PIT_Set(uint8_t channelNb, const uint32_t period, const bool restart)
 {
-  uint32_t freqHz = 1e9 / period;
-  uint32_t cycleCount = ModuleClock / freqHz;
+  // Round to the nearest module clock cycle rather than to a whole number of hertz
+  uint32_t cycleCount = (uint32_t)(((uint64_t)period * ModuleClock + 500000000) / 1000000000);
   uint32_t triggerVal = cycleCount - 1;
 
   if (restart)
@@ -57,17 +68,55 @@ void PIT_Set(uint8_t channelNb, const uint32_t period, const bool restart)
   case 0:
     PIT0_Period = period;
     PIT_LDVAL0 = PIT_LDVAL_TSV(triggerVal);
+    PIT_TCTRL0 |= PIT_TCTRL_TIE_MASK; // Enable PIT interrupts
     break;
   case 1:
     PIT1_Period = period;
     PIT_LDVAL1 = PIT_LDVAL_TSV(triggerVal);
+    PIT_TCTRL1 |= PIT_TCTRL_TIE_MASK; // Enable PIT interrupts
     break;
   }
 
   if (restart)
     PIT_Enable(channelNb, true); // Re-Enable the timer
+}
 
-  PIT_TCTRL0 |= PIT_TCTRL_TIE_MASK; // Enable PIT interrupts
+void PIT_StartOneShot(uint8_t channelNb, const uint32_t delay)
+{
+  uint64_t cycleCount = ((uint64_t)delay * ModuleClock) / 1000000;
+
+  PIT_Enable(channelNb, false); // Disable the timer so the new value loads immediately
+
+  switch (channelNb)
+  {
+  case 0:
+    PIT_LDVAL0 = PIT_LDVAL_TSV(cycleCount ? cycleCount - 1 : 0);
+    PIT_TCTRL0 |= PIT_TCTRL_TIE_MASK;
+    break;
+  case 1:
+    PIT_LDVAL1 = PIT_LDVAL_TSV(cycleCount ? cycleCount - 1 : 0);
+    PIT_TCTRL1 |= PIT_TCTRL_TIE_MASK;
+    break;
+  }
+
+  PIT_Enable(channelNb, true);
+}
+
+uint64_t PIT_TimeGet(void)
+{
+  OS_DisableInterrupts();
+
+  // The channel counts down, so unsigned subtraction gives the cycles elapsed across a wrap
+  uint32_t count = PIT_CVAL2;
+  uint64_t elapsed = (uint64_t)(LastCount - count) * 1000000 + ElapsedRemainder;
+  LastCount = count;
+
+  ElapsedTime += elapsed / ModuleClock;
+  ElapsedRemainder = elapsed % ModuleClock;
+  uint64_t time = ElapsedTime;
+
+  OS_EnableInterrupts();
+  return time;
 }
 
 void PIT_Enable(uint8_t channelNb, const bool enable)
@@ -101,6 +150,7 @@ void __attribute__((interrupt)) PIT_ISR(void)
   if (PIT_TFLG1 & PIT_TFLG_TIF_MASK)
   {
     PIT_TFLG1 |= PIT_TFLG_TIF_MASK;    // Acknowledge interrupt
+    PIT_Enable(1, false);              // Channel 1 is only used as a one-shot
     OS_SemaphoreSignal(PIT1Semaphore); // Signal PIT1 Semaphore
   }
 
@@ -39,6 +39,22 @@ bool PIT_Init(const uint32_t moduleClk);
  */
 void PIT_Set(uint8_t channelNb, const uint32_t period, const bool restart);
 
+/*! @brief Starts a PIT channel as a one-shot timer.
+ *
+ *  The channel interrupts once after the delay and is then disabled.
+ *  @param channelNb the channel to be started
+ *  @param delay The delay in microseconds. Must be less than 2^32 module clock cycles.
+ */
+void PIT_StartOneShot(uint8_t channelNb, const uint32_t delay);
+
+/*! @brief Gets the time from the free-running PIT channel 2.
+ *
+ *  @return uint64_t - The time in microseconds.
+ *  @note The channel wraps every 2^32 module clock cycles, so it must be read at least that often
+ *        for the time to be continuous. Differences between reads made that often are exact.
+ */
+uint64_t PIT_TimeGet(void);
+
 /*! @brief Enables or disables the PIT.
  *
  *  @param channelNb the channel to be enabled
@@ -17,13 +17,62 @@
 #include "Cpu.h"
 #include "OS.h"
 #include "types.h"
+#include "profile.h"
+#include "packet.h"
+#include "txq.h"
 
-TFIFO TxFIFO, RxFIFO;
-OS_ECB *RxSem, *TxSem;
+// Wake the receiver once this many bytes are waiting, a whole packet
+#define RX_WAKE_NB_BYTES PACKET_NB_BYTES
+
+// DMAMUX request source of the UART2 transmitter, served by eDMA channel 0
+#define UART2_TX_DMA_SOURCE 7
+
+// Times a span is resumed after an eDMA error before the rest of it is dropped
+#define DMA_MAX_RETRIES 2
+
+static TFIFO RxFIFO;
+static OS_ECB *RxSem;
+static bool volatile RxWaiting; /*!< TRUE while the receiver is blocked in UART_InChar */
+
+// Time spent in the ISR, and the bytes it moved
+static uint64_t ISRCycles;
+static uint32_t ISRNbBytes;
+static uint32_t ISRMaxCycles;
+static const uint8_t *DMAData; /*!< First byte of the span the eDMA is sending */
+static uint16_t DMANbBytes;    /*!< Bytes in the span the eDMA is sending */
+static uint8_t DMARetries;     /*!< Times the span has been resumed after an error */
+static uint32_t DMAErrors;
+
+/*! @brief Programs eDMA channel 0 to send bytes to the UART, and starts it.
+ *
+ *  @param data The first byte to send.
+ *  @param nbBytes The number of bytes.
+ */
+static void programDMA(const uint8_t *data, uint16_t nbBytes)
+{
+  DMA_TCD0_SADDR = (uint32_t)data;
+  DMA_TCD0_CITER_ELINKNO = DMA_CITER_ELINKNO_CITER(nbBytes);
+  DMA_TCD0_BITER_ELINKNO = DMA_BITER_ELINKNO_BITER(nbBytes);
+  DMA_TCD0_CSR = DMA_CSR_DREQ_MASK | DMA_CSR_INTMAJOR_MASK; // Also clears DONE from the last span
+  DMA_SERQ = 0;                                             // Let the transmitter's requests through
+}
+
+/*! @brief Starts eDMA channel 0 sending a span of the transmit queue to the UART.
+ *
+ *  @param data The first byte of the span.
+ *  @param nbBytes The number of bytes in the span.
+ */
+static void startDMA(const uint8_t *data, uint16_t nbBytes)
+{
+  DMAData = data;
+  DMANbBytes = nbBytes;
+  DMARetries = 0;
+
+  programDMA(data, nbBytes);
+}
 
 bool UART_Init(const uint32_t baudRate, const uint32_t moduleClk)
 {
-  TxSem = OS_SemaphoreCreate(0);
   RxSem = OS_SemaphoreCreate(0);
 
   SIM_SCGC4 |= SIM_SCGC4_UART2_MASK; //Enabling UART2
@@ -47,78 +96,194 @@ bool UART_Init(const uint32_t baudRate, const uint32_t moduleClk)
   UART2_C2 |= UART_C2_RE_MASK; //Enabling the Receiver Enable bit
   UART2_C2 |= UART_C2_TE_MASK; //Enabling the Transmitter Enable bit
 
+  // eDMA channel 0 moves one byte from the transmit queue to the data register per request,
+  // then stops and interrupts at the end of the span
+  SIM_SCGC6 |= SIM_SCGC6_DMAMUX0_MASK;
+  SIM_SCGC7 |= SIM_SCGC7_DMA_MASK;
+  DMAMUX0_CHCFG0 = 0;
+  DMA_TCD0_SOFF = 1;
+  DMA_TCD0_ATTR = DMA_ATTR_SSIZE(0) | DMA_ATTR_DSIZE(0);
+  DMA_TCD0_NBYTES_MLNO = 1;
+  DMA_TCD0_SLAST = 0;
+  DMA_TCD0_DADDR = (uint32_t)&UART2_D;
+  DMA_TCD0_DOFF = 0;
+  DMA_TCD0_DLASTSGA = 0;
+  DMA_TCD0_CSR = DMA_CSR_DREQ_MASK | DMA_CSR_INTMAJOR_MASK;
+  DMAMUX0_CHCFG0 = DMAMUX_CHCFG_ENBL_MASK | DMAMUX_CHCFG_SOURCE(UART2_TX_DMA_SOURCE);
+
   //interrupts
-  UART2_C2 |= UART_C2_RIE_MASK; // Enable receive interrupt
-  UART2_C2 |= UART_C2_TIE_MASK; // Enable transmit interrupts
+  UART2_C5 |= UART_C5_TDMAS_MASK; // The transmitter requests eDMA rather than interrupting
+  UART2_C2 |= UART_C2_RIE_MASK;   // Enable receive interrupt
+  UART2_C2 |= UART_C2_ILIE_MASK;  // Enable idle line interrupt, to hand over a partial packet
+  UART2_C2 |= UART_C2_TIE_MASK;   // Enable transmit requests, ignored while the channel is stopped
 
   NVICICPR1 = (1 << (49 % 32)); // Clear any pending error status sources interrupts on UART2
   NVICISER1 = (1 << (49 % 32)); // Enable error status sources interrupts from UART2
 
+  NVICICPR0 = (1 << 0); // Clear any pending eDMA channel 0 interrupts
+  NVICISER0 = (1 << 0); // Enable eDMA channel 0 interrupts
+
+  DMA_SEEI = 0;          // Interrupt on a channel 0 configuration or bus error
+  NVICICPR0 = (1 << 16); // Clear any pending eDMA error interrupts
+  NVICISER0 = (1 << 16); // Enable eDMA error interrupts
+
   FIFO_Init(&RxFIFO); // Initializing the RxFIFO
-  FIFO_Init(&TxFIFO); // Initializing the TxFIFO
+  bool txqStatus = TxQ_Init(startDMA, PACKET_NB_BYTES);
 
-  return (setting.l != 0);
+  return (setting.l != 0) && txqStatus;
 }
 
 bool UART_InChar(uint8_t *const dataPtr)
 {
-  return FIFO_Get(&RxFIFO, dataPtr); //Gets a value from the Receive Buffer
+  while (FIFO_Get(&RxFIFO, dataPtr, 1) == 0) //Gets a value from the Receive Buffer
+    UART_InWait();
+
+  return true;
+}
+
+uint16_t UART_InChars(uint8_t data[], const uint16_t nbBytes)
+{
+  return FIFO_Get(&RxFIFO, data, nbBytes);
+}
+
+void UART_InWait(void)
+{
+  if (FIFO_NbBytes(&RxFIFO) > 0)
+    return;
+
+  // Say we are waiting, then look again in case a byte arrived before the ISR could see the flag
+  RxWaiting = true;
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  if (FIFO_NbBytes(&RxFIFO) == 0)
+    OS_SemaphoreWait(RxSem, 0);
+
+  RxWaiting = false;
 }
 
 bool UART_OutChar(const uint8_t data)
 {
-  OS_DisableInterrupts();
+  return UART_OutChars(&data, 1);
+}
 
-  UART2_C2 &= ~UART_C2_TIE_MASK;         //Disable the transmit interrupt
-  bool status = FIFO_Put(&TxFIFO, data); //Puts a value into the Transmit Buffer
-  UART2_C2 |= UART_C2_TIE_MASK;          //Enable the transmit interrupt
+bool UART_OutChars(const uint8_t data[], const uint8_t nbBytes)
+{
+  TxQ_Put(data, nbBytes); //Queues the values for the eDMA
+  return true;
+}
 
-  OS_EnableInterrupts();
-  return status;
+bool UART_OutUrgent(const uint8_t data[], const uint8_t nbBytes)
+{
+  return TxQ_PutUrgent(data, nbBytes); //Sends the values ahead of those queued
 }
 
-void RxThread()
+void UART_BeginBurst(void)
 {
-  for (;;)
-  {
-    OS_SemaphoreWait(RxSem, 0);
-    FIFO_Put(&RxFIFO, UART2_D);
+  TxQ_Begin();
+}
 
-    UART2_C2 |= UART_C2_RIE_MASK;
-  }
+void UART_EndBurst(void)
+{
+  TxQ_End();
 }
 
-void TxThread()
+uint32_t UART_DMAErrors(void)
 {
-  for (;;)
-  {
-    OS_SemaphoreWait(TxSem, 0);
-    FIFO_Get(&TxFIFO, &UART2_D);
+  return DMAErrors;
+}
 
-    UART2_C2 |= UART_C2_TIE_MASK;
-  }
+uint32_t UART_ISRMaxCycles(void)
+{
+  return ISRMaxCycles;
+}
+
+uint32_t UART_ISRCyclesPerByte(void)
+{
+  OS_DisableInterrupts();
+  uint64_t cycles = ISRCycles;
+  uint32_t nbBytes = ISRNbBytes;
+  OS_EnableInterrupts();
+
+  return nbBytes ? (uint32_t)(cycles / nbBytes) : 0;
 }
 
 void __attribute__((interrupt)) UART_ISR(void)
 {
   OS_ISREnter();
 
-  if (UART2_C2 & UART_C2_RIE_MASK)
+  uint32_t startCycles = Profile_Cycles();
+  uint8_t status = UART2_S1;
+
+  // Reading the data register after the status register clears both RDRF and IDLE
+  if (status & (UART_S1_RDRF_MASK | UART_S1_IDLE_MASK))
   {
-    if (UART2_S1 & UART_S1_RDRF_MASK)
+    uint8_t data = UART2_D;
+
+    if (status & UART_S1_RDRF_MASK)
+    {
+      FIFO_Put(&RxFIFO, &data, 1); // Dropped if the receiver has fallen a whole FIFO behind
+      ISRNbBytes++;
+    }
+
+    // Wake the receiver once a whole packet is waiting, or when the line goes quiet part way through one
+    if (RxWaiting && ((status & UART_S1_IDLE_MASK) || FIFO_NbBytes(&RxFIFO) >= RX_WAKE_NB_BYTES))
     {
+      RxWaiting = false;
       OS_SemaphoreSignal(RxSem);
-      UART2_C2 &= ~UART_C2_RIE_MASK;
     }
   }
 
-  if (UART2_C2 & UART_C2_TIE_MASK)
+  uint32_t cycles = Profile_Cycles() - startCycles;
+  ISRCycles += cycles;
+  if (cycles > ISRMaxCycles)
+    ISRMaxCycles = cycles;
+
+  OS_ISRExit();
+}
+
+void __attribute__((interrupt)) UART_DMAISR(void)
+{
+  OS_ISREnter();
+
+  uint32_t startCycles = Profile_Cycles();
+
+  DMA_CINT = 0; // Clear the channel 0 interrupt
+
+  // The whole span has gone, once per burst rather than once per byte
+  ISRNbBytes += DMANbBytes;
+  TxQ_Done();
+
+  uint32_t cycles = Profile_Cycles() - startCycles;
+  ISRCycles += cycles;
+  if (cycles > ISRMaxCycles)
+    ISRMaxCycles = cycles;
+
+  OS_ISRExit();
+}
+
+void __attribute__((interrupt)) UART_DMAErrorISR(void)
+{
+  OS_ISREnter();
+
+  DMA_CERQ = 0; // Stop the channel, so it can't run on from a bad descriptor
+  DMA_CERR = 0; // Clear the channel 0 error
+  DMAErrors++;
+
+  // The current iteration count is the number of bytes the span still had to go
+  uint16_t left = DMA_TCD0_CITER_ELINKNO & DMA_CITER_ELINKNO_CITER_MASK;
+  uint16_t sent = (left < DMANbBytes) ? DMANbBytes - left : 0;
+
+  if (sent < DMANbBytes && DMARetries < DMA_MAX_RETRIES)
   {
-    if (UART2_S1 & UART_S1_TDRE_MASK)
-    {
-      OS_SemaphoreSignal(TxSem);
-      UART2_C2 &= ~UART_C2_TIE_MASK;
-    }
+    // Carry on from the byte that failed
+    DMARetries++;
+    programDMA(DMAData + sent, DMANbBytes - sent);
+  }
+  else
+  {
+    // Drop the rest of the span rather than leave the queue waiting on it for ever
+    ISRNbBytes += sent;
+    TxQ_Done();
   }
 
   OS_ISRExit();
@@ -22,36 +22,105 @@
  */
 bool UART_Init(const uint32_t baudRate, const uint32_t moduleClk);
  
-/*! @brief Get a character from the receive FIFO if it is not empty.
+/*! @brief Get a character from the receive FIFO, waiting for one if it is empty.
  *
  *  @param dataPtr A pointer to memory to store the retrieved byte.
  *  @return bool - TRUE if the receive FIFO returned a character.
  *  @note Assumes that UART_Init has been called.
  */
 bool UART_InChar(uint8_t* const dataPtr);
- 
-/*! @brief Put a byte in the transmit FIFO if it is not full.
+
+/*! @brief Get as many bytes from the receive FIFO as are waiting, without waiting for more.
  *
- *  @param data The byte to be placed in the transmit FIFO.
- *  @return bool - TRUE if the data was placed in the transmit FIFO.
+ *  @param data A place to put the retrieved bytes.
+ *  @param nbBytes The most bytes to retrieve.
+ *  @return uint16_t - The number of bytes retrieved.
  *  @note Assumes that UART_Init has been called.
  */
+uint16_t UART_InChars(uint8_t data[], const uint16_t nbBytes);
+
+/*! @brief Waits until there are received bytes to get.
+ *
+ *  Returns at once if bytes are waiting, otherwise once a whole packet has arrived or the line has
+ *  gone idle.
+ *  @note Assumes that UART_Init has been called. Call from a single thread only.
+ */
+void UART_InWait(void);
+ 
+/*! @brief Queue a byte for the eDMA to send, waiting for space as needed.
+ *
+ *  @param data The byte to be sent.
+ *  @return bool - TRUE if the data was queued.
+ *  @note Assumes that UART_Init has been called. Only one thread may transmit.
+ */
 bool UART_OutChar(const uint8_t data);
 
-/*! @brief Thread to receive bytes into the FIFO
+/*! @brief Queue several bytes for the eDMA to send, waiting for space as needed.
  *
+ *  @param data The bytes to be sent.
+ *  @param nbBytes The number of bytes.
+ *  @return bool - TRUE if the data was queued.
+ *  @note Assumes that UART_Init has been called. Only one thread may transmit.
  */
-void RxThread();
+bool UART_OutChars(const uint8_t data[], const uint8_t nbBytes);
 
-/*! @brief Thread to send bytes using the FIFO
+/*! @brief Send several bytes ahead of those already queued, without waiting.
  *
+ *  @param data The whole packets to be sent.
+ *  @param nbBytes The number of bytes.
+ *  @return bool - TRUE if the data was queued, FALSE if earlier urgent data leaves no room.
+ *  @note Assumes that UART_Init has been called. May be called from any thread.
  */
-void TxThread();
+bool UART_OutUrgent(const uint8_t data[], const uint8_t nbBytes);
+
+/*! @brief Holds back the bytes queued from now on, so they go out in one eDMA transfer.
+ *
+ */
+void UART_BeginBurst(void);
+
+/*! @brief Hands the bytes queued since UART_BeginBurst to the eDMA.
+ *
+ */
+void UART_EndBurst(void);
+
+/*! @brief Gets the number of transmit eDMA errors.
+ *
+ *  @return uint32_t - The number of configuration or bus errors since UART_Init.
+ */
+uint32_t UART_DMAErrors(void);
+
+/*! @brief Gets the longest time spent in one run of the UART or transmit eDMA ISR.
+ *
+ *  @return uint32_t - The worst case ISR time in core clock cycles.
+ */
+uint32_t UART_ISRMaxCycles(void);
+
+/*! @brief Gets the average UART and transmit eDMA ISR time per byte received or sent.
+ *
+ *  @return uint32_t - The ISR time per byte in core clock cycles, 0 before any bytes have moved.
+ */
+uint32_t UART_ISRCyclesPerByte(void);
 
 /*! @brief Interrupt service routine for the UART.
  *
+ *  Moves received bytes straight into the FIFO, and wakes the receiver once a packet is buffered
+ *  or the line goes idle.
  *  @note Assumes the transmit and receive FIFOs have been initialized.
  */
 void __attribute__ ((interrupt)) UART_ISR(void);
 
+/*! @brief Interrupt service routine for the end of a transmit eDMA transfer.
+ *
+ *  @note Assumes the transmit queue has been initialized.
+ */
+void __attribute__ ((interrupt)) UART_DMAISR(void);
+
+/*! @brief Interrupt service routine for a transmit eDMA error.
+ *
+ *  Resumes the span from the byte that failed, up to twice, then drops the rest of it so the
+ *  transmit queue moves on.
+ *  @note Assumes the transmit queue has been initialized.
+ */
+void __attribute__ ((interrupt)) UART_DMAErrorISR(void);
+
 #endif
@@ -0,0 +1,212 @@
+/*! @file acq.c
+ *
+ *  @brief routines for acquiring samples in blocks
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup acq_module acq module documentation
+**  @{
+*/
+
+#include "acq.h"
+#include "PIT.h"
+#include "profile.h"
+#include "calib.h"
+
+// Two blocks, so one can be processed while the other is filled
+static TAcqBlock Blocks[2];
+
+static uint8_t FillIndex;           /*!< Block being filled by the producer */
+static uint8_t FillCount;           /*!< Samples already in the block being filled */
+static volatile uint32_t Completed; /*!< Blocks completed by the producer */
+static uint32_t Consumed;           /*!< Value of Completed at the last Acq_Get */
+static uint32_t Overruns;
+static uint32_t TornCopies;
+
+static int16_t PreviousSamples[ACQ_NB_INPUTS]; /*!< Last raw sample of each input, before alignment */
+static uint32_t PreviousStamps[ACQ_NB_INPUTS]; /*!< Cycle count each last raw sample was taken at */
+static int32_t Skews[ACQ_NB_INPUTS];           /*!< Last sampling delay of each input behind phase A in cycles */
+static bool Primed;                            /*!< TRUE once there is a previous sample to interpolate from */
+static uint32_t MinInterval;                   /*!< Shortest time between phase A samples in cycles */
+static uint32_t MaxInterval;                   /*!< Longest time between phase A samples in cycles */
+
+#if DSP_OVERSAMPLING_RATIO > 1
+static TCICDecimator Decimators[ACQ_NB_INPUTS];
+static uint8_t RawCount; /*!< Raw samples integrated since the last decimated sample */
+#endif
+
+bool Acq_Init(void)
+{
+  FillIndex = 0;
+  FillCount = 0;
+  Completed = 0;
+  Consumed = 0;
+  Overruns = 0;
+  TornCopies = 0;
+  Primed = false;
+  MinInterval = UINT32_MAX;
+  MaxInterval = 0;
+
+#if DSP_OVERSAMPLING_RATIO > 1
+  for (uint8_t inputNb = 0; inputNb < ACQ_NB_INPUTS; inputNb++)
+    Decimators[inputNb] = (TCICDecimator){{0}, {0}};
+  RawCount = 0;
+#endif
+
+  return true;
+}
+
+void Acq_Align(int16_t samples[ACQ_NB_INPUTS], const uint32_t stamps[ACQ_NB_INPUTS])
+{
+  for (uint8_t inputNb = 1; inputNb < ACQ_NB_INPUTS; inputNb++)
+  {
+    int16_t sample = samples[inputNb];
+    uint32_t interval = stamps[inputNb] - PreviousStamps[inputNb]; // Between this input's last two samples
+    uint32_t lead = stamps[0] - PreviousStamps[inputNb];           // From this input's last sample to phase A's
+
+    // Interpolate back along the straight line through this input's last two samples
+    if (Primed && lead < interval)
+    {
+      int32_t fraction = (int32_t)(((uint64_t)lead << 15) / interval); // Q15, at most 1.0
+      int32_t step = (int32_t)sample - PreviousSamples[inputNb];
+
+      // |step| < 2^16 and fraction <= 2^15, so the product fits in 32 bits
+      samples[inputNb] = (int16_t)(PreviousSamples[inputNb] + ((step * fraction + (1 << 14)) >> 15));
+    }
+
+    PreviousSamples[inputNb] = sample;
+    PreviousStamps[inputNb] = stamps[inputNb];
+    Skews[inputNb] = (int32_t)(stamps[inputNb] - stamps[0]);
+  }
+
+  // The spread of the sample periods bounds how far the sampling instants jitter
+  if (Primed)
+  {
+    uint32_t interval = stamps[0] - PreviousStamps[0];
+
+    if (interval < MinInterval)
+      MinInterval = interval;
+    if (interval > MaxInterval)
+      MaxInterval = interval;
+  }
+
+  PreviousStamps[0] = stamps[0];
+  Primed = true;
+}
+
+bool Acq_Sample(int16_t samples[ACQ_NB_INPUTS])
+{
+  uint32_t stamps[ACQ_NB_INPUTS];
+  int16_t raw[ANALOG_NB_INPUTS] = {0};
+  uint64_t time = PIT_TimeGet();
+
+  // Read every input back to back, noting the cycle each read started on
+  for (uint8_t inputNb = 0; inputNb < ACQ_NB_INPUTS; inputNb++)
+  {
+    stamps[inputNb] = Profile_Cycles();
+    Analog_Get(inputNb, &raw[inputNb]);
+  }
+
+  // Calibrate against the uncorrected samples, then correct each input's gain and offset
+  Calib_Capture(raw);
+
+  for (uint8_t inputNb = 0; inputNb < ACQ_NB_INPUTS; inputNb++)
+    samples[inputNb] = Calib_Correct(inputNb, raw[inputNb]);
+
+  // Bring the later inputs back to phase A's sampling instant
+  Acq_Align(samples, stamps);
+
+#if DSP_OVERSAMPLING_RATIO > 1
+  for (uint8_t inputNb = 0; inputNb < ACQ_NB_INPUTS; inputNb++)
+    DSP_CICIntegrate(&Decimators[inputNb], samples[inputNb]);
+
+  if (++RawCount < DSP_OVERSAMPLING_RATIO)
+    return false;
+
+  RawCount = 0;
+
+  int16_t decimated[ACQ_NB_INPUTS];
+  for (uint8_t inputNb = 0; inputNb < ACQ_NB_INPUTS; inputNb++)
+    decimated[inputNb] = DSP_CICDecimate(&Decimators[inputNb]);
+
+  return Acq_Put(decimated, time);
+#else
+  return Acq_Put(samples, time);
+#endif
+}
+
+bool Acq_Put(const int16_t samples[ACQ_NB_INPUTS], const uint64_t time)
+{
+  TAcqBlock *block = &Blocks[FillIndex];
+
+  for (uint8_t inputNb = 0; inputNb < ACQ_NB_INPUTS; inputNb++)
+    block->input[inputNb][FillCount] = samples[inputNb];
+
+  block->time[FillCount] = time;
+
+  if (++FillCount < ACQ_BLOCK_SIZE)
+    return false;
+
+  // Block complete, so hand it over and start filling the other one
+  FillCount = 0;
+  FillIndex ^= 1;
+
+  // The samples must be in the block before Acq_Get can see it is complete
+  __atomic_store_n(&Completed, Completed + 1, __ATOMIC_RELEASE);
+
+  return true;
+}
+
+bool Acq_Get(TAcqBlock *const block)
+{
+  for (;;)
+  {
+    uint32_t completed = __atomic_load_n(&Completed, __ATOMIC_ACQUIRE);
+
+    if (completed == Consumed)
+      return false;
+
+    // Block n (counting from 1) was filled in Blocks[(n - 1) % 2]
+    *block = Blocks[(completed - 1) & 1];
+
+    // The producer only refills this block after completing the next one, so if nothing has completed
+    // meanwhile the copy is whole
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (Completed == completed)
+    {
+      // Any blocks completed in between have already been overwritten
+      Overruns += completed - Consumed - 1;
+      Consumed = completed;
+      return true;
+    }
+
+    TornCopies++;
+  }
+}
+
+uint32_t Acq_Overruns(void)
+{
+  return Overruns;
+}
+
+uint32_t Acq_TornCopies(void)
+{
+  return TornCopies;
+}
+
+int32_t Acq_Skew(const uint8_t inputNb)
+{
+  return Skews[inputNb];
+}
+
+uint32_t Acq_Jitter(void)
+{
+  return (MaxInterval > MinInterval) ? MaxInterval - MinInterval : 0;
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,112 @@
+/*! @file
+ *
+ *  @brief Routines for acquiring samples of all inputs in blocks.
+ *
+ *  This contains the functions for collecting samples into double-buffered blocks, so the
+ *  processing can wake once per block rather than once per sample.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef ACQ_H
+#define ACQ_H
+
+// new types
+#include "types.h"
+#include "dsp.h"
+
+// Inputs acquired together: the three phases then the neutral
+#define ACQ_NB_INPUTS (DSP_NB_PHASES + 1)
+#define ACQ_NEUTRAL_INPUT DSP_NB_PHASES
+
+#if ACQ_NB_INPUTS > ANALOG_NB_INPUTS
+#error "More inputs than the ADC provides"
+#endif
+
+// Samples of each input per block; 1 processes every sample as it arrives
+#define ACQ_BLOCK_SIZE 4
+
+#if (ANALOG_WINDOW_SIZE % ACQ_BLOCK_SIZE) != 0
+#error "ACQ_BLOCK_SIZE must divide ANALOG_WINDOW_SIZE"
+#endif
+
+/*! @brief A block of consecutive samples of all inputs
+ *
+ */
+typedef struct
+{
+  int16_t input[ACQ_NB_INPUTS][ACQ_BLOCK_SIZE]; /*!< Samples of each input aligned to phase A, oldest first */
+  uint64_t time[ACQ_BLOCK_SIZE];                /*!< Time each sample was taken in microseconds; when oversampling, the
+                                                     time of the last raw sample decimated into it */
+} TAcqBlock;
+
+/*! @brief Sets up the block buffers before first use.
+ *
+ *  @return bool - TRUE if the buffers were successfully initialized.
+ */
+bool Acq_Init(void);
+
+/*! @brief Aligns the samples of the later inputs to the sampling instant of phase A.
+ *
+ *  Each of the later inputs is linearly interpolated between its previous sample and this one.
+ *  @param samples The raw sample of each input, replaced by the aligned samples.
+ *  @param stamps The cycle count each sample was taken at, from Profile_Cycles.
+ *  @note The first call after Acq_Init only records the samples.
+ */
+void Acq_Align(int16_t samples[ACQ_NB_INPUTS], const uint32_t stamps[ACQ_NB_INPUTS]);
+
+/*! @brief Reads every input from the ADC and adds the samples to the block being filled.
+ *
+ *  Each sample is corrected with its input's calibration as it is read. When oversampling, the
+ *  samples are decimated first, so only every DSP_OVERSAMPLING_RATIO-th call adds to the block.
+ *  @param samples Place to return the aligned sample of each input, for per-sample checks.
+ *  @return bool - TRUE if this sample completed a block.
+ *  @note Assumes that Analog_Init, PIT_Init and Calib_Init have been called.
+ */
+bool Acq_Sample(int16_t samples[ACQ_NB_INPUTS]);
+
+/*! @brief Adds one sample of every input to the block being filled.
+ *
+ *  @param samples The raw sample of each input.
+ *  @param time The time the samples were taken in microseconds.
+ *  @return bool - TRUE if this sample completed a block.
+ *  @note This is the producer side of the buffers, called from a single context only.
+ */
+bool Acq_Put(const int16_t samples[ACQ_NB_INPUTS], const uint64_t time);
+
+/*! @brief Copies out the most recently completed block.
+ *
+ *  The producer starts overwriting a block one block period after completing it, so the copy is
+ *  checked against the completion count, and taken again if the producer moved on part way through.
+ *  @param block Place to copy the block to.
+ *  @return bool - TRUE if a block has completed since the last call.
+ */
+bool Acq_Get(TAcqBlock *const block);
+
+/*! @brief Gets the number of completed blocks that were never consumed.
+ *
+ *  @return uint32_t - The number of blocks overwritten before Acq_Get was called.
+ */
+uint32_t Acq_Overruns(void);
+
+/*! @brief Gets the number of copies abandoned because the producer started overwriting the block.
+ *
+ *  @return uint32_t - The number of torn copies, each of which was taken again.
+ */
+uint32_t Acq_TornCopies(void);
+
+/*! @brief Gets how far an input was last sampled behind phase A.
+ *
+ *  @param inputNb The input.
+ *  @return int32_t - The delay in core clock cycles.
+ */
+int32_t Acq_Skew(const uint8_t inputNb);
+
+/*! @brief Gets the worst-case jitter of the sampling instants since Acq_Init.
+ *
+ *  @return uint32_t - The longest less the shortest time between phase A samples in cycles.
+ */
+uint32_t Acq_Jitter(void);
+
+#endif
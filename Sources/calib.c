@@ -0,0 +1,256 @@
+/*! @file calib.c
+ *
+ *  @brief routines for the per-input ADC gain and offset calibration
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup calib_module calib module documentation
+**  @{
+*/
+
+#include "calib.h"
+#include "dsp.h"
+#include "MK70F12.h"
+#include "OS.h"
+
+#include <math.h>
+
+// FTFE commands
+#define FTFE_PROGRAM_PHRASE 0x07
+#define FTFE_ERASE_SECTOR 0x09
+
+// The table is programmed a phrase of 8 bytes, two 4-byte entries, at a time
+#define PHRASE_SIZE 8
+#define ENTRIES_PER_PHRASE 2
+#define TABLE_SIZE (ANALOG_NB_INPUTS * sizeof(TCalibration))
+
+#if (ANALOG_NB_INPUTS % ENTRIES_PER_PHRASE) != 0
+#error "The calibration table must fill whole phrases"
+#endif
+
+// The stored table, read straight out of Flash
+#define STORED ((volatile const TCalibration *)CALIB_FLASH_START)
+
+static TCalibration Table[ANALOG_NB_INPUTS]; /*!< Coefficients in use, as stored */
+static int32_t Gains[ANALOG_NB_INPUTS];      /*!< Q14 gain of each input */
+static int32_t Biases[ANALOG_NB_INPUTS];     /*!< gain * offset in Q14, with the rounding half folded in */
+
+// Capture in progress; the sampler owns the accumulators while capturing
+static volatile CALIB_STATUS Status;
+static uint8_t CaptureInput;
+static uint32_t CaptureRemaining;
+static uint32_t CaptureLength;
+static int32_t CaptureSum;
+static uint64_t CaptureSumOfSquares;
+static float ReferenceCounts; /*!< Expected RMS of the injection in raw counts */
+static TCalibration Captured; /*!< Coefficients found by the last capture */
+
+/*! @brief Precomputes the fixed-point form of an input's coefficients.
+ *
+ *  @param inputNb The input.
+ *  @param calibration The stored coefficients, or erased Flash.
+ *  @note Does not mask interrupts, so call only while the sampler can't run, or through cache.
+ */
+static void load(const uint8_t inputNb, const TCalibration calibration)
+{
+  TCalibration valid = calibration;
+
+  if (valid.gain == 0xFFFF)
+    valid = (TCalibration){0, CALIB_GAIN_ONE};
+
+  Table[inputNb] = valid;
+  Gains[inputNb] = valid.gain;
+  Biases[inputNb] = (int32_t)valid.gain * valid.offset + (1 << (CALIB_GAIN_Q - 1));
+}
+
+/*! @brief Puts an input's coefficients into use while the sampler is running.
+ *
+ *  @param inputNb The input.
+ *  @param calibration The new coefficients.
+ */
+static void cache(const uint8_t inputNb, const TCalibration calibration)
+{
+  OS_DisableInterrupts();
+  load(inputNb, calibration);
+  OS_EnableInterrupts();
+}
+
+/*! @brief Runs one FTFE command and waits for it to finish.
+ *
+ *  @param command The command, with its address and data already in FCCOB1 onwards.
+ *  @return bool - TRUE if the command completed without an access or protection error.
+ */
+static bool launchCommand(const uint8_t command)
+{
+  FTFE_FSTAT = FTFE_FSTAT_ACCERR_MASK | FTFE_FSTAT_FPVIOL_MASK; // Clear any old errors
+  FTFE_FCCOB0 = command;
+  FTFE_FSTAT = FTFE_FSTAT_CCIF_MASK; // Launch
+
+  while (!(FTFE_FSTAT & FTFE_FSTAT_CCIF_MASK))
+    ;
+
+  return !(FTFE_FSTAT & (FTFE_FSTAT_ACCERR_MASK | FTFE_FSTAT_FPVIOL_MASK | FTFE_FSTAT_MGSTAT0_MASK));
+}
+
+/*! @brief Loads a Flash address into the FCCOB address registers.
+ *
+ *  @param address The Flash address.
+ */
+static void setAddress(const uint32_t address)
+{
+  while (!(FTFE_FSTAT & FTFE_FSTAT_CCIF_MASK))
+    ;
+
+  FTFE_FCCOB1 = (uint8_t)(address >> 16);
+  FTFE_FCCOB2 = (uint8_t)(address >> 8);
+  FTFE_FCCOB3 = (uint8_t)address;
+}
+
+/*! @brief Erases the calibration sector and programs the whole table into it.
+ *
+ *  @return bool - TRUE if the Flash was written successfully.
+ */
+static bool writeTable(void)
+{
+  TCalibration table[ANALOG_NB_INPUTS];
+
+  OS_DisableInterrupts();
+  for (uint8_t inputNb = 0; inputNb < ANALOG_NB_INPUTS; inputNb++)
+    table[inputNb] = Table[inputNb];
+  OS_EnableInterrupts();
+
+  const uint8_t *bytes = (const uint8_t *)table;
+
+  setAddress(CALIB_FLASH_START);
+  if (!launchCommand(FTFE_ERASE_SECTOR))
+    return false;
+
+  for (uint8_t phrase = 0; phrase < TABLE_SIZE / PHRASE_SIZE; phrase++)
+  {
+    const uint8_t *data = &bytes[phrase * PHRASE_SIZE];
+
+    setAddress(CALIB_FLASH_START + phrase * PHRASE_SIZE);
+
+    // Each word of the phrase is loaded most significant byte first
+    FTFE_FCCOB4 = data[3];
+    FTFE_FCCOB5 = data[2];
+    FTFE_FCCOB6 = data[1];
+    FTFE_FCCOB7 = data[0];
+    FTFE_FCCOB8 = data[7];
+    FTFE_FCCOB9 = data[6];
+    FTFE_FCCOBA = data[5];
+    FTFE_FCCOBB = data[4];
+
+    if (!launchCommand(FTFE_PROGRAM_PHRASE))
+      return false;
+  }
+
+  return true;
+}
+
+bool Calib_Init(void)
+{
+  Status = CALIB_IDLE;
+
+  // Called with interrupts already disabled, and the disable doesn't nest, so leave them alone
+  for (uint8_t inputNb = 0; inputNb < ANALOG_NB_INPUTS; inputNb++)
+    load(inputNb, STORED[inputNb]);
+
+  return true;
+}
+
+int16_t Calib_Correct(const uint8_t inputNb, const int16_t sample)
+{
+  int32_t corrected = (Gains[inputNb] * sample + Biases[inputNb]) >> CALIB_GAIN_Q;
+
+  if (corrected > INT16_MAX)
+    return INT16_MAX;
+  if (corrected < INT16_MIN)
+    return INT16_MIN;
+
+  return (int16_t)corrected;
+}
+
+void Calib_Capture(const int16_t samples[ANALOG_NB_INPUTS])
+{
+  if (Status != CALIB_CAPTURING)
+    return;
+
+  int16_t sample = samples[CaptureInput];
+  CaptureSum += sample;
+  CaptureSumOfSquares += (uint32_t)((int32_t)sample * sample);
+
+  if (--CaptureRemaining > 0)
+    return;
+
+  // The offset cancels the mean, and the gain scales what is left to the reference
+  float mean = (float)CaptureSum / CaptureLength;
+  float variance = (float)CaptureSumOfSquares / CaptureLength - mean * mean;
+  float gain = (variance > 0.0f) ? ReferenceCounts / sqrtf(variance) * CALIB_GAIN_ONE : 0.0f;
+
+  if (gain < CALIB_GAIN_MIN || gain > CALIB_GAIN_MAX)
+  {
+    Status = CALIB_FAILED;
+    return;
+  }
+
+  Captured.offset = (int16_t)lroundf(-mean);
+  Captured.gain = (uint16_t)lroundf(gain);
+  Status = CALIB_READY;
+}
+
+bool Calib_Start(const uint8_t inputNb, const uint8_t reference, const uint8_t nbCycles, const uint16_t samplesPerCycle)
+{
+  if (inputNb >= ANALOG_NB_INPUTS || reference == 0 || nbCycles == 0)
+    return false;
+
+  OS_DisableInterrupts();
+  CaptureInput = inputNb;
+  CaptureLength = (uint32_t)nbCycles * samplesPerCycle;
+  CaptureRemaining = CaptureLength;
+  CaptureSum = 0;
+  CaptureSumOfSquares = 0;
+  ReferenceCounts = reference * (float)(DSP_RAW_PER_AMP / 10.0);
+  Status = CALIB_CAPTURING;
+  OS_EnableInterrupts();
+
+  return true;
+}
+
+CALIB_STATUS Calib_Status(void)
+{
+  return Status;
+}
+
+bool Calib_Store(const uint8_t inputNb)
+{
+  if (Status != CALIB_READY || inputNb != CaptureInput)
+    return false;
+
+  cache(inputNb, Captured);
+  Status = CALIB_IDLE;
+
+  return writeTable();
+}
+
+bool Calib_Reset(const uint8_t inputNb)
+{
+  if (inputNb >= ANALOG_NB_INPUTS)
+    return false;
+
+  cache(inputNb, (TCalibration){0, CALIB_GAIN_ONE});
+
+  return writeTable();
+}
+
+TCalibration Calib_Get(const uint8_t inputNb)
+{
+  return Table[inputNb];
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,112 @@
+/*! @file
+ *
+ *  @brief Routines for the per-input ADC gain and offset calibration.
+ *
+ *  This contains the functions for correcting raw samples, capturing a reference injection to
+ *  calibrate an input against, and keeping the coefficients in their own Flash sector.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef CALIB_H
+#define CALIB_H
+
+// new types
+#include "types.h"
+
+// Fractional bits of the stored gain, so 1.0 is 2^CALIB_GAIN_Q
+#define CALIB_GAIN_Q 14
+#define CALIB_GAIN_ONE (1U << CALIB_GAIN_Q)
+
+// Gains a calibration may produce; anything further out means the injection was wrong
+#define CALIB_GAIN_MIN (CALIB_GAIN_ONE / 2)
+#define CALIB_GAIN_MAX (CALIB_GAIN_ONE * 2)
+
+// Start of the Flash sector holding the coefficients, clear of the one PMcL_Flash uses
+#define CALIB_FLASH_START 0x00081000LU
+
+/*! @brief Stored calibration of one input
+ *
+ *  The corrected sample is gain * (raw + offset).
+ */
+typedef struct
+{
+  int16_t offset; /*!< Offset added to the raw sample, in raw counts */
+  uint16_t gain;  /*!< Gain in Q2.14, erased Flash (0xFFFF) means uncalibrated */
+} TCalibration;
+
+/*! @brief State of a calibration capture
+ *
+ */
+typedef enum
+{
+  CALIB_IDLE = 0,      /*!< No capture started since the last store */
+  CALIB_CAPTURING = 1, /*!< Averaging the reference injection */
+  CALIB_READY = 2,     /*!< Coefficients found and waiting to be stored */
+  CALIB_FAILED = 3     /*!< The injection was too far from the reference to calibrate against */
+} CALIB_STATUS;
+
+/*! @brief Loads the coefficients from Flash into the RAM cache.
+ *
+ *  Inputs that have never been calibrated get unity gain and no offset.
+ *  @return bool - TRUE if the calibration was successfully initialized.
+ *  @note Call before sampling starts. Leaves the interrupt mask as it was.
+ */
+bool Calib_Init(void);
+
+/*! @brief Corrects a raw sample with its input's cached coefficients.
+ *
+ *  The cost is one multiply-add and a saturate.
+ *  @param inputNb The ADC input the sample was read from.
+ *  @param sample The raw sample.
+ *  @return int16_t - The corrected sample, saturated to 16 bits.
+ */
+int16_t Calib_Correct(const uint8_t inputNb, const int16_t sample);
+
+/*! @brief Adds a raw sample to the capture in progress.
+ *
+ *  @param samples The raw sample of every input, before correction.
+ *  @note Call at the raw sample rate. Returns at once when no capture is in progress.
+ */
+void Calib_Capture(const int16_t samples[ANALOG_NB_INPUTS]);
+
+/*! @brief Starts calibrating an input against a reference injection.
+ *
+ *  @param inputNb The ADC input the reference is injected into.
+ *  @param reference The RMS current injected, in 0.1 A.
+ *  @param nbCycles The number of cycles to average over.
+ *  @param samplesPerCycle The number of raw samples taken per cycle.
+ *  @return bool - TRUE if the capture was started.
+ */
+bool Calib_Start(const uint8_t inputNb, const uint8_t reference, const uint8_t nbCycles, const uint16_t samplesPerCycle);
+
+/*! @brief Gets the state of the latest capture.
+ *
+ *  @return CALIB_STATUS - The capture state.
+ */
+CALIB_STATUS Calib_Status(void);
+
+/*! @brief Puts the coefficients found by a capture into use and writes them to Flash.
+ *
+ *  @param inputNb The input the capture was made on.
+ *  @return bool - TRUE if a capture of that input was ready and the Flash was written successfully.
+ *  @note Erases the calibration sector, which takes some milliseconds, so call from a low priority thread.
+ */
+bool Calib_Store(const uint8_t inputNb);
+
+/*! @brief Returns an input to unity gain and no offset, and writes that to Flash.
+ *
+ *  @param inputNb The input to reset.
+ *  @return bool - TRUE if the Flash was written successfully.
+ */
+bool Calib_Reset(const uint8_t inputNb);
+
+/*! @brief Gets the coefficients in use on an input.
+ *
+ *  @param inputNb The input.
+ *  @return TCalibration - The offset and gain.
+ */
+TCalibration Calib_Get(const uint8_t inputNb);
+
+#endif
@@ -12,6 +12,15 @@
 */
 
 #include "cmd.h"
+#include "dsp.h"
+#include "profile.h"
+#include "acq.h"
+#include "freq.h"
+#include "seq.h"
+#include "calib.h"
+#include "UART.h"
+
+#include <math.h>
 
 static const uint16_t TowerNb = 0x25C4; //Last 4 digits of student number as hex, 9668 in hex is 0x25C4
 
@@ -29,9 +38,43 @@ uint16union_t *NumberOfTrips;
 
 TDORThreadData DORThreadData[3];
 
+// Harmonic content of each phase and the cycles taken to analyse them
+THarmonics PhaseHarmonics[3];
+uint32_t HarmonicsCycles;
+
 float Frequency;
 FAULT LastFault;
 
+// Fault-sensitive mode filters harmonics out of the pickup current
+bool SensitiveMode = false;
+
+// Instantaneous high-set current setting in 0.1 A, 0 disables it
+uint8_t HighSetCurrent = 0;
+
+// DC-removal filter time constant of each phase as a power of two samples, 0 disables the filter
+uint8_t DCFilterShift[3] = {0, 0, 0};
+
+// Calibration reference injection in 0.1 A RMS, and the number of cycles to average it over
+static uint8_t CalibrationReference = 50;
+static uint8_t CalibrationCycles = 50;
+
+// Symmetrical components of the phase currents, refreshed every cycle, and the cycles taken to find them
+TSequence Sequence;
+uint32_t SequenceCycles;
+
+// Negative sequence (46) and residual earth-fault pickup settings in 0.1 A, 0 disables them
+uint8_t NegativeSequencePickup = 0;
+uint8_t EarthFaultPickup = 0;
+
+// Earth-fault characteristic - 0:inverse, 1:very inverse, 2:extremely inverse
+uint8_t EarthFaultCharacteristic = Inverse;
+
+// The earth-fault element uses the measured neutral when set, otherwise the calculated residual
+bool EarthFaultMeasured = false;
+
+// Measured neutral RMS current, refreshed every cycle
+uint32_t NeutralCurrent;
+
 static uint8_t PacketCommand,
     PacketParameter1,
     PacketParameter2,
@@ -57,19 +100,162 @@ bool CMD_SendDORCurrentPacket()
   bool status = false;
   for (uint8_t phase = 0; phase < 3; phase++)
   {
-    if (!(status = Packet_Put(DORCurrent, phase, (uint8_t)DORThreadData[phase].iRMS, (DORThreadData[phase].iRMS - (uint8_t)DORThreadData[phase].iRMS) * 100)))
+    uint32_t iRMS = DORThreadData[phase].iRMS; // Q16.16 amps
+    if (!(status = Packet_Put(DORCurrent, phase, (uint8_t)(iRMS >> DSP_CURRENT_Q), ((iRMS & (DSP_CURRENT_ONE - 1)) * 100) >> DSP_CURRENT_Q)))
       break;
   }
   return status;
 }
 
+bool CMD_SendDORHarmonicsPacket()
+{
+  bool status = false;
+  for (uint8_t phase = 0; phase < 3; phase++)
+  {
+    // Index 0 is the THD, followed by each harmonic
+    for (uint8_t h = 0; h <= DSP_NB_HARMONICS; h++)
+    {
+      uint16union_t value;
+      value.l = (h == 0) ? PhaseHarmonics[phase].thd : PhaseHarmonics[phase].harmonic[h - 1];
+
+      if (!(status = Packet_Put(DORHarmonics, (phase << 4) | h, value.s.Lo, value.s.Hi)))
+        return status;
+    }
+  }
+  return status;
+}
+
+bool CMD_SendDORFrequencyPacket()
+{
+  TFreqSample history[FREQ_HISTORY_SIZE];
+  uint8_t count = Freq_History(history);
+  bool status = true;
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    // Frequency in mHz, then the time before the newest estimate in 0.1 ms
+    uint16union_t frequency, age;
+    uint64_t ageTenths = (history[count - 1].time - history[i].time) / 100;
+    frequency.l = (uint16_t)(history[i].frequency * 1000.0f + 0.5f);
+    age.l = (ageTenths > UINT16_MAX) ? UINT16_MAX : ageTenths;
+
+    if (!(status = Packet_Put(DORFrequency, i, frequency.s.Lo, frequency.s.Hi)))
+      return status;
+    if (!(status = Packet_Put(DORFrequency, i | 0x80, age.s.Lo, age.s.Hi)))
+      return status;
+  }
+  return status;
+}
+
+bool CMD_SendDORPhasorPacket()
+{
+  TDFTBin bins[3];
+
+  // Take all three bins from the same sample
+  OS_DisableInterrupts();
+  for (uint8_t phase = 0; phase < 3; phase++)
+    bins[phase] = DORThreadData[phase].fundamental;
+  OS_EnableInterrupts();
+
+  float reference = DSP_DFTAngle(&bins[0]);
+  bool status = false;
+
+  for (uint8_t phase = 0; phase < 3; phase++)
+  {
+    // Magnitude in 0.01 A RMS, then angle in 0.01 degrees from -180 to 180
+    uint32_t magnitude = DSP_RMSCurrent(DSP_DFTSumOfSquares(&bins[phase]));
+    uint32_t centiAmps = ((uint64_t)magnitude * 100 + DSP_CURRENT_ONE / 2) >> DSP_CURRENT_Q;
+    float angle = DSP_DFTAngle(&bins[phase]) - reference;
+    if (angle > 180.0f)
+      angle -= 360.0f;
+    else if (angle <= -180.0f)
+      angle += 360.0f;
+
+    uint16union_t amps;
+    int16union_t degrees;
+    amps.l = (centiAmps > UINT16_MAX) ? UINT16_MAX : centiAmps;
+    degrees.l = (int16_t)lroundf(angle * 100.0f);
+
+    if (!(status = Packet_Put(DORPhasor, phase, amps.s.Lo, amps.s.Hi)))
+      return status;
+    if (!(status = Packet_Put(DORPhasor, phase | 0x10, degrees.s.Lo, degrees.s.Hi)))
+      return status;
+  }
+  return status;
+}
+
+bool CMD_SendDORSequencePacket()
+{
+  // Zero, positive then negative sequence
+  uint32_t currents[3] = {Sequence.zeroCurrent, Sequence.positiveCurrent, Sequence.negativeCurrent};
+  bool status = false;
+
+  for (uint8_t component = 0; component < 3; component++)
+  {
+    uint32_t current = currents[component]; // Q16.16 amps
+    if (!(status = Packet_Put(DORSequence, component, (uint8_t)(current >> DSP_CURRENT_Q), ((current & (DSP_CURRENT_ONE - 1)) * 100) >> DSP_CURRENT_Q)))
+      break;
+  }
+  return status;
+}
+
+bool CMD_SendDORCalibrationPacket(const uint8_t inputNb)
+{
+  TCalibration calibration = Calib_Get(inputNb);
+  uint16union_t gain;
+  int16union_t offset;
+
+  gain.l = calibration.gain;
+  offset.l = calibration.offset;
+
+  return Packet_Put(DORCalibration, inputNb, gain.s.Lo, gain.s.Hi)
+      && Packet_Put(DORCalibration, inputNb | 0x10, offset.s.Lo, offset.s.Hi);
+}
+
+/*! @brief Fills in a packet to be sent.
+ *
+ *  @param packet The packet.
+ *  @param command The packet command.
+ *  @param parameter1 The first parameter.
+ *  @param parameter2 The second parameter.
+ *  @param parameter3 The third parameter.
+ */
+static void buildPacket(TPacket *packet, const uint8_t command, const uint8_t parameter1, const uint8_t parameter2, const uint8_t parameter3)
+{
+  packet->packetStruct.command = command;
+  packet->packetStruct.parameters.separate.parameter1 = parameter1;
+  packet->packetStruct.parameters.separate.parameter2 = parameter2;
+  packet->packetStruct.parameters.separate.parameter3 = parameter3;
+}
+
+bool CMD_SendDORTripPacket(const uint8_t faulted, const uint64_t tripTime, const uint32_t currents[3])
+{
+  TPacket packets[4];
+
+  // Faulted phases and elements with the trip time in 10 ms, then the current of each phase in 0.01 A
+  uint64_t centiSeconds = tripTime / 10000;
+  uint16union_t time;
+  time.l = (centiSeconds > UINT16_MAX) ? UINT16_MAX : centiSeconds;
+  buildPacket(&packets[0], DORTrip, 0x80 | faulted, time.s.Lo, time.s.Hi);
+
+  for (uint8_t phase = 0; phase < 3; phase++)
+  {
+    uint32_t centiAmps = ((uint64_t)currents[phase] * 100 + DSP_CURRENT_ONE / 2) >> DSP_CURRENT_Q;
+    uint16union_t amps;
+    amps.l = (centiAmps > UINT16_MAX) ? UINT16_MAX : centiAmps;
+    buildPacket(&packets[phase + 1], DORTrip, phase, amps.s.Lo, amps.s.Hi);
+  }
+
+  return Packet_PutUrgent(packets, 4);
+}
+
 bool CMD_SetFlashValues()
 {
   if (!PMcL_Flash_AllocateVar((void *)&RelayCharacteristic, sizeof(*RelayCharacteristic))) //Allocate the flash space for characteristic type
     return false;
   if (!PMcL_Flash_AllocateVar((void *)&NumberOfTrips, sizeof(*NumberOfTrips))) //Allocate the flash space for number of times tripped
     return false;
-  if (*RelayCharacteristic == 0xFFFF)          //If flash is empty, use default value
+  if (*RelayCharacteristic == 0xFF)            //If flash is empty, use default value
     PMcL_Flash_Write8(RelayCharacteristic, 0); // Inverse characteristic
 
   if (!PMcL_Flash_AllocateVar((volatile void **)&NvTowerNb, sizeof(*NvTowerNb))) //Allocate the flash space for tower number
@@ -172,6 +358,219 @@ bool CMD_HandleDORPacket()
       return Packet_Put(DOR, 4, LastFault, 0);
     else
       return false;
+  case 5:
+    // 500 get sensitive mode
+    if (Packet_Parameter23 == 0x00)
+      return Packet_Put(DOR, 5, SensitiveMode, 0);
+    // 51[0-1] set sensitive mode
+    else if (Packet_Parameter2 == 1 && Packet_Parameter3 <= 1)
+    {
+      SensitiveMode = Packet_Parameter3;
+      return true;
+    }
+    else
+      return false;
+  case 6:
+    // 600 get THD and harmonics of every phase, up to DSP_NB_HARMONICS (the 7th with a 16 sample window)
+    if (Packet_Parameter23 == 0x00)
+      return CMD_SendDORHarmonicsPacket();
+    // 610 get cycles taken by the last harmonic analysis
+    else if (Packet_Parameter2 == 1 && Packet_Parameter3 == 0)
+    {
+      uint16union_t cycles;
+      cycles.l = (HarmonicsCycles > UINT16_MAX) ? UINT16_MAX : HarmonicsCycles;
+      return Packet_Put(DOR, 6, cycles.s.Lo, cycles.s.Hi);
+    }
+    else
+      return false;
+  case 7:
+    // 700 get high-set current in 0.1 A
+    if (Packet_Parameter23 == 0x00)
+      return Packet_Put(DOR, 7, HighSetCurrent, 0);
+    // 71x set high-set current to x * 0.1 A, 0 to disable, no higher than the ADC can measure
+    else if (Packet_Parameter2 == 1 && Packet_Parameter3 <= DSP_MAX_CURRENT * 10)
+    {
+      HighSetCurrent = Packet_Parameter3;
+      return true;
+    }
+    else
+      return false;
+  case 8:
+  {
+    // 85x get the last sampling delay of input x behind phase A in cycles, signed, clamped to 16 bits
+    if (Packet_Parameter2 == 5 && Packet_Parameter3 < ACQ_NB_INPUTS)
+    {
+      int32_t skew = Acq_Skew(Packet_Parameter3);
+      int16union_t reply;
+      reply.l = (skew > INT16_MAX) ? INT16_MAX : (skew < INT16_MIN) ? INT16_MIN : (int16_t)skew;
+      return Packet_Put(DOR, 8, reply.s.Lo, reply.s.Hi);
+    }
+
+    // 800 get wakeups per second, 810 get cycles of the last DSP pass, 820 get worst case pass cycles
+    uint32_t value;
+    if (Packet_Parameter23 == 0x00)
+      value = Profile_WakeupsPerSecond();
+    else if (Packet_Parameter2 == 1 && Packet_Parameter3 == 0)
+      value = Profile_LastPassCycles();
+    else if (Packet_Parameter2 == 2 && Packet_Parameter3 == 0)
+      value = Profile_MaxPassCycles();
+    // 830 get sample blocks overwritten before they were processed
+    else if (Packet_Parameter2 == 3 && Packet_Parameter3 == 0)
+      value = Acq_Overruns();
+    // 840 get CPU load of the signal path in 0.01%
+    else if (Packet_Parameter2 == 4 && Packet_Parameter3 == 0)
+      value = Profile_Load();
+    // 860 get the worst case UART ISR cycles, 870 get the average UART ISR cycles per byte
+    else if (Packet_Parameter2 == 6 && Packet_Parameter3 == 0)
+      value = UART_ISRMaxCycles();
+    else if (Packet_Parameter2 == 7 && Packet_Parameter3 == 0)
+      value = UART_ISRCyclesPerByte();
+    // 880 get sample block copies taken again because the sampler overwrote them part way through
+    else if (Packet_Parameter2 == 8 && Packet_Parameter3 == 0)
+      value = Acq_TornCopies();
+    // 890 get transmit eDMA errors
+    else if (Packet_Parameter2 == 9 && Packet_Parameter3 == 0)
+      value = UART_DMAErrors();
+    // 8A0 get the worst-case jitter of the sampling instants in cycles
+    else if (Packet_Parameter2 == 0x0A && Packet_Parameter3 == 0)
+      value = Acq_Jitter();
+    else
+      return false;
+
+    uint16union_t reply;
+    reply.l = (value > UINT16_MAX) ? UINT16_MAX : value;
+    return Packet_Put(DOR, 8, reply.s.Lo, reply.s.Hi);
+  }
+  case 9:
+    // 900 get the frequency history
+    if (Packet_Parameter23 == 0x00)
+      return CMD_SendDORFrequencyPacket();
+    // 910 get ROCOF in mHz/s
+    else if (Packet_Parameter2 == 1 && Packet_Parameter3 == 0)
+    {
+      float rocof = Freq_ROCOF() * 1000.0f;
+      int16union_t value;
+      value.l = (rocof > INT16_MAX) ? INT16_MAX : (rocof < INT16_MIN) ? INT16_MIN : (int16_t)rocof;
+      return Packet_Put(DOR, 9, value.s.Lo, value.s.Hi);
+    }
+    // 92x set the ROCOF window to x estimates
+    else if (Packet_Parameter2 == 2)
+      return Freq_SetROCOFWindow(Packet_Parameter3);
+    else
+      return false;
+  case 10:
+    // A00 get the phasor of every phase
+    if (Packet_Parameter23 == 0x00)
+      return CMD_SendDORPhasorPacket();
+    else
+      return false;
+  case 11:
+    // B00 get the sequence currents
+    if (Packet_Parameter23 == 0x00)
+      return CMD_SendDORSequencePacket();
+    // B10 get cycles taken by the last sequence calculation
+    else if (Packet_Parameter2 == 1 && Packet_Parameter3 == 0)
+    {
+      uint16union_t cycles;
+      cycles.l = (SequenceCycles > UINT16_MAX) ? UINT16_MAX : SequenceCycles;
+      return Packet_Put(DOR, 11, cycles.s.Lo, cycles.s.Hi);
+    }
+    else
+      return false;
+  case 12:
+    // C00 get negative sequence pickup
+    if (Packet_Parameter23 == 0x00)
+      return Packet_Put(DOR, 12, NegativeSequencePickup, 0);
+    // C1x set negative sequence pickup in 0.1 A, 0 to disable
+    else if (Packet_Parameter2 == 1)
+    {
+      NegativeSequencePickup = Packet_Parameter3;
+      return true;
+    }
+    else
+      return false;
+  case 13:
+    // D00 get earth-fault pickup
+    if (Packet_Parameter23 == 0x00)
+      return Packet_Put(DOR, 13, EarthFaultPickup, 0);
+    // D1x set earth-fault pickup in 0.1 A, 0 to disable
+    else if (Packet_Parameter2 == 1)
+    {
+      EarthFaultPickup = Packet_Parameter3;
+      return true;
+    }
+    // D20 get earth-fault source
+    else if (Packet_Parameter2 == 2 && Packet_Parameter3 == 0)
+      return Packet_Put(DOR, 13, EarthFaultMeasured, 0);
+    // D3x set earth-fault source, 0 for the calculated residual or 1 for the measured neutral
+    else if (Packet_Parameter2 == 3 && Packet_Parameter3 <= 1)
+    {
+      EarthFaultMeasured = Packet_Parameter3;
+      return true;
+    }
+    // D40 get earth-fault characteristic
+    else if (Packet_Parameter2 == 4 && Packet_Parameter3 == 0)
+      return Packet_Put(DOR, 13, EarthFaultCharacteristic, 0);
+    // D5x set earth-fault characteristic
+    else if (Packet_Parameter2 == 5 && Packet_Parameter3 <= ExtremelyInverse)
+    {
+      EarthFaultCharacteristic = Packet_Parameter3;
+      return true;
+    }
+    // D60 get the measured neutral current
+    else if (Packet_Parameter2 == 6 && Packet_Parameter3 == 0)
+      return Packet_Put(DOR, 13, (uint8_t)(NeutralCurrent >> DSP_CURRENT_Q), ((NeutralCurrent & (DSP_CURRENT_ONE - 1)) * 100) >> DSP_CURRENT_Q);
+    else
+      return false;
+  case 14:
+    // E0x get the DC-removal filter time constant of phase x
+    if (Packet_Parameter2 == 0 && Packet_Parameter3 < DSP_NB_PHASES)
+      return Packet_Put(DOR, 14, DCFilterShift[Packet_Parameter3], 0);
+    // E1x get the unfiltered RMS current of phase x
+    else if (Packet_Parameter2 == 1 && Packet_Parameter3 < DSP_NB_PHASES)
+    {
+      uint32_t rawRMS = DSP_RMSCurrent(DORThreadData[Packet_Parameter3].rawSumOfSquares);
+      return Packet_Put(DOR, 14, (uint8_t)(rawRMS >> DSP_CURRENT_Q), ((rawRMS & (DSP_CURRENT_ONE - 1)) * 100) >> DSP_CURRENT_Q);
+    }
+    // E(2+x)y set the DC-removal filter time constant of phase x to 2^y samples, 0 to disable
+    else if (Packet_Parameter2 >= 2 && Packet_Parameter2 < 2 + DSP_NB_PHASES
+             && (Packet_Parameter3 == 0 || (Packet_Parameter3 >= DSP_DC_FILTER_SHIFT_MIN && Packet_Parameter3 <= DSP_DC_FILTER_SHIFT_MAX)))
+    {
+      DCFilterShift[Packet_Parameter2 - 2] = Packet_Parameter3;
+      return true;
+    }
+    else
+      return false;
+  case 15:
+    // F0x get the gain (Q2.14) and offset of ADC input x
+    if (Packet_Parameter2 == 0 && Packet_Parameter3 < ANALOG_NB_INPUTS)
+      return CMD_SendDORCalibrationPacket(Packet_Parameter3);
+    // F1x set the calibration reference injection to x * 0.1 A RMS
+    else if (Packet_Parameter2 == 1 && Packet_Parameter3 > 0)
+    {
+      CalibrationReference = Packet_Parameter3;
+      return true;
+    }
+    // F2x set the number of cycles to average the reference over
+    else if (Packet_Parameter2 == 2 && Packet_Parameter3 > 0)
+    {
+      CalibrationCycles = Packet_Parameter3;
+      return true;
+    }
+    // F3x start averaging the reference injected into input x
+    else if (Packet_Parameter2 == 3)
+      return Calib_Start(Packet_Parameter3, CalibrationReference, CalibrationCycles, DSP_RAW_WINDOW_SIZE);
+    // F40 get the calibration status - 0:idle, 1:capturing, 2:ready to store, 3:failed
+    else if (Packet_Parameter2 == 4 && Packet_Parameter3 == 0)
+      return Packet_Put(DOR, 15, Calib_Status(), 0);
+    // F5x put the calibration of input x into use and store it
+    else if (Packet_Parameter2 == 5)
+      return Calib_Store(Packet_Parameter3) && CMD_SendDORCalibrationPacket(Packet_Parameter3);
+    // F6x return input x to the nominal scaling and store it
+    else if (Packet_Parameter2 == 6)
+      return Calib_Reset(Packet_Parameter3) && CMD_SendDORCalibrationPacket(Packet_Parameter3);
+    else
+      return false;
   default:
     return false;
   }
@@ -181,6 +580,9 @@ bool CMD_PacketHandle()
 {
   bool success = false;
 
+  // Send the whole response, however many packets, as one transfer
+  Packet_BeginBurst();
+
   switch (Packet_Command & ~PACKET_ACK_MASK)
   {
   case Startup:
@@ -212,6 +614,8 @@ bool CMD_PacketHandle()
       Packet_Put(Packet_Command & ~PACKET_ACK_MASK, Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
   }
 
+  Packet_EndBurst();
+
   return success;
 }
 
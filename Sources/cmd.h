@@ -12,7 +12,13 @@ static enum Command {
   Version = 0x09,
   Number = 0x0B,
   DOR = 0x70,
-  DORCurrent = 0x71
+  DORCurrent = 0x71,
+  DORHarmonics = 0x72,
+  DORFrequency = 0x73,
+  DORPhasor = 0x74,
+  DORSequence = 0x75,
+  DORCalibration = 0x76,
+  DORTrip = 0x77
 } Command;
 
 /*! @brief initialises the flash values
@@ -45,6 +51,53 @@ bool CMD_SendNumberPacket();
  */
 bool CMD_SendDORCurrentPacket();
 
+/*! @brief sends the THD and harmonic magnitudes of every phase to the PC
+ *
+ *  Each value is a DORHarmonics packet: parameter 1 is the phase in the high nibble and the index in
+ *  the low nibble, parameters 2 and 3 the value in 0.01%, low byte first. Index 0 is the THD, and
+ *  index h the magnitude of harmonic h relative to the fundamental, index 1. Indices run up to
+ *  DSP_NB_HARMONICS, which is 7 with a 16 sample window, the harmonics above being past the Nyquist
+ *  frequency.
+ *  @return bool - TRUE if the packets were successfully sent
+ */
+bool CMD_SendDORHarmonicsPacket();
+
+/*! @brief sends the frequency history to the PC, each estimate followed by its age
+ *
+ *  @return bool - TRUE if the packets were successfully sent
+ */
+bool CMD_SendDORFrequencyPacket();
+
+/*! @brief sends the fundamental phasor of every phase to the PC, angles relative to phase A
+ *
+ *  @return bool - TRUE if the packets were successfully sent
+ */
+bool CMD_SendDORPhasorPacket();
+
+/*! @brief sends the zero, positive and negative sequence currents to the PC
+ *
+ *  @return bool - TRUE if the packets were successfully sent
+ */
+bool CMD_SendDORSequencePacket();
+
+/*! @brief sends the gain and offset in use on an input to the PC
+ *
+ *  @param inputNb - the ADC input
+ *  @return bool - TRUE if the packets were successfully sent
+ */
+bool CMD_SendDORCalibrationPacket(const uint8_t inputNb);
+
+/*! @brief pushes a trip event to the PC ahead of any replies already queued
+ *
+ *  @param faulted - the tripped phases in bits 0 to 2, the negative sequence element in bit 3 and
+ *                   the earth-fault element in bit 4
+ *  @param tripTime - the time from pickup to trip in microseconds
+ *  @param currents - the RMS current of each phase at the trip, in Q16.16 amps
+ *  @return bool - TRUE if the packets were successfully queued, FALSE if there was no room yet
+ *  @note may be called from any thread
+ */
+bool CMD_SendDORTripPacket(const uint8_t faulted, const uint64_t tripTime, const uint32_t currents[3]);
+
 /*! @brief checks the parameters and then sends the startup values
  *
  *  @return bool - TRUE if the packet was successfully handled and parameters were correct
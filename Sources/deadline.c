@@ -0,0 +1,107 @@
+/*! @file deadline.c
+ *
+ *  @brief routines for scheduling trip deadlines on a one-shot PIT
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup deadline_module deadline module documentation
+**  @{
+*/
+
+#include "deadline.h"
+#include "PIT.h"
+#include "OS.h"
+
+// Timer channel used for the wakeups
+#define DEADLINE_PIT_CHANNEL 1
+
+// Longest single wakeup in microseconds, so the one-shot count and the time base cannot wrap
+#define DEADLINE_MAX_DELAY 60000000
+
+static uint64_t Deadlines[DEADLINE_NB_CHANNELS];
+static uint8_t ActiveChannels; // Bit mask of channels holding a deadline
+
+/*! @brief Programs the one-shot timer for the earliest deadline, or stops it if there are none.
+ *
+ *  @param now The current time in microseconds.
+ *  @note Assumes interrupts are disabled.
+ */
+static void Reschedule(const uint64_t now)
+{
+  if (ActiveChannels == 0)
+  {
+    PIT_Enable(DEADLINE_PIT_CHANNEL, false); // Nothing to wait for, so no wakeups
+    return;
+  }
+
+  // There are only a handful of channels, so a scan is cheaper than keeping a heap
+  uint64_t earliest = UINT64_MAX;
+  for (uint8_t channelNb = 0; channelNb < DEADLINE_NB_CHANNELS; channelNb++)
+  {
+    if ((ActiveChannels & (1 << channelNb)) && Deadlines[channelNb] < earliest)
+      earliest = Deadlines[channelNb];
+  }
+
+  uint64_t delay = (earliest > now) ? earliest - now : 1;
+  if (delay > DEADLINE_MAX_DELAY)
+    delay = DEADLINE_MAX_DELAY; // Wake early and reschedule for the remainder
+
+  PIT_StartOneShot(DEADLINE_PIT_CHANNEL, (uint32_t)delay);
+}
+
+bool Deadline_Init(void)
+{
+  ActiveChannels = 0;
+  PIT_Enable(DEADLINE_PIT_CHANNEL, false);
+  return true;
+}
+
+void Deadline_Set(const uint8_t channelNb, const uint64_t deadline)
+{
+  uint64_t now = PIT_TimeGet();
+
+  OS_DisableInterrupts();
+  Deadlines[channelNb] = deadline;
+  ActiveChannels |= (1 << channelNb);
+  Reschedule(now);
+  OS_EnableInterrupts();
+}
+
+void Deadline_Cancel(const uint8_t channelNb)
+{
+  uint64_t now = PIT_TimeGet();
+
+  OS_DisableInterrupts();
+  if (ActiveChannels & (1 << channelNb))
+  {
+    ActiveChannels &= ~(1 << channelNb);
+    Reschedule(now);
+  }
+  OS_EnableInterrupts();
+}
+
+uint8_t Deadline_Expired(void)
+{
+  uint8_t expired = 0;
+  uint64_t now = PIT_TimeGet();
+
+  OS_DisableInterrupts();
+  for (uint8_t channelNb = 0; channelNb < DEADLINE_NB_CHANNELS; channelNb++)
+  {
+    if ((ActiveChannels & (1 << channelNb)) && Deadlines[channelNb] <= now)
+      expired |= (1 << channelNb);
+  }
+
+  ActiveChannels &= ~expired;
+  Reschedule(now);
+  OS_EnableInterrupts();
+
+  return expired;
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,48 @@
+/*! @file
+ *
+ *  @brief Routines for scheduling per-channel trip deadlines.
+ *
+ *  This contains the functions for keeping an absolute deadline for each channel and waking
+ *  once, from a one-shot PIT, when the earliest of them expires.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+// new types
+#include "types.h"
+
+// Number of channels that can hold a deadline
+#define DEADLINE_NB_CHANNELS 8
+
+/*! @brief Sets up the deadline scheduler before first use.
+ *
+ *  @return bool - TRUE if the scheduler was successfully initialized.
+ *  @note Assumes that PIT_Init has been called.
+ */
+bool Deadline_Init(void);
+
+/*! @brief Sets or moves the deadline of a channel.
+ *
+ *  @param channelNb The channel the deadline belongs to.
+ *  @param deadline The absolute deadline in microseconds, on the PIT_TimeGet time base.
+ */
+void Deadline_Set(const uint8_t channelNb, const uint64_t deadline);
+
+/*! @brief Cancels the deadline of a channel, if it has one.
+ *
+ *  @param channelNb The channel the deadline belongs to.
+ */
+void Deadline_Cancel(const uint8_t channelNb);
+
+/*! @brief Collects the deadlines that have expired and schedules the next wakeup.
+ *
+ *  Expired deadlines are cancelled. Call this each time PIT1 signals.
+ *  @return uint8_t - A bit mask of the channels whose deadlines expired.
+ */
+uint8_t Deadline_Expired(void);
+
+#endif
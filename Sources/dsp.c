@@ -0,0 +1,268 @@
+/*! @file dsp.c
+ *
+ *  @brief Fixed-point routines for processing the analog samples
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup dsp_module DSP module documentation
+**  @{
+*/
+
+#include "dsp.h"
+
+#include <math.h>
+
+// Table step for one sample of the window
+#define WINDOW_STEP (DSP_COS_TABLE_SIZE / ANALOG_WINDOW_SIZE)
+
+// sin(x) is cos(x - pi/2)
+#define SIN_TABLE(index) DSP_CosTable[((index) - DSP_COS_TABLE_SIZE / 4) & (DSP_COS_TABLE_SIZE - 1)]
+
+// Rounds a Q15 product back to an integer
+#define Q15_ROUND(product) (((product) + (1 << 14)) >> 15)
+
+// Reciprocal of DSP_SAMPLE_PER_AMP in Q32, used to turn a Q16 raw RMS into Q16 amps
+static const uint64_t RMS_TO_CURRENT_Q32 = (uint64_t)(4294967296.0 / DSP_SAMPLE_PER_AMP);
+
+uint32_t DSP_SquareRoot(uint64_t value)
+{
+  uint64_t root = 0;
+  uint64_t bit = 1ULL << 62; // Highest power of four that fits
+
+  while (bit > value)
+    bit >>= 2;
+
+  // Digit-by-digit method, one result bit per iteration
+  while (bit != 0)
+  {
+    if (value >= root + bit)
+    {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+      root >>= 1;
+    bit >>= 2;
+  }
+
+  return (uint32_t)root;
+}
+
+uint32_t DSP_RMSCurrent(const uint64_t sumOfSquares)
+{
+  // The mean square of a 16-bit signal is below 2^30, so the Q32 mean square fits in 64 bits
+  uint64_t meanSquare = sumOfSquares / ANALOG_WINDOW_SIZE;
+  uint64_t rawRMS = DSP_SquareRoot(meanSquare << (2 * DSP_CURRENT_Q)); // Raw RMS in Q16
+
+  return (uint32_t)((rawRMS * RMS_TO_CURRENT_Q32) >> 32);
+}
+
+void DSP_DFTUpdate(TDFTBin * const bin, const int16_t newSample, const int16_t oldSample, const uint8_t position)
+{
+  uint8_t index = position * WINDOW_STEP;
+  int32_t cos = DSP_CosTable[index];
+  int32_t sin = SIN_TABLE(index);
+
+  // X = sum of x[m] * e^(-j * 2 * pi * m / N), rounding each term the same way it was added
+  bin->re += Q15_ROUND(newSample * cos) - Q15_ROUND(oldSample * cos);
+  bin->im -= Q15_ROUND(newSample * sin) - Q15_ROUND(oldSample * sin);
+}
+
+uint64_t DSP_DFTSumOfSquares(const TDFTBin * const bin)
+{
+  // A sinusoid of amplitude A gives |X| = N * A / 2, and its window sum of squares is N * A^2 / 2 = 2 * |X|^2 / N
+  int64_t magnitudeSquared = (int64_t)bin->re * bin->re + (int64_t)bin->im * bin->im;
+
+  return (uint64_t)(2 * magnitudeSquared) / ANALOG_WINDOW_SIZE;
+}
+
+void DSP_FFT(int32_t re[DSP_FFT_SIZE], int32_t im[DSP_FFT_SIZE])
+{
+  // Reorder into bit-reversed index order
+  for (uint8_t i = 1, j = 0; i < DSP_FFT_SIZE; i++)
+  {
+    uint8_t bit = DSP_FFT_SIZE >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+
+    if (i < j)
+    {
+      int32_t temp = re[i];
+      re[i] = re[j];
+      re[j] = temp;
+      temp = im[i];
+      im[i] = im[j];
+      im[j] = temp;
+    }
+  }
+
+  // Butterflies, doubling the span each stage
+  for (uint8_t span = 1; span < DSP_FFT_SIZE; span <<= 1)
+  {
+    uint8_t step = DSP_COS_TABLE_SIZE / (2 * span);
+
+    for (uint8_t k = 0; k < span; k++)
+    {
+      // Twiddle factor e^(-j * 2 * pi * k / (2 * span))
+      int32_t wr = DSP_CosTable[k * step];
+      int32_t wi = -SIN_TABLE(k * step);
+
+      for (uint8_t i = k; i < DSP_FFT_SIZE; i += 2 * span)
+      {
+        uint8_t j = i + span;
+        int32_t tr = (int32_t)Q15_ROUND((int64_t)re[j] * wr - (int64_t)im[j] * wi);
+        int32_t ti = (int32_t)Q15_ROUND((int64_t)re[j] * wi + (int64_t)im[j] * wr);
+
+        re[j] = re[i] - tr;
+        im[j] = im[i] - ti;
+        re[i] += tr;
+        im[i] += ti;
+      }
+    }
+  }
+}
+
+void DSP_Harmonics(const int16_t samples[DSP_FFT_SIZE], THarmonics * const harmonics)
+{
+  int32_t re[DSP_FFT_SIZE], im[DSP_FFT_SIZE];
+
+  for (uint8_t i = 0; i < DSP_FFT_SIZE; i++)
+  {
+    re[i] = samples[i];
+    im[i] = 0;
+  }
+
+  DSP_FFT(re, im);
+
+  // The window is one cycle, so harmonic h is bin h
+  uint64_t fundamental = DSP_SquareRoot((int64_t)re[1] * re[1] + (int64_t)im[1] * im[1]);
+  uint64_t distortion = 0;
+
+  for (uint8_t h = 1; h <= DSP_NB_HARMONICS; h++)
+  {
+    uint64_t magnitudeSquared = (int64_t)re[h] * re[h] + (int64_t)im[h] * im[h];
+    uint64_t ratio = fundamental ? (DSP_SquareRoot(magnitudeSquared) * 10000) / fundamental : 0;
+
+    harmonics->harmonic[h - 1] = (ratio > UINT16_MAX) ? UINT16_MAX : ratio;
+
+    if (h > 1)
+      distortion += magnitudeSquared;
+  }
+
+  uint64_t thd = fundamental ? (DSP_SquareRoot(distortion) * 10000) / fundamental : 0;
+  harmonics->thd = (thd > UINT16_MAX) ? UINT16_MAX : thd;
+}
+
+#if defined(__ARM_FEATURE_DSP)
+/*! @brief Squares both 16-bit halves of a word and adds them to a 64-bit accumulator.
+ *
+ *  @param pair Two packed 16-bit samples.
+ *  @param accumulator The running sum.
+ *  @return int64_t - The accumulator plus the squares of both samples.
+ */
+static inline int64_t smlald(const uint32_t pair, const int64_t accumulator)
+{
+  uint32_t lo = (uint32_t)accumulator;
+  uint32_t hi = (uint32_t)(accumulator >> 32);
+
+  __asm("smlald %0, %1, %2, %2" : "+r"(lo), "+r"(hi) : "r"(pair));
+
+  return (int64_t)(((uint64_t)hi << 32) | lo);
+}
+
+void DSP_SumOfSquares(const TSampleBlock * const block, uint64_t sums[DSP_NB_PHASES])
+{
+  for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+  {
+    const uint32_t *pairs = (const uint32_t *)block->phase[phase];
+    int64_t sum = 0;
+
+    for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE / 2; i++)
+      sum = smlald(pairs[i], sum);
+
+    sums[phase] = (uint64_t)sum;
+  }
+}
+#else
+void DSP_SumOfSquares(const TSampleBlock * const block, uint64_t sums[DSP_NB_PHASES])
+{
+  for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+  {
+    const int16_t *samples = block->phase[phase];
+    int64_t sum = 0;
+
+    for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE; i++)
+      sum += (int32_t)samples[i] * samples[i];
+
+    sums[phase] = (uint64_t)sum;
+  }
+}
+#endif
+
+float DSP_DFTAngle(const TDFTBin * const bin)
+{
+  return atan2f((float)bin->im, (float)bin->re) * (180.0f / (float)M_PI);
+}
+
+void DSP_CICIntegrate(TCICDecimator * const cic, const int16_t sample)
+{
+  uint32_t value = (uint32_t)(int32_t)sample;
+
+  for (uint8_t stage = 0; stage < DSP_CIC_ORDER; stage++)
+  {
+    cic->integrator[stage] += value;
+    value = cic->integrator[stage];
+  }
+}
+
+int16_t DSP_CICDecimate(TCICDecimator * const cic)
+{
+  uint32_t value = cic->integrator[DSP_CIC_ORDER - 1];
+
+  for (uint8_t stage = 0; stage < DSP_CIC_ORDER; stage++)
+  {
+    uint32_t delayed = cic->comb[stage];
+    cic->comb[stage] = value;
+    value -= delayed;
+  }
+
+#if DSP_OVERSAMPLING_SHIFT > 0
+  // The DC gain is DSP_OVERSAMPLING_RATIO^DSP_CIC_ORDER, so the result always fits back into 16 bits
+  return (int16_t)(((int32_t)value + (1 << (DSP_OVERSAMPLING_SHIFT * DSP_CIC_ORDER - 1))) >> (DSP_OVERSAMPLING_SHIFT * DSP_CIC_ORDER));
+#else
+  return (int16_t)(int32_t)value;
+#endif
+}
+
+int16_t DSP_DCFilter(int32_t * const dcOffset, const int16_t sample, const uint8_t shift)
+{
+  // Q14 reciprocal of the filter gain at the fundamental, 1/16 of the sample rate, for each time constant
+  static const uint16_t DC_FILTER_GAIN_CORRECTION[DSP_DC_FILTER_SHIFT_MAX + 1] =
+  {
+    16384, 47959, 23534, 18514, 17151, 16701, 16527, 16452, 16417, 16400, 16392, 16388, 16386
+  };
+
+  if (shift < DSP_DC_FILTER_SHIFT_MIN || shift > DSP_DC_FILTER_SHIFT_MAX)
+    return sample;
+
+  // The difference is at most 2^30, so the level can't overflow
+  *dcOffset += ((int32_t)sample * (1 << DSP_DC_FILTER_Q) - *dcOffset) >> shift;
+
+  int32_t filtered = (int32_t)sample - ((*dcOffset + (1 << (DSP_DC_FILTER_Q - 1))) >> DSP_DC_FILTER_Q);
+  filtered = (filtered * DC_FILTER_GAIN_CORRECTION[shift] + (1 << 13)) >> 14;
+
+  if (filtered > INT16_MAX)
+    return INT16_MAX;
+  if (filtered < INT16_MIN)
+    return INT16_MIN;
+
+  return (int16_t)filtered;
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,241 @@
+/*! @file
+ *
+ *  @brief Fixed-point signal processing routines for the DOR measurement path.
+ *
+ *  This contains the Q-format scaling constants and the integer kernels used to turn raw ADC samples into currents.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef DSP_H
+#define DSP_H
+
+// new types
+#include "types.h"
+
+// The ADC spans +/-10V across its 16-bit range
+#define DSP_ADC_VOLTS_FULL_SCALE 20.0
+#define DSP_ADC_COUNTS 65536.0
+
+// Current transducer output in volts RMS per amp RMS
+#define DSP_VOLTS_PER_AMP 0.35
+
+// Raw ADC counts per amp
+#define DSP_RAW_PER_AMP (DSP_VOLTS_PER_AMP * DSP_ADC_COUNTS / DSP_ADC_VOLTS_FULL_SCALE)
+
+// Largest RMS current the ADC can measure, where the peaks of a sinusoid reach full scale (about 20 A)
+#define DSP_MAX_CURRENT (DSP_ADC_VOLTS_FULL_SCALE / 2 / (DSP_VOLTS_PER_AMP * 1.4142135623731))
+
+// Raw samples taken per processed sample, set at build time to 1, 4 or 8, e.g. with -DDSP_OVERSAMPLING_RATIO=4
+#ifndef DSP_OVERSAMPLING_RATIO
+#define DSP_OVERSAMPLING_RATIO 1
+#endif
+
+// Passband gain of the CIC decimator at the fundamental, which is 1/16 of the decimated rate
+#if DSP_OVERSAMPLING_RATIO == 1
+#define DSP_OVERSAMPLING_SHIFT 0
+#define DSP_CIC_GAIN 1.0
+#elif DSP_OVERSAMPLING_RATIO == 4
+#define DSP_OVERSAMPLING_SHIFT 2
+#define DSP_CIC_GAIN 0.9880081346
+#elif DSP_OVERSAMPLING_RATIO == 8
+#define DSP_OVERSAMPLING_SHIFT 3
+#define DSP_CIC_GAIN 0.9874130850
+#else
+#error "DSP_OVERSAMPLING_RATIO must be 1, 4 or 8"
+#endif
+
+#if (DSP_OVERSAMPLING_RATIO > 1) && (ANALOG_WINDOW_SIZE != 16)
+#error "The CIC passband gain is only tabulated for windows of 16 samples"
+#endif
+
+// Raw samples per cycle of the fundamental
+#define DSP_RAW_WINDOW_SIZE (ANALOG_WINDOW_SIZE * DSP_OVERSAMPLING_RATIO)
+
+// Processed (decimated) sample counts per amp, including the CIC droop at the fundamental
+#define DSP_SAMPLE_PER_AMP (DSP_RAW_PER_AMP * DSP_CIC_GAIN)
+
+// Number of integrator and comb stages in the CIC decimator
+#define DSP_CIC_ORDER 2
+
+// Currents are held as unsigned Q16.16 amps
+#define DSP_CURRENT_Q 16
+#define DSP_CURRENT_ONE (1UL << DSP_CURRENT_Q)
+
+// Number of phases processed together
+#define DSP_NB_PHASES 3
+
+/*! @brief Sample windows of all phases stored together.
+ *
+ *  Each phase's window is contiguous and word aligned, so two samples can be loaded in one access.
+ */
+typedef struct
+{
+  int16_t phase[DSP_NB_PHASES][ANALOG_WINDOW_SIZE] __attribute__((aligned(4)));
+} TSampleBlock;
+
+// Number of entries in the cosine table, one full cycle
+#define DSP_COS_TABLE_SIZE 64
+
+/*! @brief cos(2 * pi * i / DSP_COS_TABLE_SIZE) in Q15, the DFT and FFT twiddle factors.
+ *
+ *  Generated into dsp_tables.c by tests/gen_dsp.c.
+ */
+extern const int16_t DSP_CosTable[DSP_COS_TABLE_SIZE];
+
+// The FFT runs over one window of samples
+#define DSP_FFT_SIZE ANALOG_WINDOW_SIZE
+
+#if (DSP_FFT_SIZE != 16) && (DSP_FFT_SIZE != 32) && (DSP_FFT_SIZE != 64)
+#error "The FFT supports windows of 16, 32 or 64 samples"
+#endif
+
+// Harmonics up to the 15th, limited to those below the Nyquist frequency
+#if (DSP_FFT_SIZE / 2 - 1) < 15
+#define DSP_NB_HARMONICS (DSP_FFT_SIZE / 2 - 1)
+#else
+#define DSP_NB_HARMONICS 15
+#endif
+
+/*! @brief State of a CIC decimator for one phase
+ *
+ *  The stages wrap modulo 2^32, which the comb stages undo exactly.
+ */
+typedef struct
+{
+  uint32_t integrator[DSP_CIC_ORDER]; /*!< Integrators, running at the raw rate */
+  uint32_t comb[DSP_CIC_ORDER];       /*!< Comb delays, running at the decimated rate */
+} TCICDecimator;
+
+// Fractional bits of the DC level held by the DC-removal filter
+#define DSP_DC_FILTER_Q 14
+
+// Range of the DC-removal filter time constant, as a power of two samples. 0 turns the filter off.
+#define DSP_DC_FILTER_SHIFT_MIN 2
+#define DSP_DC_FILTER_SHIFT_MAX 12
+
+#if ANALOG_WINDOW_SIZE != 16
+#error "The DC-removal filter gain is only tabulated for windows of 16 samples"
+#endif
+
+/*! @brief Harmonic content of one phase
+ *
+ */
+typedef struct
+{
+  uint16_t thd;                        /*!< Total harmonic distortion in 0.01% */
+  uint16_t harmonic[DSP_NB_HARMONICS]; /*!< Magnitudes of harmonics 1 to DSP_NB_HARMONICS in 0.01% of the fundamental */
+} THarmonics;
+
+/*! @brief Converts a voltage to a raw DAC/ADC value at compile time. */
+#define DSP_VOLTAGE_TO_RAW(volts) ((int16_t)((volts) * DSP_ADC_COUNTS / DSP_ADC_VOLTS_FULL_SCALE))
+
+/*! @brief Converts a current in amps to its Q16.16 representation at compile time. */
+#define DSP_CURRENT(amps) ((uint32_t)((amps) * DSP_CURRENT_ONE))
+
+/*! @brief Converts an RMS current in amps to the equivalent window sum of squares of raw samples at compile time. */
+#define DSP_SUM_OF_SQUARES(amps) ((uint64_t)(ANALOG_WINDOW_SIZE * ((amps) * DSP_SAMPLE_PER_AMP) * ((amps) * DSP_SAMPLE_PER_AMP)))
+
+/*! @brief Converts an RMS current in amps to the equivalent half-cycle sum of absolute raw samples at compile time.
+ *
+ *  The mean absolute value of a sinusoid is 2 * sqrt(2) / pi times its RMS value. The sum runs at the raw rate.
+ */
+#define DSP_HALF_CYCLE_ABS_SUM(amps) ((uint32_t)((DSP_RAW_WINDOW_SIZE / 2) * 0.9003163161571 * (amps) * DSP_RAW_PER_AMP))
+
+/*! @brief Integer square root.
+ *
+ *  @param value The value to take the square root of.
+ *  @return uint32_t - The square root of value, rounded down.
+ */
+uint32_t DSP_SquareRoot(uint64_t value);
+
+/*! @brief Converts a window sum of squares of raw samples into an RMS current.
+ *
+ *  @param sumOfSquares The sum of the squared raw samples over ANALOG_WINDOW_SIZE samples.
+ *  @return uint32_t - The RMS current in Q16.16 amps.
+ */
+uint32_t DSP_RMSCurrent(const uint64_t sumOfSquares);
+
+/*! @brief In-place radix-2 decimation-in-time FFT.
+ *
+ *  @param re The real parts, replaced by the real parts of the spectrum.
+ *  @param im The imaginary parts, replaced by the imaginary parts of the spectrum.
+ *  @note Inputs must fit in 16 bits, so that the growth over log2(DSP_FFT_SIZE) stages cannot overflow.
+ */
+void DSP_FFT(int32_t re[DSP_FFT_SIZE], int32_t im[DSP_FFT_SIZE]);
+
+/*! @brief Calculates the harmonic magnitudes and THD of one window of samples.
+ *
+ *  @param samples The window of raw samples, one cycle of the fundamental long.
+ *  @param harmonics A pointer to place the harmonic content.
+ */
+void DSP_Harmonics(const int16_t samples[DSP_FFT_SIZE], THarmonics * const harmonics);
+
+/*! @brief Calculates the sum of squares of every phase's window in one pass.
+ *
+ *  Uses the SMLALD dual 16-bit multiply-accumulate on the Cortex-M4, with a portable C fallback
+ *  that gives identical results on other targets.
+ *  @param block The packed sample windows.
+ *  @param sums An array to place the sum of squares of each phase.
+ */
+void DSP_SumOfSquares(const TSampleBlock * const block, uint64_t sums[DSP_NB_PHASES]);
+
+/*! @brief Slides the fundamental DFT bin along by one sample.
+ *
+ *  The sample rate is locked to ANALOG_WINDOW_SIZE samples per cycle of the tracked frequency,
+ *  so the fundamental is always bin 1 of the window. Each sample's contribution is rotated by
+ *  its fixed position in the window, so the sample leaving the window is removed exactly and the
+ *  bin does not drift. The cost is two multiplies per sample.
+ *  @param bin The bin to update.
+ *  @param newSample The sample entering the window.
+ *  @param oldSample The sample leaving the window.
+ *  @param position The window position both samples occupy.
+ */
+void DSP_DFTUpdate(TDFTBin * const bin, const int16_t newSample, const int16_t oldSample, const uint8_t position);
+
+/*! @brief Converts a fundamental DFT bin to the window sum of squares of the fundamental alone.
+ *
+ *  @param bin The fundamental bin.
+ *  @return uint64_t - A sum of squares on the same scale as a raw window sum of squares.
+ */
+uint64_t DSP_DFTSumOfSquares(const TDFTBin * const bin);
+
+/*! @brief Gets the phase angle of a fundamental DFT bin.
+ *
+ *  @param bin The fundamental bin.
+ *  @return float - The angle of the fundamental relative to the start of the window in degrees,
+ *                  from -180 to 180.
+ */
+float DSP_DFTAngle(const TDFTBin * const bin);
+
+/*! @brief Passes one raw sample through the integrators of a CIC decimator.
+ *
+ *  @param cic The decimator of the phase.
+ *  @param sample The raw sample.
+ */
+void DSP_CICIntegrate(TCICDecimator * const cic, const int16_t sample);
+
+/*! @brief Produces a decimated sample from a CIC decimator.
+ *
+ *  @param cic The decimator of the phase.
+ *  @return int16_t - The decimated sample, scaled back to raw ADC counts.
+ *  @note Call once after every DSP_OVERSAMPLING_RATIO calls to DSP_CICIntegrate.
+ */
+int16_t DSP_CICDecimate(TCICDecimator * const cic);
+
+/*! @brief Removes the DC offset from a sample with a first order IIR high-pass filter.
+ *
+ *  The DC level follows the input with a time constant of 2^shift samples, and is subtracted
+ *  from the sample. The output is scaled so the fundamental keeps unity gain, but it leads the
+ *  input by about 0.04 degrees (shift 12) to 36 degrees (shift 2), so phases compared with each
+ *  other should share a setting. The cost is a multiply and a handful of ALU operations per sample.
+ *  @param dcOffset The DC level of the channel, in raw counts scaled by 2^DSP_DC_FILTER_Q.
+ *  @param sample The raw sample.
+ *  @param shift The time constant as a power of two samples, DSP_DC_FILTER_SHIFT_MIN to
+ *               DSP_DC_FILTER_SHIFT_MAX, or 0 to pass the sample through unchanged.
+ *  @return int16_t - The filtered sample, saturated to 16 bits.
+ */
+int16_t DSP_DCFilter(int32_t * const dcOffset, const int16_t sample, const uint8_t shift);
+
+#endif
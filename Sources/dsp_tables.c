@@ -0,0 +1,31 @@
+/*! @file dsp_tables.c
+ *
+ *  @brief DSP cosine table
+ *
+ *  Generated by tests/gen_dsp.c, do not edit. Run make -C tests tables to regenerate.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup dsp_module DSP module documentation
+**  @{
+*/
+
+#include "dsp.h"
+
+const int16_t DSP_CosTable[DSP_COS_TABLE_SIZE] =
+{
+     32767,  32609,  32137,  31356,  30273,  28898,  27245,  25329,
+     23170,  20787,  18204,  15446,  12539,   9512,   6393,   3212,
+         0,  -3212,  -6393,  -9512, -12539, -15446, -18204, -20787,
+    -23170, -25329, -27245, -28898, -30273, -31356, -32137, -32609,
+    -32767, -32609, -32137, -31356, -30273, -28898, -27245, -25329,
+    -23170, -20787, -18204, -15446, -12539,  -9512,  -6393,  -3212,
+         0,   3212,   6393,   9512,  12539,  15446,  18204,  20787,
+     23170,  25329,  27245,  28898,  30273,  31356,  32137,  32609,
+};
+
+/*!
+** @}
+*/
@@ -0,0 +1,320 @@
+/*! @file freq.c
+ *
+ *  @brief routines for tracking the frequency
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup freq_module freq module documentation
+**  @{
+*/
+
+#include "freq.h"
+
+// A rising and a falling edge series for each phase
+#define NB_SERIES (DSP_NB_PHASES * 2)
+
+// Crossing intervals outside this range, in nanoseconds, mean a crossing was missed or spurious
+#define MIN_INTERVAL ((uint32_t)(1e9f / (FREQ_MAX * 1.1f)))
+#define MAX_INTERVAL ((uint32_t)(1e9f / (FREQ_MIN / 1.1f)))
+
+// A series with no crossing for two nominal periods, in nanoseconds, has lost its signal
+#define STALE_INTERVAL ((uint32_t)(2 * 1e9f / FREQ_NOMINAL))
+
+/*! @brief The recent crossings of one edge of one phase, one cycle apart
+ *
+ */
+typedef struct
+{
+  uint32_t times[FREQ_NB_CYCLES]; /*!< Crossing times in nanoseconds, oldest first */
+  uint8_t count;                  /*!< Number of crossings held */
+  bool armed;                     /*!< TRUE once the signal has swung far enough to cross again */
+  bool pending;                   /*!< TRUE while a crossing waits for the signal to swing past zero */
+  uint32_t pendingTime;           /*!< Time of the waiting crossing in nanoseconds */
+} TCrossings;
+
+static TCrossings Series[NB_SERIES];
+static int16_t PreviousSamples[DSP_NB_PHASES];
+static uint32_t Now; // Time of the latest sample in nanoseconds, wrapping
+static bool Started; // TRUE once there is a previous sample to measure the period from
+static float SmoothedFrequency;
+static bool Locked; // TRUE while there are live crossings to estimate from
+
+// History of estimates as a ring buffer
+static TFreqSample History[FREQ_HISTORY_SIZE];
+static uint8_t HistoryEnd;   // Where the next estimate goes
+static uint8_t HistoryCount; // Number of estimates held
+
+static uint8_t ROCOFWindow;
+static float ROCOF;
+
+bool Freq_Init(void)
+{
+  for (uint8_t series = 0; series < NB_SERIES; series++)
+    Series[series] = (TCrossings){{0}, 0, false, false, 0};
+
+  for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+    PreviousSamples[phase] = 0;
+
+  Now = 0;
+  Started = false;
+  SmoothedFrequency = FREQ_NOMINAL;
+  Locked = false;
+
+  HistoryEnd = 0;
+  HistoryCount = 0;
+  ROCOFWindow = FREQ_ROCOF_WINDOW;
+  ROCOF = 0.0f;
+
+  return true;
+}
+
+/*! @brief Adds a crossing to a series, restarting the series if it doesn't follow on.
+ *
+ *  @param crossings The series.
+ *  @param time The crossing time in nanoseconds.
+ */
+static void AddCrossing(TCrossings * const crossings, const uint32_t time)
+{
+  if (crossings->count > 0)
+  {
+    uint32_t interval = time - crossings->times[crossings->count - 1];
+
+    if (interval < MIN_INTERVAL || interval > MAX_INTERVAL)
+      crossings->count = 0;
+  }
+
+  // Drop the oldest crossing when full
+  if (crossings->count == FREQ_NB_CYCLES)
+  {
+    for (uint8_t i = 1; i < FREQ_NB_CYCLES; i++)
+      crossings->times[i - 1] = crossings->times[i];
+    crossings->count--;
+  }
+
+  crossings->times[crossings->count++] = time;
+}
+
+void Freq_Update(const int16_t samples[DSP_NB_PHASES], const uint64_t time)
+{
+  // Measure the period from the stamps, as the sample rate is retuned as it goes
+  uint32_t now = (uint32_t)(time * 1000);
+  uint32_t period = now - Now;
+  Now = now;
+
+  if (!Started)
+  {
+    for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+      PreviousSamples[phase] = samples[phase];
+
+    Started = true;
+    return;
+  }
+
+  for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+  {
+    int16_t previous = PreviousSamples[phase];
+    int16_t sample = samples[phase];
+    TCrossings *rising = &Series[phase * 2];
+    TCrossings *falling = &Series[phase * 2 + 1];
+
+    // A swing past zero arms the next crossing the other way, and a swing back abandons a waiting one
+    if (sample < -FREQ_HYSTERESIS)
+    {
+      rising->armed = true;
+      rising->pending = false;
+    }
+    if (sample > FREQ_HYSTERESIS)
+    {
+      falling->armed = true;
+      falling->pending = false;
+    }
+
+    bool risingEdge = rising->armed && previous < 0 && sample >= 0;
+    bool fallingEdge = falling->armed && previous > 0 && sample <= 0;
+
+    if (risingEdge || fallingEdge)
+    {
+      // Interpolate the crossing between the two samples
+      float fraction = (float)previous / (float)(previous - sample);
+      uint32_t crossing = Now - period + (uint32_t)(fraction * period);
+
+      TCrossings *crossings = risingEdge ? rising : falling;
+      crossings->pendingTime = crossing;
+      crossings->pending = true;
+      crossings->armed = false;
+    }
+
+    // A crossing only counts once the signal swings past zero after it, so a signal collapsing to
+    // zero isn't taken for one
+    if (rising->pending && sample > FREQ_HYSTERESIS)
+    {
+      AddCrossing(rising, rising->pendingTime);
+      rising->pending = false;
+    }
+    if (falling->pending && sample < -FREQ_HYSTERESIS)
+    {
+      AddCrossing(falling, falling->pendingTime);
+      falling->pending = false;
+    }
+
+    PreviousSamples[phase] = sample;
+  }
+}
+
+/*! @brief Fits the slope of the latest estimates in the history.
+ *
+ *  @return float - The slope in Hz/s.
+ */
+static float FitROCOF(void)
+{
+  uint8_t count = (HistoryCount < ROCOFWindow) ? HistoryCount : ROCOFWindow;
+
+  if (count < 2)
+    return 0.0f;
+
+  const TFreqSample *newest = &History[(HistoryEnd + FREQ_HISTORY_SIZE - 1) % FREQ_HISTORY_SIZE];
+  float meanTime = 0.0f;
+  float meanFrequency = 0.0f;
+
+  // Times relative to the newest estimate, in seconds
+  for (uint8_t i = 0; i < count; i++)
+  {
+    const TFreqSample *sample = &History[(HistoryEnd + FREQ_HISTORY_SIZE - 1 - i) % FREQ_HISTORY_SIZE];
+    meanTime -= (float)(newest->time - sample->time) * 1e-6f;
+    meanFrequency += sample->frequency;
+  }
+  meanTime /= count;
+  meanFrequency /= count;
+
+  float numerator = 0.0f;
+  float denominator = 0.0f;
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    const TFreqSample *sample = &History[(HistoryEnd + FREQ_HISTORY_SIZE - 1 - i) % FREQ_HISTORY_SIZE];
+    float time = -(float)(newest->time - sample->time) * 1e-6f - meanTime;
+    numerator += time * (sample->frequency - meanFrequency);
+    denominator += time * time;
+  }
+
+  return (denominator > 0.0f) ? numerator / denominator : 0.0f;
+}
+
+bool Freq_Estimate(const uint64_t time)
+{
+  float numerator = 0.0f;
+  float denominator = 0.0f;
+
+  // Age out the series that have stopped crossing, so a lost signal isn't fitted as if it were fresh
+  for (uint8_t series = 0; series < NB_SERIES; series++)
+  {
+    TCrossings *crossings = &Series[series];
+
+    if (crossings->count > 0 && Now - crossings->times[crossings->count - 1] > STALE_INTERVAL)
+      crossings->count = 0;
+  }
+
+  // Every series is a line of crossing time against cycle number with the same slope, the
+  // period, but its own offset, so fit the common slope to all of them at once
+  for (uint8_t series = 0; series < NB_SERIES; series++)
+  {
+    const TCrossings *crossings = &Series[series];
+    uint8_t count = crossings->count;
+
+    if (count < 2)
+      continue;
+
+    // Times relative to the first crossing keep the float sums precise
+    float meanCycle = (count - 1) / 2.0f;
+    float meanTime = 0.0f;
+    for (uint8_t i = 0; i < count; i++)
+      meanTime += (float)(crossings->times[i] - crossings->times[0]);
+    meanTime /= count;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+      float cycle = i - meanCycle;
+      numerator += cycle * ((float)(crossings->times[i] - crossings->times[0]) - meanTime);
+      denominator += cycle * cycle;
+    }
+  }
+
+  // Nothing left to fit, so the signal has gone
+  if (numerator <= 0.0f)
+  {
+    Locked = false;
+    ROCOF = 0.0f;
+    return false;
+  }
+
+  float frequency = 1e9f * denominator / numerator;
+
+  if (!(frequency >= FREQ_MIN && frequency <= FREQ_MAX))
+    return false;
+
+  // Start the filter from the first estimate rather than slewing from nominal
+  if (Locked)
+    SmoothedFrequency += FREQ_SMOOTHING * (frequency - SmoothedFrequency);
+  else
+    SmoothedFrequency = frequency;
+
+  Locked = true;
+
+  // Readers copy the history with interrupts disabled, so it is never seen half written
+  OS_DisableInterrupts();
+  History[HistoryEnd] = (TFreqSample){time, SmoothedFrequency};
+  HistoryEnd = (HistoryEnd + 1) % FREQ_HISTORY_SIZE;
+  if (HistoryCount < FREQ_HISTORY_SIZE)
+    HistoryCount++;
+  OS_EnableInterrupts();
+
+  ROCOF = FitROCOF();
+
+  return true;
+}
+
+float Freq_Get(void)
+{
+  return SmoothedFrequency;
+}
+
+uint8_t Freq_History(TFreqSample history[FREQ_HISTORY_SIZE])
+{
+  OS_DisableInterrupts();
+
+  uint8_t count = HistoryCount;
+  uint8_t start = (HistoryEnd + FREQ_HISTORY_SIZE - count) % FREQ_HISTORY_SIZE;
+
+  for (uint8_t i = 0; i < count; i++)
+    history[i] = History[(start + i) % FREQ_HISTORY_SIZE];
+
+  OS_EnableInterrupts();
+
+  return count;
+}
+
+bool Freq_Locked(void)
+{
+  return Locked;
+}
+
+float Freq_ROCOF(void)
+{
+  return ROCOF;
+}
+
+bool Freq_SetROCOFWindow(const uint8_t window)
+{
+  if (window < 2 || window > FREQ_HISTORY_SIZE)
+    return false;
+
+  ROCOFWindow = window;
+  return true;
+}
+
+/*!
+** @}
+*/
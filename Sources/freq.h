@@ -0,0 +1,109 @@
+/*! @file
+ *
+ *  @brief Routines for tracking the power system frequency.
+ *
+ *  This contains the functions for collecting zero crossings from every phase and fitting the
+ *  frequency to them by least squares.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef FREQ_H
+#define FREQ_H
+
+// new types
+#include "types.h"
+#include "dsp.h"
+
+// Range of frequencies accepted, covering 50 Hz and 60 Hz systems
+#define FREQ_MIN 45.0f
+#define FREQ_MAX 65.0f
+
+// Frequency assumed until the first estimate
+#define FREQ_NOMINAL 50.0f
+
+// Crossings of each edge of each phase kept for the fit, one per cycle
+#define FREQ_NB_CYCLES 8
+
+// Weight given to each new estimate by the smoothing filter, 1 for no smoothing
+#define FREQ_SMOOTHING 0.25f
+
+// Estimates kept in the frequency history, one per cycle
+#define FREQ_HISTORY_SIZE 32
+
+// Estimates the ROCOF is fitted over until changed
+#define FREQ_ROCOF_WINDOW 10
+
+// Distance past zero a signal must swing before its next crossing counts, in raw counts
+#define FREQ_HYSTERESIS ((int16_t)(0.05 * DSP_SAMPLE_PER_AMP))
+
+/*! @brief A timestamped frequency estimate
+ *
+ */
+typedef struct
+{
+  uint64_t time;   /*!< Time of the estimate in microseconds */
+  float frequency; /*!< Smoothed frequency in Hz */
+} TFreqSample;
+
+/*! @brief Sets up the frequency tracker before first use.
+ *
+ *  @return bool - TRUE if the tracker was successfully initialized.
+ */
+bool Freq_Init(void);
+
+/*! @brief Looks for zero crossings in the next sample of every phase.
+ *
+ *  The crossings are interpolated between the measured times of this sample and the last one.
+ *  @param samples The sample of each phase, aligned to a common instant.
+ *  @param time The time the samples were taken in microseconds.
+ *  @note The first call after Freq_Init only records the samples.
+ */
+void Freq_Update(const int16_t samples[DSP_NB_PHASES], const uint64_t time);
+
+/*! @brief Fits the frequency to the crossings collected so far and updates the smoothed estimate.
+ *
+ *  A successful estimate is added to the history and the ROCOF is refitted. Crossing series that
+ *  have had no crossing for two nominal periods are dropped, and once none are left the tracker
+ *  loses lock.
+ *  @param time The time of the latest sample in microseconds.
+ *  @return bool - TRUE if the fit gave a frequency within FREQ_MIN to FREQ_MAX.
+ *  @note Intended to be called about once a cycle.
+ */
+bool Freq_Estimate(const uint64_t time);
+
+/*! @brief Gets the smoothed frequency.
+ *
+ *  @return float - The frequency in Hz, FREQ_NOMINAL until the first successful estimate.
+ */
+float Freq_Get(void);
+
+/*! @brief Says whether the tracker is locked to a signal.
+ *
+ *  @return bool - TRUE from the first successful estimate until every phase stops crossing zero.
+ */
+bool Freq_Locked(void);
+
+/*! @brief Copies the frequency history.
+ *
+ *  @param history An array to place the estimates in, oldest first.
+ *  @return uint8_t - The number of estimates copied.
+ */
+uint8_t Freq_History(TFreqSample history[FREQ_HISTORY_SIZE]);
+
+/*! @brief Gets the rate of change of frequency.
+ *
+ *  @return float - The least-squares slope of the last ROCOF window of estimates in Hz/s,
+ *                  0 until there are two estimates or while unlocked.
+ */
+float Freq_ROCOF(void);
+
+/*! @brief Sets the number of estimates the ROCOF is fitted over.
+ *
+ *  @param window The number of estimates, from 2 to FREQ_HISTORY_SIZE.
+ *  @return bool - TRUE if the window was in range and has been set.
+ */
+bool Freq_SetROCOFWindow(const uint8_t window);
+
+#endif
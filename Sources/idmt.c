@@ -0,0 +1,49 @@
+/*! @file idmt.c
+ *
+ *  @brief routines for interpolating IDMT trip rates from tables
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup idmt_module IDMT module documentation
+**  @{
+*/
+
+#include "idmt.h"
+#include "dsp.h"
+
+// Bits of the normalised current used to index a step within an octave
+#define STEP_BITS 5
+
+// Bits of the normalised current used to interpolate between two steps
+#define FRACTION_BITS 16
+
+uint32_t IDMT_TripRate(const RELAY_CHARACTERISTIC characteristic, const uint32_t current)
+{
+  if (current <= DSP_CURRENT_ONE)
+    return 0;
+
+  const uint32_t *rates = IDMT_TripRates[characteristic];
+
+  uint8_t msb = 31 - __builtin_clz(current);
+  uint8_t octave = msb - DSP_CURRENT_Q;
+
+  if (octave >= IDMT_TABLE_OCTAVES)
+    return rates[IDMT_TABLE_SIZE - 1];
+
+  // Normalise so the leading one is bit 31, then index with the bits below it
+  uint32_t normalised = current << (31 - msb);
+  uint16_t index = octave * IDMT_TABLE_STEPS_PER_OCTAVE + ((normalised >> (31 - STEP_BITS)) & (IDMT_TABLE_STEPS_PER_OCTAVE - 1));
+  uint32_t fraction = (normalised >> (31 - STEP_BITS - FRACTION_BITS)) & ((1UL << FRACTION_BITS) - 1);
+
+  uint32_t lower = rates[index];
+  uint32_t upper = rates[index + 1];
+
+  return lower + (uint32_t)(((uint64_t)(upper - lower) * fraction) >> FRACTION_BITS);
+}
+
+/*!
+** @}
+*/
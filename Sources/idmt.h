@@ -0,0 +1,49 @@
+/*! @file
+ *
+ *  @brief Routines for looking up IDMT trip rates.
+ *
+ *  This contains the functions for evaluating the inverse definite minimum time characteristics
+ *  from interpolated tables instead of calling pow() on every sample. The tables are generated on
+ *  the host by tests/gen_idmt.c into idmt_tables.c, so they live in Flash.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef IDMT_H
+#define IDMT_H
+
+// new types
+#include "types.h"
+
+// Number of relay characteristics
+#define IDMT_NB_CHARACTERISTICS 3
+
+// Trip rates 1/t(I) are held in Q8.24 per second
+#define IDMT_RATE_Q 24
+#define IDMT_RATE_ONE (1UL << IDMT_RATE_Q)
+
+// Table points per doubling of the current
+#define IDMT_TABLE_STEPS_PER_OCTAVE 32
+
+// Number of doublings of the current covered, from 1A up to 64A
+#define IDMT_TABLE_OCTAVES 6
+
+#define IDMT_TABLE_SIZE (IDMT_TABLE_STEPS_PER_OCTAVE * IDMT_TABLE_OCTAVES + 1)
+
+/*
+ * Trip rates of each characteristic at currents 2^octave * (1 + step / IDMT_TABLE_STEPS_PER_OCTAVE)
+ * multiples of the setting, which are evenly spaced in the bits of the current just below its
+ * leading one
+ */
+extern const uint32_t IDMT_TripRates[IDMT_NB_CHARACTERISTICS][IDMT_TABLE_SIZE];
+
+/*! @brief Looks up the trip rate 1/t(I) of a characteristic by linear interpolation.
+ *
+ *  @param characteristic The relay characteristic.
+ *  @param current The RMS current in Q16.16 multiples of the setting.
+ *  @return uint32_t - The trip rate in Q8.24 per second, 0 at or below 1.
+ */
+uint32_t IDMT_TripRate(const RELAY_CHARACTERISTIC characteristic, const uint32_t current);
+
+#endif
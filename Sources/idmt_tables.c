@@ -0,0 +1,107 @@
+/*! @file idmt_tables.c
+ *
+ *  @brief IDMT trip rate tables
+ *
+ *  Generated by tests/gen_idmt.c, do not edit. Run make -C tests tables to regenerate.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup idmt_module IDMT module documentation
+**  @{
+*/
+
+#include "idmt.h"
+
+const uint32_t IDMT_TripRates[IDMT_NB_CHARACTERISTICS][IDMT_TABLE_SIZE] =
+{
+  // Inverse, k = 0.14, a = 0.02
+  {
+             0,      73775,     145390,     214970,     282629,     348470,     412590,     475077,
+        536013,     595475,     653531,     710249,     765688,     819906,     872956,     924888,
+        975747,    1025579,    1074424,    1122321,    1169306,    1215414,    1260677,    1305126,
+       1348790,    1391697,    1433872,    1475340,    1516125,    1556250,    1595734,    1634600,
+       1672866,    1747670,    1820285,    1890837,    1959440,    2026200,    2091215,    2154575,
+       2216362,    2276653,    2335520,    2393029,    2449243,    2504217,    2558008,    2610664,
+       2662234,    2712762,    2762289,    2810854,    2858495,    2905247,    2951142,    2996211,
+       3040485,    3083990,    3126754,    3168801,    3210155,    3250840,    3290876,    3330284,
+       3369084,    3444932,    3518561,    3590098,    3659658,    3727351,    3793273,    3857517,
+       3920167,    3981300,    4040989,    4099301,    4156299,    4212041,    4266582,    4319974,
+       4372263,    4423496,    4473714,    4522958,    4571264,    4618668,    4665204,    4710902,
+       4755794,    4799907,    4843267,    4885901,    4927833,    4969086,    5009681,    5049639,
+       5088980,    5165888,    5240544,    5313079,    5383611,    5452248,    5519091,    5584232,
+       5647756,    5709742,    5770264,    5829390,    5887184,    5943704,    5999007,    6053144,
+       6106164,    6158112,    6209031,    6258962,    6307942,    6356008,    6403193,    6449530,
+       6495048,    6539777,    6583743,    6626972,    6669489,    6711317,    6752479,    6792995,
+       6832886,    6910867,    6986565,    7060113,    7131629,    7201225,    7269001,    7335051,
+       7399461,    7462313,    7523680,    7583631,    7642232,    7699541,    7755616,    7810509,
+       7864268,    7916941,    7968571,    8019199,    8068864,    8117600,    8165444,    8212428,
+       8258581,    8303934,    8348514,    8392347,    8435457,    8477870,    8519606,    8560687,
+       8601135,    8680204,    8756960,    8831534,    8904049,    8974616,    9043338,    9110310,
+       9175620,    9239349,    9301572,    9362361,    9421779,    9479889,    9536746,    9592405,
+       9646915,    9700324,    9752674,    9804009,    9854366,    9903784,    9952295,    9999935,
+      10046733,   10092719,   10137921,   10182365,   10226078,   10269082,   10311401,   10353056,
+      10394068,
+  },
+  // VeryInverse, k = 13.5, a = 1
+  {
+             0,      38836,      77672,     116508,     155345,     194181,     233017,     271853,
+        310689,     349525,     388361,     427198,     466034,     504870,     543706,     582542,
+        621378,     660215,     699051,     737887,     776723,     815559,     854395,     893231,
+        932068,     970904,    1009740,    1048576,    1087412,    1126248,    1165084,    1203921,
+       1242757,    1320429,    1398101,    1475774,    1553446,    1631118,    1708791,    1786463,
+       1864135,    1941807,    2019480,    2097152,    2174824,    2252497,    2330169,    2407841,
+       2485513,    2563186,    2640858,    2718530,    2796203,    2873875,    2951547,    3029220,
+       3106892,    3184564,    3262236,    3339909,    3417581,    3495253,    3572926,    3650598,
+       3728270,    3883615,    4038959,    4194304,    4349649,    4504993,    4660338,    4815682,
+       4971027,    5126372,    5281716,    5437061,    5592405,    5747750,    5903095,    6058439,
+       6213784,    6369128,    6524473,    6679817,    6835162,    6990507,    7145851,    7301196,
+       7456540,    7611885,    7767230,    7922574,    8077919,    8233263,    8388608,    8543953,
+       8699297,    9009986,    9320676,    9631365,    9942054,   10252743,   10563432,   10874121,
+      11184811,   11495500,   11806189,   12116878,   12427567,   12738257,   13048946,   13359635,
+      13670324,   13981013,   14291703,   14602392,   14913081,   15223770,   15534459,   15845148,
+      16155838,   16466527,   16777216,   17087905,   17398594,   17709284,   18019973,   18330662,
+      18641351,   19262729,   19884108,   20505486,   21126865,   21748243,   22369621,   22991000,
+      23612378,   24233756,   24855135,   25476513,   26097892,   26719270,   27340648,   27962027,
+      28583405,   29204783,   29826162,   30447540,   31068919,   31690297,   32311675,   32933054,
+      33554432,   34175810,   34797189,   35418567,   36039945,   36661324,   37282702,   37904081,
+      38525459,   39768216,   41010972,   42253729,   43496486,   44739243,   45981999,   47224756,
+      48467513,   49710270,   50953026,   52195783,   53438540,   54681297,   55924053,   57166810,
+      58409567,   59652324,   60895080,   62137837,   63380594,   64623351,   65866107,   67108864,
+      68351621,   69594377,   70837134,   72079891,   73322648,   74565404,   75808161,   77050918,
+      78293675,
+  },
+  // ExtremelyInverse, k = 80, a = 2
+  {
+             0,      13312,      27034,      41165,      55706,      70656,      86016,     101786,
+        117965,     134554,     151552,     168960,     186778,     205005,     223642,     242688,
+        262144,     282010,     302285,     322970,     344064,     365568,     387482,     409805,
+        432538,     455680,     479232,     503194,     527565,     552346,     577536,     603136,
+        629146,     682394,     737280,     793805,     851968,     911770,     973210,    1036288,
+       1101005,    1167360,    1235354,    1304986,    1376256,    1449165,    1523712,    1599898,
+       1677722,    1757184,    1838285,    1921024,    2005402,    2091418,    2179072,    2268365,
+       2359296,    2451866,    2546074,    2641920,    2739405,    2838528,    2939290,    3041690,
+       3145728,    3358720,    3578266,    3804365,    4037018,    4276224,    4521984,    4774298,
+       5033165,    5298586,    5570560,    5849088,    6134170,    6425805,    6723994,    7028736,
+       7340032,    7657882,    7982285,    8313242,    8650752,    8994816,    9345434,    9702605,
+      10066330,   10436608,   10813440,   11196826,   11586765,   11983258,   12386304,   12795904,
+      13212058,   14064026,   14942208,   15846605,   16777216,   17734042,   18717082,   19726336,
+      20761805,   21823488,   22911386,   24025498,   25165824,   26332365,   27525120,   28744090,
+      29989274,   31260672,   32558285,   33882112,   35232154,   36608410,   38010880,   39439565,
+      40894464,   42375578,   43882906,   45416448,   46976205,   48562176,   50174362,   51812762,
+      53477376,   56885248,   60397978,   64015565,   67738010,   71565312,   75497472,   79534490,
+      83676365,   87923098,   92274688,   96731136,  101292442,  105958605,  110729626,  115605504,
+     120586240,  125671834,  130862285,  136157594,  141557760,  147062784,  152672666,  158387405,
+     164207002,  170131456,  176160768,  182294938,  188533965,  194877850,  201326592,  207880192,
+     214538650,  228170138,  242221056,  256691405,  271581184,  286890394,  302619034,  318767104,
+     335334605,  352321536,  369727898,  387553690,  405798912,  424463565,  443547648,  463051162,
+     482974106,  503316480,  524078285,  545259520,  566860186,  588880282,  611319808,  634178765,
+     657457152,  681154970,  705272218,  729808896,  754765005,  780140544,  805935514,  832149914,
+     858783744,
+  },
+};
+
+/*!
+** @}
+*/
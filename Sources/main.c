@@ -42,10 +42,29 @@
 #include "PIT.h"
 #include "UART.h"
 #include "analog.h"
+#include "dsp.h"
+#include "acq.h"
+#include "profile.h"
+#include "deadline.h"
+#include "idmt.h"
+#include "freq.h"
+#include "seq.h"
+#include "calib.h"
+
+#include <math.h>
+#include <stdlib.h>
 
 #define THREAD_STACK_SIZE 100
 #define NB_ANALOG_CHANNELS 3
 
+// Elements worked from the symmetrical components, each with its own trip timer
+#define NB_ELEMENTS 2
+#define NEGATIVE_SEQUENCE_ELEMENT 0
+#define EARTH_FAULT_ELEMENT 1
+
+// Most packets handled per wakeup of the packet checker
+#define PACKET_BATCH_SIZE 8
+
 const uint32_t BAUD_RATE = 115200;
 static uint64_t PIT_PERIOD = 1250000; // 1.25ms = 50Hz
 
@@ -59,65 +78,112 @@ static const int16_t TIMING_SIGNAL_HIGH = 16000;
 static const int16_t TRIP_SIGNAL_LOW = 0;
 static const int16_t TRIP_SIGNAL_HIGH = 16000;
 
+// Output level for an active timing/trip signal
+static const int16_t OUTPUT_SIGNAL_5V = DSP_VOLTAGE_TO_RAW(5.00);
+
 // DOR constants
-const static double iRMSThreshold = 1.03;
-const static double inverseTimingThreshold = 1.00;
+static const uint32_t iRMSThreshold = DSP_CURRENT(1.03);
+static const uint64_t sumOfSquaresThreshold = DSP_SUM_OF_SQUARES(1.03); // Pickup as a raw window sum of squares
+
+// High-set half-cycle absolute sum per amp of setting
+static const uint32_t highSetSumPerAmp = DSP_HALF_CYCLE_ABS_SUM(1.0);
+
+// The trip integral accumulates rate * microseconds, so it reaches this value when the trip time has elapsed
+static const uint64_t TRIP_INTEGRAL_UNITY = 1000000ULL << IDMT_RATE_Q;
+
+// Toggles fault-sensitive mode, where pickup uses the fundamental only
+extern bool SensitiveMode;
 
-// Private global for toggling fault-sensitive mode
-static bool SensitiveMode = false;
+// Instantaneous high-set current setting in amps, 0 when disabled
+extern uint8_t HighSetCurrent;
 
-OS_ECB *OutputSemaphore;
+// DC-removal filter time constant of each phase as a power of two samples, 0 when disabled
+extern uint8_t DCFilterShift[NB_ANALOG_CHANNELS];
+
+// Negative sequence (46) and residual earth-fault pickup settings in 0.1 A, 0 when disabled
+extern uint8_t NegativeSequencePickup;
+extern uint8_t EarthFaultPickup;
+
+// Earth-fault characteristic, and whether it uses the measured neutral rather than the calculated residual
+extern uint8_t EarthFaultCharacteristic;
+extern bool EarthFaultMeasured;
+
+// Measured neutral RMS current in Q16.16 amps
+extern uint32_t NeutralCurrent;
+
+OS_ECB *BlockSemaphore;
+OS_ECB *HarmonicsSemaphore;
 
 // Thread declarations
 static void InitThread(void *pData);
 static void PacketCheckerThread(void *pData);
-static void Pit0Thread(void *pData);
+static void SamplerThread(void *pData);
+static void DSPThread(void *pData);
 static void Pit1Thread(void *pData);
-static void InputThread(void *pData);
-static void OutputThread(void *pData);
+static void HarmonicsThread(void *pData);
 
 // Helper functions
-static void frequencyTracking(TDORThreadData *channelData, uint8_t count);
-static void handleTrip(TDORThreadData *channelData);
-static float fsqrt(float n);
-static float calculateTimeOffset(float sample1, float sample2);
-static float rawToVoltage(int16_t raw);
-static uint16_t voltageToRaw(float voltage);
-static float calculateRMS(float values[]);
-static double calculateTiming(double iRMS);
+static void processSample(TDORThreadData *data, int16_t analogInputValue, uint8_t count, uint64_t time);
+static void highSetSample(TDORThreadData *data, int16_t analogInputValue, uint8_t position);
+static void updateOutputs(uint64_t time);
+static void retuneSampling(uint64_t time);
+static void handleTrip(TDORThreadData *channelData, RELAY_CHARACTERISTIC characteristic, uint32_t current, uint64_t time, uint32_t period);
+static RELAY_CHARACTERISTIC relayCharacteristic();
+static void processNeutralSample(int16_t analogInputValue, uint8_t count);
+static void deactivateTimer(TDORThreadData *channelData);
+static void evaluateSequenceElements(uint64_t time);
+static void checkElement(TDORThreadData *elementData, RELAY_CHARACTERISTIC characteristic, uint32_t current, uint8_t pickup, uint64_t time);
+static void handleHighSetTrip(TDORThreadData *channelData);
+static void requestHighSetTrip(uint8_t channelNb);
+static void serviceTrips();
+static void refreshSumsOfSquares();
 static void resetDOR();
-static void resetChannel(uint8_t channel);
+static void resetChannel(TDORThreadData *channelData);
 
 // Stacks
 OS_THREAD_STACK(InitThreadStack, THREAD_STACK_SIZE);
-OS_THREAD_STACK(PacketCheckerThreadStack, THREAD_STACK_SIZE);
-OS_THREAD_STACK(RxThreadStack, THREAD_STACK_SIZE);
-OS_THREAD_STACK(TxThreadStack, THREAD_STACK_SIZE);
-OS_THREAD_STACK(InputThreadStacks[NB_ANALOG_CHANNELS], THREAD_STACK_SIZE * 2);
-OS_THREAD_STACK(OutputThreadStack, THREAD_STACK_SIZE);
+OS_THREAD_STACK(PacketCheckerThreadStack, THREAD_STACK_SIZE * 4); // Replies build their bursts on the stack
+OS_THREAD_STACK(SamplerThreadStack, THREAD_STACK_SIZE);
+OS_THREAD_STACK(DSPThreadStack, THREAD_STACK_SIZE * 2);
+OS_THREAD_STACK(Pit1ThreadStack, THREAD_STACK_SIZE);
+OS_THREAD_STACK(HarmonicsThreadStack, THREAD_STACK_SIZE * 2);
 
 static OUTPUT_SIGNAL TimingOutputSignal = OUTPUT_LOW;
 static OUTPUT_SIGNAL TripOutputSignal = OUTPUT_LOW;
 
-static RELAY_CHARACTERISTIC relayCharacteristic = Inverse;
-
-/*
- * Inverse Timing values from https://www.jcalc.net/idmt-relay-trip-time-calculator
- */
-static float k[3] = {
-    0.14, // Inverse
-    13.5, // VeryInverse
-    80    // ExtremelyInverse
-};
-
-static float a[3] = {
-    0.02, // Inverse
-    1,    // VeryInverse
-    2     // ExtremelyInverse
-};
+// Trip event still to be pushed to the PC, kept until the transmit queue takes it
+static bool TripEventPending = false;
+static uint8_t TripEventFaulted;
+static uint64_t TripEventTime;
+static uint32_t TripEventCurrents[NB_ANALOG_CHANNELS];
 
 extern FAULT LastFault;
 extern TDORThreadData DORThreadData[NB_ANALOG_CHANNELS];
+extern THarmonics PhaseHarmonics[NB_ANALOG_CHANNELS];
+extern uint32_t HarmonicsCycles;
+extern TSequence Sequence;
+extern uint32_t SequenceCycles;
+
+// Trip state of the sequence elements, which have no sample window of their own. Their iRMS
+// holds the element current as a multiple of its setting, so it compares against iRMSThreshold.
+static TDORThreadData ElementData[NB_ELEMENTS];
+
+// Sample windows of all phases, packed together for the dual-MAC kernel
+static TSampleBlock SampleBlock;
+
+// Unfiltered sample windows of all phases, so the raw RMS stays available
+static TSampleBlock RawSampleBlock;
+
+// Window and fundamental of the neutral input
+static int16_t NeutralSamples[ANALOG_WINDOW_SIZE];
+static TDFTBin NeutralFundamental;
+
+// Raw-rate half-cycle history of each phase for the high-set element
+static int16_t HalfCycleSamples[NB_ANALOG_CHANNELS][DSP_RAW_WINDOW_SIZE / 2];
+
+// Phases whose high-set element has operated, posted by the sampler for the DSP thread to trip,
+// so only the DSP thread changes trip state or drives the outputs
+static volatile uint8_t HighSetRequests;
 
 /* @brief Thread for initialising the tower
  *
@@ -131,79 +197,65 @@ static void InitThread(void *pData)
     Frequency = 0;
     LastFault = NoFault;
 
-    TDORThreadData DORThreadData[NB_ANALOG_CHANNELS] =
-        {
-            {
-                .sampleSemaphore = NULL,
-                .channelNb = 0,
-                .samples[0] = 0,
-                .iRMS = 0.0,
-                .tripTime = 0.0,
-                .intervalCounter = 0,
-                .numberOfIntervals = 0,
-                .timerStatus = TIMER_INACTIVE,
-                .tripped = false,
-
-                .crossingNb = 1,
-                .offset1 = 0,
-                .offset2 = 0,
-                .sampleOffset = 0,
-            },
-            {
-                .sampleSemaphore = NULL,
-                .channelNb = 1,
-                .samples[0] = 0,
-                .iRMS = 0.0,
-                .tripTime = 0.0,
-                .intervalCounter = 0,
-                .numberOfIntervals = 0,
-                .timerStatus = TIMER_INACTIVE,
-                .tripped = false,
-
-                .crossingNb = 1,
-                .offset1 = 0,
-                .offset2 = 0,
-                .sampleOffset = 0,
-            },
-            {
-                .sampleSemaphore = NULL,
-                .channelNb = 2,
-                .samples[0] = 0,
-                .iRMS = 0.0,
-                .tripTime = 0.0,
-                .intervalCounter = 0,
-                .numberOfIntervals = 0,
-                .timerStatus = TIMER_INACTIVE,
-                .tripped = false,
-
-                .crossingNb = 1,
-                .offset1 = 0,
-                .offset2 = 0,
-                .sampleOffset = 0,
-            },
-        };
-
     bool analogStatus = Analog_Init(CPU_BUS_CLK_HZ);
     bool packetStatus = Packet_Init(BAUD_RATE, CPU_BUS_CLK_HZ);
     bool flashStatus = PMcL_Flash_Init();
     bool ledStatus = LEDs_Init();
     bool pitStatus = PIT_Init(CPU_BUS_CLK_HZ);
-
-    if (packetStatus && flashStatus && ledStatus && pitStatus)
+    bool profileStatus = Profile_Init(CPU_CORE_CLK_HZ);
+    bool deadlineStatus = Deadline_Init();
+    bool acqStatus = Acq_Init();
+    bool freqStatus = Freq_Init();
+    bool calibStatus = Calib_Init();
+
+    if (packetStatus && flashStatus && ledStatus && pitStatus && profileStatus && deadlineStatus && acqStatus && freqStatus
+        && calibStatus)
       LEDs_On(LED_ORANGE);
 
+    // Each channel's window is its row of the packed sample block
     for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
-      DORThreadData[analogNb].sampleSemaphore = OS_SemaphoreCreate(0);
+    {
+      DORThreadData[analogNb] = (TDORThreadData){
+          .channelNb = analogNb,
+          .samples = SampleBlock.phase[analogNb],
+          .sumOfSquares = 0,
+          .rawSamples = RawSampleBlock.phase[analogNb],
+          .rawSumOfSquares = 0,
+          .dcOffset = 0,
+          .fundamental = {0, 0},
+          .halfCycleSamples = HalfCycleSamples[analogNb],
+          .halfCycleSum = 0,
+          .iRMS = 0,
+          .tripTime = 0.0f,
+          .tripStart = 0,
+          .tripIntegral = 0,
+          .timerStatus = TIMER_INACTIVE,
+          .tripped = false,
+      };
+    }
 
-    PIT_Set(0, PIT_PERIOD, true); // Set Pit Channel 0 1.25ms = 50Hz every clock cycle and Enable
-    PIT_Set(1, 1000000, false);   // Set Pit Channel 1 to run every 1 ms
+    for (uint8_t elementNb = 0; elementNb < NB_ELEMENTS; elementNb++)
+    {
+      ElementData[elementNb] = (TDORThreadData){
+          .channelNb = NB_ANALOG_CHANNELS + elementNb, // Deadlines follow on from the phases
+          .samples = NULL,
+          .rawSamples = NULL,
+          .halfCycleSamples = NULL,
+          .timerStatus = TIMER_INACTIVE,
+          .tripped = false,
+      };
+    }
+
+    PIT_Set(0, PIT_PERIOD / DSP_OVERSAMPLING_RATIO, true); // Set Pit Channel 0 1.25ms = 50Hz every clock cycle and Enable
     CMD_SetFlashValues();
 
     OS_EnableInterrupts();
 
+    Packet_BeginBurst();
     CMD_SendStartupPacket();
     CMD_SendVersionPacket();
     CMD_SendNumberPacket();
+    Packet_EndBurst();
 
     // Start outputs at 0
     Analog_Put(1, TIMING_SIGNAL_LOW);
@@ -218,341 +270,569 @@ static void InitThread(void *pData)
  */
 static void PacketCheckerThread(void *pData)
 {
+  TPacket packets[PACKET_BATCH_SIZE];
+
   for (;;)
   {
-    if (Packet_Get())
+    UART_InWait();
+    Profile_CountWakeup();
+
+    uint8_t nbPackets = Packet_Get(packets, PACKET_BATCH_SIZE);
+
+    for (uint8_t packetNb = 0; packetNb < nbPackets; packetNb++)
     {
+      Packet = packets[packetNb];
       CMD_PacketHandle();
     }
   }
 }
 
-/* @brief Thread for signalling each channel to take a sample
+/* @brief Thread that samples every channel on each PIT0 tick and hands the samples over in blocks
  *
  */
-static void Pit0Thread(void *pData)
+static void SamplerThread(void *pData)
 {
+  uint8_t position = 0; // Position in the half-cycle history of the high-set element
+
   for (;;)
   {
     //Wait on PIT0 Semaphore
     OS_SemaphoreWait(PIT0Semaphore, 0);
+    Profile_CountWakeup();
 
-    // Signal the analog channels to take a sample
+    uint32_t startCycles = Profile_Cycles();
+
+    int16_t analogInputValues[ACQ_NB_INPUTS];
+    bool blockComplete = Acq_Sample(analogInputValues);
+
+    // The high-set element can't wait for a block, so it runs on every sample
     for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
-      OS_SemaphoreSignal(DORThreadData[analogNb].sampleSemaphore);
+      highSetSample(&DORThreadData[analogNb], analogInputValues[analogNb], position);
+
+    position = (position + 1) % (DSP_RAW_WINDOW_SIZE / 2);
 
-    OS_SemaphoreSignal(OutputSemaphore);
+    if (blockComplete)
+      OS_SemaphoreSignal(BlockSemaphore);
+
+    Profile_Busy(Profile_Cycles() - startCycles);
   }
 }
 
-/* @brief Thread that checks for any trips
+/* @brief Thread that runs the protection on every phase once per block of samples
  *
  */
-static void Pit1Thread(void *pData)
+static void DSPThread(void *pData)
 {
+  uint8_t count = 0;
+  TAcqBlock block;
+
   for (;;)
   {
-    //Wait on PIT1 Semaphore
-    OS_SemaphoreWait(PIT1Semaphore, 0);
+    OS_SemaphoreWait(BlockSemaphore, 0);
+    Profile_CountWakeup();
 
-    for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
+    uint32_t startCycles = Profile_Cycles();
+
+    if (!Acq_Get(&block))
     {
-      // Check that a trip timer has been activated
-      if (DORThreadData[analogNb].timerStatus == TIMER_ACTIVE)
+      // Woken between blocks to act on a high-set trip or a passed deadline
+      serviceTrips();
+      updateOutputs(PIT_TimeGet());
+      continue;
+    }
+
+    for (uint8_t sampleNb = 0; sampleNb < ACQ_BLOCK_SIZE; sampleNb++)
+    {
+      uint64_t time = block.time[sampleNb];
+      int16_t analogInputValues[NB_ANALOG_CHANNELS];
+
+      for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
+      {
+        analogInputValues[analogNb] = block.input[analogNb][sampleNb];
+        processSample(&DORThreadData[analogNb], analogInputValues[analogNb], count, time);
+      }
+
+      processNeutralSample(block.input[ACQ_NEUTRAL_INPUT][sampleNb], count);
+
+      // Frequency Tracking, from the crossings of every phase
+      Freq_Update(analogInputValues, time);
+
+      count++;
+
+      // Wrap the window position, completing a cycle for every phase
+      if (count == ANALOG_WINDOW_SIZE)
       {
-        if (DORThreadData[analogNb].intervalCounter >= DORThreadData[analogNb].numberOfIntervals)
-        {
-          DORThreadData[analogNb].tripped = true;
-          DORThreadData[analogNb].intervalCounter = 0;          // Reset interval counter
-          DORThreadData[analogNb].timerStatus = TIMER_INACTIVE; // 'deactivate' timer
-        }
-        DORThreadData[analogNb].intervalCounter++;
+        count = 0;
+        refreshSumsOfSquares();
+        retuneSampling(time);
+        evaluateSequenceElements(time);
+        OS_SemaphoreSignal(HarmonicsSemaphore);
       }
     }
+
+    serviceTrips();
+    updateOutputs(block.time[ACQ_BLOCK_SIZE - 1]);
+
+    Profile_PassCycles(Profile_Cycles() - startCycles);
   }
 }
 
-/* @brief Thread that reads in data from the ADC
+/* @brief Thread that wakes the DSP thread the moment a trip deadline passes, so the trip output
+ * rises at the deadline rather than at the next block
  *
  */
-static void InputThread(void *pData)
+static void Pit1Thread(void *pData)
 {
-  TDORThreadData *data = (TDORThreadData *)pData;
-  uint8_t count = 0;
+  for (;;)
+  {
+    //Wait on PIT1 Semaphore, signalled once at the earliest deadline
+    OS_SemaphoreWait(PIT1Semaphore, 0);
+    Profile_CountWakeup();
+
+    // The DSP thread owns the trip state and the outputs, so it collects the expired deadlines
+    OS_SemaphoreSignal(BlockSemaphore);
+  }
+}
 
+/* @brief Thread that analyses the harmonics of each phase once per cycle
+ *
+ */
+static void HarmonicsThread(void *pData)
+{
   for (;;)
   {
-    int16_t analogInputValue;
-    OS_SemaphoreWait(data->sampleSemaphore, 0);
+    OS_SemaphoreWait(HarmonicsSemaphore, 0);
+    Profile_CountWakeup();
 
-    Analog_Get(data->channelNb, &analogInputValue);
+    // Take a copy of the window so sampling can carry on while we work
+    OS_DisableInterrupts();
+    TSampleBlock block = SampleBlock;
+    OS_EnableInterrupts();
 
-    // Store analog sample in samples array
-    data->samples[count] = rawToVoltage(analogInputValue);
+    uint32_t startCycles = Profile_Cycles();
 
-    // Frequency Tracking
-    frequencyTracking(data, count);
+    for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
+      DSP_Harmonics(block.phase[analogNb], &PhaseHarmonics[analogNb]);
 
-    // Filter Harmonics
-    if (SensitiveMode)
-    {
-      // Not implemented but would ideally use FFT and then an LPF
-    }
+    HarmonicsCycles = Profile_Cycles() - startCycles;
+    Profile_Busy(HarmonicsCycles);
+  }
+}
 
-    count++;
+/*!
+ * @brief Runs the instantaneous high-set element of one channel on a sample as it is taken
+ *
+ * @param data - pointer to channel target data
+ * @param analogInputValue - the raw sample just taken
+ * @param position - the position of the sample in the half-cycle history
+ */
+static void highSetSample(TDORThreadData *data, int16_t analogInputValue, uint8_t position)
+{
+  data->halfCycleSum += abs(analogInputValue);
+  data->halfCycleSum -= abs(data->halfCycleSamples[position]);
+  data->halfCycleSamples[position] = analogInputValue;
 
-    if (count == 16)
-    {
-      // Calculate iRMS
-      data->iRMS = calculateRMS(data->samples);
+  // The setting is in 0.1 A, so compare ten times the sum rather than lose the fraction of the per amp sum
+  if (HighSetCurrent && !data->tripped && data->halfCycleSum * 10 >= HighSetCurrent * highSetSumPerAmp)
+    requestHighSetTrip(data->channelNb);
+}
 
-      if (data->iRMS >= iRMSThreshold)
-        handleTrip(data);
-      else if (data->timerStatus == TIMER_ACTIVE)
-        data->timerStatus = TIMER_INACTIVE; // Deactivate the channel
+/*!
+ * @brief Runs the per-sample protection of one channel
+ *
+ * @param data - pointer to channel target data
+ * @param rawInputValue - the raw sample
+ * @param count - the window position of the sample
+ * @param time - the time the sample was taken in microseconds
+ */
+static void processSample(TDORThreadData *data, int16_t rawInputValue, uint8_t count, uint64_t time)
+{
+  // Keep the unfiltered window for comparison
+  int16_t oldRawSample = data->rawSamples[count];
+  data->rawSumOfSquares += (uint32_t)(rawInputValue * rawInputValue);
+  data->rawSumOfSquares -= (uint32_t)(oldRawSample * oldRawSample);
+  data->rawSamples[count] = rawInputValue;
+
+  // Strip any decaying DC offset so it can't inflate the RMS and bring the trip forward
+  int16_t analogInputValue = DSP_DCFilter(&data->dcOffset, rawInputValue, DCFilterShift[data->channelNb]);
+
+  // Slide the window: add the new square and remove the square of the sample it replaces
+  int16_t oldSample = data->samples[count];
+  data->sumOfSquares += (uint32_t)(analogInputValue * analogInputValue);
+  data->sumOfSquares -= (uint32_t)(oldSample * oldSample);
+
+  // Store analog sample in samples array
+  data->samples[count] = analogInputValue;
+
+  // Track the fundamental whichever mode we're in, so switching modes is seamless
+  DSP_DFTUpdate(&data->fundamental, analogInputValue, oldSample, count);
+
+  // Filter Harmonics by using the fundamental RMS rather than the true RMS
+  uint64_t sumOfSquares = data->sumOfSquares;
+  if (SensitiveMode)
+    sumOfSquares = DSP_DFTSumOfSquares(&data->fundamental);
+
+  // Calculate iRMS over the last window and check the pickup on every sample
+  data->iRMS = DSP_RMSCurrent(sumOfSquares);
+
+  if (sumOfSquares >= sumOfSquaresThreshold)
+    handleTrip(data, relayCharacteristic(), data->iRMS, time, (uint32_t)(PIT_PERIOD / 1000));
+  else
+    deactivateTimer(data);
+}
 
-      // Reset counter position
-      count = 0;
-    }
-  }
+/*!
+ * @brief Resolves the phases into symmetrical components and checks the elements worked from them
+ *
+ * @param time - the time of the latest sample in microseconds
+ */
+static void evaluateSequenceElements(uint64_t time)
+{
+  uint32_t startCycles = Profile_Cycles();
+
+  TDFTBin phases[NB_ANALOG_CHANNELS];
+  for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
+    phases[analogNb] = DORThreadData[analogNb].fundamental;
+
+  Seq_Calculate(phases, &Sequence);
+
+  NeutralCurrent = DSP_RMSCurrent(DSP_DFTSumOfSquares(&NeutralFundamental));
+
+  // The calculated residual current is three times the zero sequence current
+  uint32_t earthFaultCurrent = EarthFaultMeasured ? NeutralCurrent : 3 * Sequence.zeroCurrent;
+  RELAY_CHARACTERISTIC earthFaultCharacteristic = (EarthFaultCharacteristic <= ExtremelyInverse) ? EarthFaultCharacteristic : Inverse;
+
+  checkElement(&ElementData[NEGATIVE_SEQUENCE_ELEMENT], relayCharacteristic(), Sequence.negativeCurrent, NegativeSequencePickup, time);
+  checkElement(&ElementData[EARTH_FAULT_ELEMENT], earthFaultCharacteristic, earthFaultCurrent, EarthFaultPickup, time);
+
+  SequenceCycles = Profile_Cycles() - startCycles;
 }
 
-/* @brief Thread that outputs to the DAC
+/*!
+ * @brief Slides the neutral window and its fundamental along by one sample
  *
+ * @param analogInputValue - the raw neutral sample
+ * @param count - the window position of the sample
  */
-static void OutputThread(void *pData)
+static void processNeutralSample(int16_t analogInputValue, uint8_t count)
 {
-  for (;;)
+  // Only the fundamental is used, so harmonics in the neutral don't cause pickup
+  DSP_DFTUpdate(&NeutralFundamental, analogInputValue, NeutralSamples[count], count);
+  NeutralSamples[count] = analogInputValue;
+}
+
+/*!
+ * @brief Checks an element's current against its pickup once a cycle and runs its trip timer
+ *
+ * @param elementData - pointer to element target data
+ * @param characteristic - the element's IDMT characteristic
+ * @param current - the element's RMS current in Q16.16 amps
+ * @param pickup - the pickup setting in 0.1 A, 0 to disable the element
+ * @param time - the time of the latest sample in microseconds
+ */
+static void checkElement(TDORThreadData *elementData, RELAY_CHARACTERISTIC characteristic, uint32_t current, uint8_t pickup, uint64_t time)
+{
+  if (pickup == 0)
   {
-    OS_SemaphoreWait(OutputSemaphore, 0);
+    elementData->iRMS = 0;
+    deactivateTimer(elementData);
+    return;
+  }
 
-    uint8_t timingChannels = 0; // Counts the number of channels over the iRMS threshold
-    uint8_t tripChannels = 0;
+  // The characteristics are defined in multiples of the setting, picking up at 1.03 times
+  uint64_t multiple = ((uint64_t)current * 10) / pickup;
+  elementData->iRMS = (multiple > UINT32_MAX) ? UINT32_MAX : (uint32_t)multiple;
 
-    // For each channel..
-    for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
+  if (elementData->iRMS >= iRMSThreshold)
+    handleTrip(elementData, characteristic, elementData->iRMS, time, (uint32_t)(PIT_PERIOD * ANALOG_WINDOW_SIZE / 1000));
+  else
+    deactivateTimer(elementData);
+}
+
+/*!
+ * @brief Updates the timing and trip outputs from the state of every channel, and tells the PC
+ * the moment the trip output goes high
+ *
+ * @param time - the time of the latest sample in microseconds
+ */
+static void updateOutputs(uint64_t time)
+{
+  uint8_t timingChannels = 0; // Counts the number of channels over the iRMS threshold
+  uint8_t tripChannels = 0;
+  FAULT elementFault = NoFault;
+  uint8_t faulted = 0; // Tripped phases, then elements, one bit each
+  uint64_t firstPickup = 0; // Earliest pickup of a tripped timer, 0 if only the high-set tripped
+  bool tripRaised = false;
+
+  // For each channel..
+  for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
+  {
+    // If any of the channels have breached the threshold...
+    if (DORThreadData[analogNb].iRMS >= iRMSThreshold)
     {
-      // If any of the channels have breached the threshold...
-      if (DORThreadData[analogNb].iRMS >= iRMSThreshold)
-      {
-        timingChannels++;
-      }
+      timingChannels++;
+    }
 
-      // If any of the channels have tripped...
-      if (DORThreadData[analogNb].tripped)
+    // If any of the channels have tripped...
+    if (DORThreadData[analogNb].tripped)
+    {
+      tripChannels++;
+      faulted |= 1 << analogNb;
+      if (DORThreadData[analogNb].tripStart != 0 && (firstPickup == 0 || DORThreadData[analogNb].tripStart < firstPickup))
+        firstPickup = DORThreadData[analogNb].tripStart;
+
+      if (TripOutputSignal == OUTPUT_LOW)
       {
-        tripChannels++;
-
-        if (TripOutputSignal == OUTPUT_LOW)
-        {
-          Analog_Put(1, voltageToRaw(5.00)); // Activate Trip Signal
-          PMcL_Flash_Write16((uint16_t volatile *)NumberOfTrips, (uint16_t)*NumberOfTrips + 1);
-          TripOutputSignal = OUTPUT_HIGH;
-        }
+        Analog_Put(1, OUTPUT_SIGNAL_5V); // Activate Trip Signal
+        PMcL_Flash_Write16((uint16_t volatile *)NumberOfTrips, (uint16_t)*NumberOfTrips + 1);
+        TripOutputSignal = OUTPUT_HIGH;
+        tripRaised = true;
       }
     }
+  }
 
-    // If there channels with thresholds greater than 1.03
-    // And the output isn't high already..
-    if (timingChannels > 0 && TimingOutputSignal == OUTPUT_LOW)
-    {
-      Analog_Put(0, voltageToRaw(5.00)); // Set Timing output to 5V
-      TimingOutputSignal = OUTPUT_HIGH;
-    }
-    else if (timingChannels == 0) // No channels above threshold
+  // The sequence elements drive the same outputs as the phases
+  for (uint8_t elementNb = 0; elementNb < NB_ELEMENTS; elementNb++)
+  {
+    if (ElementData[elementNb].iRMS >= iRMSThreshold)
+      timingChannels++;
+
+    if (ElementData[elementNb].tripped)
     {
-      // If not already low..
-      if (TimingOutputSignal == OUTPUT_HIGH)
-      {
-        Analog_Put(0, 0); // Reset Timing output
-        TimingOutputSignal = OUTPUT_LOW;
-      }
+      elementFault = (elementNb == NEGATIVE_SEQUENCE_ELEMENT) ? NegativeSequence : EarthFault;
+      faulted |= 1 << (NB_ANALOG_CHANNELS + elementNb);
+      if (ElementData[elementNb].tripStart != 0 && (firstPickup == 0 || ElementData[elementNb].tripStart < firstPickup))
+        firstPickup = ElementData[elementNb].tripStart;
 
-      // If not already low..
-      if (TripOutputSignal == OUTPUT_HIGH)
+      if (TripOutputSignal == OUTPUT_LOW)
       {
-        Analog_Put(1, 0); // Reset Trip output
-        resetDOR();       // Reset DOR
-        TripOutputSignal = OUTPUT_LOW;
+        Analog_Put(1, OUTPUT_SIGNAL_5V); // Activate Trip Signal
+        PMcL_Flash_Write16((uint16_t volatile *)NumberOfTrips, (uint16_t)*NumberOfTrips + 1);
+        TripOutputSignal = OUTPUT_HIGH;
+        tripRaised = true;
       }
     }
+  }
+
+  // Push the event rather than wait to be polled for it, holding the currents at the trip
+  if (tripRaised)
+  {
+    TripEventPending = true;
+    TripEventFaulted = faulted;
+    TripEventTime = firstPickup ? time - firstPickup : 0;
+    for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
+      TripEventCurrents[analogNb] = DORThreadData[analogNb].iRMS;
+  }
+
+  // Try again on each pass until there is room for it
+  if (TripEventPending)
+    TripEventPending = !CMD_SendDORTripPacket(TripEventFaulted, TripEventTime, TripEventCurrents);
 
-    if (tripChannels > 0)
+  // If there channels with thresholds greater than 1.03
+  // And the output isn't high already..
+  if (timingChannels > 0 && TimingOutputSignal == OUTPUT_LOW)
+  {
+    Analog_Put(0, OUTPUT_SIGNAL_5V); // Set Timing output to 5V
+    TimingOutputSignal = OUTPUT_HIGH;
+  }
+  else if (timingChannels == 0) // No channels above threshold
+  {
+    // If not already low..
+    if (TimingOutputSignal == OUTPUT_HIGH)
+    {
+      Analog_Put(0, 0); // Reset Timing output
+      TimingOutputSignal = OUTPUT_LOW;
+    }
+
+    // If not already low..
+    if (TripOutputSignal == OUTPUT_HIGH)
     {
-      LastFault = tripChannels;
+      Analog_Put(1, 0); // Reset Trip output
+      resetDOR();       // Reset DOR
+      TripOutputSignal = OUTPUT_LOW;
     }
   }
+
+  if (tripChannels > 0)
+  {
+    LastFault = tripChannels;
+  }
+  else if (elementFault != NoFault)
+  {
+    LastFault = elementFault;
+  }
 }
 
 /*!
- * @brief Calculates a new PIT period by using zero crossing and linear interpolation to find
- * the time between two zero crossings.
+ * @brief Fits the frequency to the latest zero crossings and retunes the sample rate to it
  *
- * @param pointer to channel target data
- * @param uint8_t - integer representing number of samples taken
+ * @param time - the time of the latest sample in microseconds
  */
-static void frequencyTracking(TDORThreadData *channelData, uint8_t count)
+static void retuneSampling(uint64_t time)
 {
-  // Frequency Tracking (only on channel 0)
-  if (channelData->channelNb == 0)
+  if (Freq_Estimate(time))
   {
-    if (count != 0)
-    {
-      if (channelData->samples[count] > 0 && channelData->samples[count - 1] < 0)
-      {
-        switch (channelData->crossingNb)
-        {
-        case 1:
-          channelData->offset1 = calculateTimeOffset(channelData->samples[count - 1], channelData->samples[count]);
-          channelData->sampleOffset = 0; // Reset sample offset
-          channelData->crossingNb = 2;   // We've found the first zero crossing, find the next..
-          break;
-        case 2:
-          channelData->offset2 = calculateTimeOffset(channelData->samples[count - 1], channelData->samples[count]);
-          double new_period = (channelData->sampleOffset - channelData->offset1 + channelData->offset2) * ((float)PIT_PERIOD / 1e9); // Period of wave in s
-          double frequency = (1 / (new_period));                                                                                     // Calculate frequency
-
-          // Filter 'bad' frequencies
-          if (frequency >= 47.5 && frequency <= 52.5)
-          {
-            Frequency = frequency;                     // Set global frequency
-            PIT_PERIOD = ((1 / frequency) / 16) * 1e9; // Period in nanoseconds
-            PIT_Set(0, PIT_PERIOD, true);              // Redefine PIT period and restart
-          }
-          channelData->crossingNb = 1;
-          break;
-        }
-      }
-    }
-    // Increment sample offset
-    channelData->sampleOffset++;
+    Frequency = Freq_Get();                                  // Set global frequency
+    PIT_PERIOD = (1e9f / Frequency) / ANALOG_WINDOW_SIZE;    // Processed sample period in nanoseconds
+    PIT_Set(0, PIT_PERIOD / DSP_OVERSAMPLING_RATIO, false); // Reloads at the next tick, so sample spacing isn't disturbed
+  }
+  else if (!Freq_Locked())
+  {
+    Frequency = 0; // Report no lock, and keep sampling at the last rate until the signal returns
   }
 }
 
 /*!
  * @brief Handles the tripping of a signal when iRMS >= 1.03
  *
+ * Integrates 1/t(I) over each sample period, so a varying fault current trips when the
+ * accumulated fraction of the trip time reaches one, as in IEC 60255-151.
+ *
  * @param channelData - pointer to channel target data
+ * @param characteristic - the IDMT characteristic to time with
+ * @param current - the current in Q16.16 multiples of the setting
+ * @param time - the time the sample was taken in microseconds
+ * @param period - the time since the previous evaluation in microseconds
  */
-static void handleTrip(TDORThreadData *channelData)
+static void handleTrip(TDORThreadData *channelData, RELAY_CHARACTERISTIC characteristic, uint32_t current, uint64_t time, uint32_t period)
 {
-  double time;
   // Check that the channel hasn't already 'tripped'
   if (channelData->tripped == false)
   {
-    time = calculateTiming(channelData->iRMS);
-    switch (channelData->timerStatus)
+    uint32_t rate = IDMT_TripRate(characteristic, current);
+    uint64_t increment = (uint64_t)rate * period; // Fraction of the trip time in this period
+    // Timer is currently inactive, so this sample is the pickup
+    if (channelData->timerStatus == TIMER_INACTIVE)
     {
-    // Timer is currently inactive
-    case TIMER_INACTIVE:
-      channelData->numberOfIntervals = (time * 1000); // Determine number of intervals [ (triptime (ms) / PIT1 interval (=1ms) ]
-      PIT_Enable(1, true);                            // Start PIT
-      channelData->tripTime = time;                   // Update threadData trip time
-      channelData->timerStatus = TIMER_ACTIVE;        // Update Timer Status
-      break;
-
-    // Timer is currently active, might need to modify the numberOfIntervals based on inverse timing mechanism
-    case TIMER_ACTIVE:
-      // If the new time is within a 1 second threshold, ignore it
-      if (abs(time - channelData->tripTime) >= inverseTimingThreshold)
-      {
-        PIT_Enable(1, false);                                                                                                   // Disable PIT while modifying values Should I be disabling PIT, what about other channels?, However the PIT thread could override while performing these adjustments
-        channelData->numberOfIntervals = (1 - (channelData->intervalCounter / channelData->numberOfIntervals)) * (time * 1000); //Determine number of intervals [ (triptime (ms) / PIT1 interval (=1ms) ]
-        channelData->intervalCounter = 0;                                                                                       // Reset interval counter
-        channelData->tripTime = time;                                                                                           // Store latest trip time in thread data
-        PIT_Enable(1, true);                                                                                                    // Re-enable PIT
-      }
-      break;
+      channelData->tripStart = time;
+      channelData->tripIntegral = 0;
+      channelData->timerStatus = TIMER_ACTIVE; // Update Timer Status
+    }
+
+    channelData->tripIntegral += increment;
+    channelData->tripTime = rate ? (float)IDMT_RATE_ONE / rate : INFINITY; // Update threadData trip time
+
+    if (channelData->tripIntegral >= TRIP_INTEGRAL_UNITY)
+    {
+      channelData->tripped = true;
+      channelData->timerStatus = TIMER_INACTIVE; // 'deactivate' timer
+      Deadline_Cancel(channelData->channelNb);
+    }
+    // The integral will reach one before the next evaluation, so wake at the exact instant
+    else if (channelData->tripIntegral + increment >= TRIP_INTEGRAL_UNITY)
+    {
+      Deadline_Set(channelData->channelNb, time + (TRIP_INTEGRAL_UNITY - channelData->tripIntegral) / rate);
     }
   }
 }
 
 /*!
- * @brief Uses linear interpolation to calculate time offset
+ * @brief Gets the relay characteristic set in flash
  *
- * @param sample1 - the first sample
- * @param sample2 - the second sample
- * @return float - time offset in ms
+ * @return RELAY_CHARACTERISTIC - the characteristic, Inverse if the flash hasn't been set
  */
-static float calculateTimeOffset(float sample1, float sample2)
+static RELAY_CHARACTERISTIC relayCharacteristic()
 {
-  float gradient = sample2 - sample1;
-  float timeOffset = ((-sample1) / gradient);
-  return timeOffset;
+  return (*RelayCharacteristic <= ExtremelyInverse) ? *RelayCharacteristic : Inverse;
 }
 
-/*
- * @brief srt using fast inverse square root function from https://codegolf.stackexchange.com/a/85556
+/*!
+ * @brief Stops a channel's trip timer once its current drops below pickup
  *
- * @param n - the float value to sqrt
- * @return y - the sqrt of n
+ * @param channelData - pointer to channel target data
  */
-static float fsqrt(float n)
+static void deactivateTimer(TDORThreadData *channelData)
 {
-  n = 1.0f / n; // Invert so we get the sqrt of the number we actually want
-  long i;
-  float x, y;
-
-  x = n * 0.5f;
-  y = n;
-  i = *(long *)&y;
-  i = 0x5f3759df - (i >> 1);
-  y = *(float *)&i;
-  y = y * (1.5f - (x * y * y));
-
-  return y;
+  if (channelData->timerStatus == TIMER_ACTIVE)
+  {
+    channelData->timerStatus = TIMER_INACTIVE; // Deactivate the channel
+    channelData->tripIntegral = 0;             // Reset instantaneously once the current drops out
+    Deadline_Cancel(channelData->channelNb);
+  }
 }
 
 /*!
- * @brief Converts analogue input into voltage in Volts
+ * @brief Trips a channel whose half-cycle current has exceeded the high-set setting
  *
- * @param raw - the analogue value to convert
- * @return float - voltage value
+ * @param channelData - pointer to channel target data
  */
-static float rawToVoltage(int16_t raw)
+static void handleHighSetTrip(TDORThreadData *channelData)
 {
-  return ((float)raw * 20) / pow(2, 16);
+  channelData->tripped = true;
+  channelData->timerStatus = TIMER_INACTIVE; // The IDMT timer is no longer needed
+  Deadline_Cancel(channelData->channelNb);
 }
 
 /*!
- * @brief Converts analogue input into voltage in Volts
+ * @brief Asks the DSP thread to trip a phase on its high-set element, and wakes it at once
  *
- * @param voltage - the voltage to convert
- * @return float - voltage value
+ * @param channelNb - the phase
  */
-static uint16_t voltageToRaw(float voltage)
+static void requestHighSetTrip(uint8_t channelNb)
 {
-  return (uint16_t)((voltage * pow(2, 16)) / 20);
+  OS_DisableInterrupts();
+  bool posted = HighSetRequests & (1 << channelNb);
+  HighSetRequests |= 1 << channelNb;
+  OS_EnableInterrupts();
+
+  // One wakeup per request, however many samples stay over the setting before it is acted on
+  if (!posted)
+    OS_SemaphoreSignal(BlockSemaphore);
 }
 
 /*!
- * @brief Calculates i RMS based on voltage samples
- *
- * @param values[] the array of voltage samples
- * @return float iRMS
+ * @brief Trips the phases the sampler has asked to, and the channels whose trip deadlines have
+ * passed, ready for updateOutputs to raise the trip output
  */
-static float calculateRMS(float values[])
+static void serviceTrips()
 {
-  float sumOfVoltages = 0;
+  OS_DisableInterrupts();
+  uint8_t highSet = HighSetRequests;
+  HighSetRequests = 0;
+  OS_EnableInterrupts();
+
+  uint8_t expired = Deadline_Expired();
 
-  int i;
-  for (i = 0; i < ANALOG_WINDOW_SIZE; i++)
+  for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
   {
-    sumOfVoltages += (values[i] * values[i]);
+    if ((highSet & (1 << analogNb)) && !DORThreadData[analogNb].tripped)
+      handleHighSetTrip(&DORThreadData[analogNb]);
+
+    // Check that the trip timer is still active
+    if ((expired & (1 << analogNb)) && DORThreadData[analogNb].timerStatus == TIMER_ACTIVE)
+    {
+      DORThreadData[analogNb].tripped = true;
+      DORThreadData[analogNb].timerStatus = TIMER_INACTIVE; // 'deactivate' timer
+    }
   }
 
-  return (fsqrt(((float)sumOfVoltages) / ANALOG_WINDOW_SIZE) / 0.35);
+  for (uint8_t elementNb = 0; elementNb < NB_ELEMENTS; elementNb++)
+  {
+    if ((expired & (1 << ElementData[elementNb].channelNb)) && ElementData[elementNb].timerStatus == TIMER_ACTIVE)
+    {
+      ElementData[elementNb].tripped = true;
+      ElementData[elementNb].timerStatus = TIMER_INACTIVE;
+    }
+  }
 }
 
 /*!
- * @brief Calculates trip time based on iRMS value, formula and values from https://www.jcalc.net/idmt-relay-trip-time-calculator
- *
- * @param iRMS - The RMS value
- * @return double - trip time
+ * @brief Recalculates the running sums of squares of all phases from the sample block, so a
+ * sample written outside the sliding update cannot bias the RMS for more than one cycle
  */
-static double calculateTiming(double iRMS)
+static void refreshSumsOfSquares()
 {
-  return (k[relayCharacteristic] / (pow(iRMS, a[relayCharacteristic]) - 1));
+  uint64_t sums[DSP_NB_PHASES];
+  uint64_t rawSums[DSP_NB_PHASES];
+
+  DSP_SumOfSquares(&SampleBlock, sums);
+  DSP_SumOfSquares(&RawSampleBlock, rawSums);
+
+  for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
+  {
+    DORThreadData[analogNb].sumOfSquares = sums[analogNb];
+    DORThreadData[analogNb].rawSumOfSquares = rawSums[analogNb];
+  }
 }
 
 /*!
@@ -560,33 +840,38 @@ static double calculateTiming(double iRMS)
  */
 static void resetDOR()
 {
-  // Disable PITs while resetting
+  // Disable sampling while resetting
   PIT_Enable(0, false);
-  PIT_Enable(1, false);
 
   // Restore each DOR channel data to initial state
   for (uint8_t analogNb = 0; analogNb < NB_ANALOG_CHANNELS; analogNb++)
   {
-    resetChannel(analogNb);
+    resetChannel(&DORThreadData[analogNb]);
+  }
+
+  for (uint8_t elementNb = 0; elementNb < NB_ELEMENTS; elementNb++)
+  {
+    resetChannel(&ElementData[elementNb]);
   }
 
-  // Re-enable PITs
+  // Re-enable sampling
   PIT_Enable(0, true);
-  PIT_Enable(1, true);
 }
 
 /*!
  * @brief Reset single DOR channel
+ *
+ * @param channelData - pointer to channel target data
  */
-static void resetChannel(uint8_t channel)
+static void resetChannel(TDORThreadData *channelData)
 {
-  DORThreadData[channel].intervalCounter = 0;
-  DORThreadData[channel].iRMS = 0.0;
-  DORThreadData[channel].tripTime = 0.0;
-  DORThreadData[channel].intervalCounter = 0;
-  DORThreadData[channel].numberOfIntervals = 0;
-  DORThreadData[channel].timerStatus = TIMER_INACTIVE;
-  DORThreadData[channel].tripped = false;
+  channelData->iRMS = 0;
+  channelData->tripTime = 0.0f;
+  channelData->tripStart = 0;
+  channelData->tripIntegral = 0;
+  channelData->timerStatus = TIMER_INACTIVE;
+  Deadline_Cancel(channelData->channelNb);
+  channelData->tripped = false;
 }
 
 /*lint -save  -e970 Disable MISRA rule (6.3) checking. */
@@ -602,23 +887,17 @@ int main(void)
   /* Write your code here */
   OS_Init(CPU_CORE_CLK_HZ, false);
 
-  OutputSemaphore = OS_SemaphoreCreate(0);
+  BlockSemaphore = OS_SemaphoreCreate(0);
+  HarmonicsSemaphore = OS_SemaphoreCreate(0);
 
   OS_ERROR error;
 
   error = OS_ThreadCreate(InitThread, NULL, &InitThreadStack[THREAD_STACK_SIZE - 1], 0);
-  error = OS_ThreadCreate(RxThread, NULL, &RxThreadStack[THREAD_STACK_SIZE - 1], 1);
-  error = OS_ThreadCreate(TxThread, NULL, &TxThreadStack[THREAD_STACK_SIZE - 1], 2);
-
-  const uint8_t ANALOG_THREAD_PRIORITIES[NB_ANALOG_CHANNELS] = {3, 4, 5};
-
-  for (uint8_t threadNb = 0; threadNb < NB_ANALOG_CHANNELS; threadNb++)
-  {
-    error = OS_ThreadCreate(InputThread, &DORThreadData[threadNb], &InputThreadStacks[threadNb][THREAD_STACK_SIZE * 2 - 1], ANALOG_THREAD_PRIORITIES[threadNb]);
-  }
-
-  error = OS_ThreadCreate(PacketCheckerThread, NULL, &PacketCheckerThreadStack[THREAD_STACK_SIZE - 1], 6);
-  error = OS_ThreadCreate(OutputThread, NULL, &OutputThreadStack[THREAD_STACK_SIZE - 1], 7);
+  error = OS_ThreadCreate(SamplerThread, NULL, &SamplerThreadStack[THREAD_STACK_SIZE - 1], 1);
+  error = OS_ThreadCreate(Pit1Thread, NULL, &Pit1ThreadStack[THREAD_STACK_SIZE - 1], 2);
+  error = OS_ThreadCreate(DSPThread, NULL, &DSPThreadStack[THREAD_STACK_SIZE * 2 - 1], 5);
+  error = OS_ThreadCreate(PacketCheckerThread, NULL, &PacketCheckerThreadStack[THREAD_STACK_SIZE * 4 - 1], 6);
+  error = OS_ThreadCreate(HarmonicsThread, NULL, &HarmonicsThreadStack[THREAD_STACK_SIZE * 2 - 1], 7);
 
   OS_Start();
 
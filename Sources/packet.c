@@ -15,10 +15,11 @@
 #include "packet.h"
 #include "UART.h"
 #include "Cpu.h"
-#include "OS.h"
 
-static uint8_t PacketPosition = 0;
-static uint8_t PacketChecksum;
+// The last bytes received, which are checked as a packet once there are enough of them
+static uint8_t Window[PACKET_NB_BYTES];
+static uint8_t WindowCount;
+static uint8_t WindowChecksum; /*!< XOR of the bytes in the window */
 
 TPacket Packet;
 const uint8_t PACKET_ACK_MASK = 0x80;
@@ -41,81 +42,85 @@ bool Packet_Init(const uint32_t baudRate, const uint32_t moduleClk)
   return UART_Init(baudRate, moduleClk);
 }
 
-bool Packet_Get(void)
+uint8_t Packet_Get(TPacket packets[], const uint8_t maxPackets)
 {
-  OS_DisableInterrupts();
+  uint8_t nbPackets = 0;
 
-  static uint8_t Position = 0;
-  uint8_t uartData;
-  if (!UART_InChar(&uartData))
+  while (nbPackets < maxPackets)
   {
-    OS_EnableInterrupts();
-    return false;
-  }
-  switch (Position)
-  {
-  case 0:
-    Packet_Command = uartData;
-    Position++;
-    OS_EnableInterrupts();
-    return false;
-  case 1:
-    Packet_Parameter1 = uartData;
-    Position++;
-    OS_EnableInterrupts();
-    return false;
-  case 2:
-    Packet_Parameter2 = uartData;
-    Position++;
-    OS_EnableInterrupts();
-    return false;
-  case 3:
-    Packet_Parameter3 = uartData;
-    Position++;
-    OS_EnableInterrupts();
-    return false;
-  case 4:
-    // test the checksum
-    if (uartData == CalcChecksum(Packet_Command, Packet_Parameter1, Packet_Parameter2, Packet_Parameter3))
+    // Each packet needs at least a window's worth of new bytes, less those already held, so taking no
+    // more than this can't complete more packets than there is room for, and no byte is ever read and
+    // then dropped. A full window only holds a packet's worth less one, as its oldest byte goes next.
+    uint8_t data[PACKET_NB_BYTES * 4];
+    uint8_t nbHeld = (WindowCount < PACKET_NB_BYTES) ? WindowCount : PACKET_NB_BYTES - 1;
+    uint16_t nbWanted = (uint16_t)(maxPackets - nbPackets) * PACKET_NB_BYTES - nbHeld;
+    if (nbWanted > sizeof(data))
+      nbWanted = sizeof(data);
+
+    uint16_t nbBytes = UART_InChars(data, nbWanted);
+    if (nbBytes == 0)
+      break;
+
+    for (uint16_t byteNb = 0; byteNb < nbBytes; byteNb++)
     {
-      Position = 0;
-      OS_EnableInterrupts();
-      return true;
+      // Slide the window along by one byte once it is full
+      if (WindowCount == PACKET_NB_BYTES)
+      {
+        WindowChecksum ^= Window[0];
+        for (uint8_t i = 1; i < PACKET_NB_BYTES; i++)
+          Window[i - 1] = Window[i];
+        WindowCount--;
+      }
+
+      Window[WindowCount++] = data[byteNb];
+      WindowChecksum ^= data[byteNb];
+
+      // The checksum is the XOR of the other four bytes, so a valid packet XORs to zero
+      if (WindowCount == PACKET_NB_BYTES && WindowChecksum == 0)
+      {
+        for (uint8_t i = 0; i < PACKET_NB_BYTES; i++)
+          packets[nbPackets].bytes[i] = Window[i];
+
+        nbPackets++;
+        WindowCount = 0;
+      }
     }
-    Packet_Command = Packet_Parameter1;
-    Packet_Parameter1 = Packet_Parameter2;
-    Packet_Parameter2 = Packet_Parameter3;
-    Packet_Parameter3 = uartData;
-    OS_EnableInterrupts();
-    return false;
-  default:
-    //reset the counter
-    Position = 0;
-    OS_EnableInterrupts();
-    return false;
   }
 
-  OS_EnableInterrupts();
-  return false;
+  return nbPackets;
 }
 
 bool Packet_Put(const uint8_t command, const uint8_t parameter1, const uint8_t parameter2, const uint8_t parameter3)
 {
-  //If there is an error (false) in UART_OutChar, return a false
+  // Queue the whole packet, checksum included, in one go
+  const uint8_t packet[5] = {command, parameter1, parameter2, parameter3, CalcChecksum(command, parameter1, parameter2, parameter3)};
 
-  if (!UART_OutChar(command))
-    return false;
-  if (!UART_OutChar(parameter1))
-    return false;
-  if (!UART_OutChar(parameter2))
-    return false;
-  if (!UART_OutChar(parameter3))
-    return false;
+  return UART_OutChars(packet, sizeof(packet));
+}
 
-  if (!UART_OutChar(CalcChecksum(command, parameter1, parameter2, parameter3))) // Sending the checksum
-    return false;
+bool Packet_PutUrgent(TPacket packets[], const uint8_t nbPackets)
+{
+  for (uint8_t packetNb = 0; packetNb < nbPackets; packetNb++)
+  {
+    TPacket *packet = &packets[packetNb];
+    packet->packetStruct.checksum = CalcChecksum(packet->packetStruct.command,
+                                                 packet->packetStruct.parameters.separate.parameter1,
+                                                 packet->packetStruct.parameters.separate.parameter2,
+                                                 packet->packetStruct.parameters.separate.parameter3);
+  }
+
+  // The packets are packed, so the array is the bytes to send
+  return UART_OutUrgent(packets[0].bytes, nbPackets * PACKET_NB_BYTES);
+}
 
-  return true; // All sent fine
+void Packet_BeginBurst(void)
+{
+  UART_BeginBurst();
+}
+
+void Packet_EndBurst(void)
+{
+  UART_EndBurst();
 }
 
 /*!
@@ -72,11 +72,17 @@ extern const uint8_t PACKET_ACK_MASK;
  */
 bool Packet_Init(const uint32_t baudRate, const uint32_t moduleClk);
 
-/*! @brief Attempts to get a packet from the received data.
+/*! @brief Gets the packets completed by the bytes received so far, without waiting.
  *
- *  @return bool - TRUE if a valid packet was received.
+ *  The last PACKET_NB_BYTES bytes are checked as a packet as each byte arrives, so after a lost or
+ *  corrupted byte the parser locks back on at the first valid packet. Bytes that don't make up a
+ *  packet are kept for the next call.
+ *  @param packets A place to put the packets, oldest first.
+ *  @param maxPackets The most packets to get.
+ *  @return uint8_t - The number of packets got.
+ *  @note Call from a single thread only. Never masks interrupts.
  */
-bool Packet_Get(void);
+uint8_t Packet_Get(TPacket packets[], const uint8_t maxPackets);
 
 /*! @brief Builds a packet and places it in the transmit FIFO buffer.
  *
@@ -84,4 +90,23 @@ bool Packet_Get(void);
  */
 bool Packet_Put(const uint8_t command, const uint8_t parameter1, const uint8_t parameter2, const uint8_t parameter3);
 
+/*! @brief Sends packets ahead of any already queued, together and without waiting.
+ *
+ *  @param packets The packets to send, whose checksums are filled in here.
+ *  @param nbPackets The number of packets.
+ *  @return bool - TRUE if the packets were queued.
+ *  @note May be called from any thread, while another is putting packets.
+ */
+bool Packet_PutUrgent(TPacket packets[], const uint8_t nbPackets);
+
+/*! @brief Starts a burst, so the packets put until Packet_EndBurst are sent together.
+ *
+ */
+void Packet_BeginBurst(void);
+
+/*! @brief Ends a burst and starts sending it.
+ *
+ */
+void Packet_EndBurst(void);
+
 #endif
@@ -0,0 +1,115 @@
+/*! @file profile.c
+ *
+ *  @brief routines for measuring execution time
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup profile_module profile module documentation
+**  @{
+*/
+
+#include "profile.h"
+#include "MK70F12.h"
+#include "OS.h"
+
+// Trace enable bit in the Debug Exception and Monitor Control Register
+#define DEMCR_TRCENA_MASK (1UL << 24)
+
+// Cycle counter enable bit in the DWT control register
+#define DWT_CTRL_CYCCNTENA_MASK (1UL << 0)
+
+static uint32_t CoreClock;        /*!< Cycles in a one second wakeup count window */
+static uint32_t WindowStart;      /*!< Cycle count at the start of the current window */
+static uint32_t Wakeups;          /*!< Wakeups counted in the current window */
+static uint32_t WakeupsPerSecond; /*!< Wakeups counted in the last completed window */
+static uint64_t Busy;             /*!< Signal path cycles in the current window */
+static uint16_t Load;             /*!< CPU load over the last completed window in 0.01% */
+static uint32_t LastPassCycles;
+static uint32_t MaxPassCycles;
+
+bool Profile_Init(const uint32_t coreClock)
+{
+  CoreClock = coreClock;
+  WindowStart = 0;
+  Wakeups = 0;
+  WakeupsPerSecond = 0;
+  Busy = 0;
+  Load = 0;
+  LastPassCycles = 0;
+  MaxPassCycles = 0;
+
+  DEMCR |= DEMCR_TRCENA_MASK; // Enable the DWT unit
+  DWT_CYCCNT = 0;
+  DWT_CTRL |= DWT_CTRL_CYCCNTENA_MASK; // Start counting cycles
+
+  return (DWT_CTRL & DWT_CTRL_CYCCNTENA_MASK) != 0;
+}
+
+uint32_t Profile_Cycles(void)
+{
+  return DWT_CYCCNT;
+}
+
+void Profile_CountWakeup(void)
+{
+  OS_DisableInterrupts();
+
+  uint32_t now = DWT_CYCCNT;
+  Wakeups++;
+
+  // Close the window once a second has passed (unsigned subtraction copes with the counter wrapping)
+  if (now - WindowStart >= CoreClock)
+  {
+    WakeupsPerSecond = Wakeups;
+    Wakeups = 0;
+    uint64_t load = (Busy * 10000) / (now - WindowStart);
+    Load = (load > 10000) ? 10000 : (uint16_t)load; // A pass straddling the window edge can push it over
+    Busy = 0;
+    WindowStart = now;
+  }
+
+  OS_EnableInterrupts();
+}
+
+void Profile_Busy(const uint32_t cycles)
+{
+  OS_DisableInterrupts();
+  Busy += cycles;
+  OS_EnableInterrupts();
+}
+
+uint16_t Profile_Load(void)
+{
+  return Load;
+}
+
+void Profile_PassCycles(const uint32_t cycles)
+{
+  Profile_Busy(cycles);
+  LastPassCycles = cycles;
+
+  if (cycles > MaxPassCycles)
+    MaxPassCycles = cycles;
+}
+
+uint32_t Profile_WakeupsPerSecond(void)
+{
+  return WakeupsPerSecond;
+}
+
+uint32_t Profile_LastPassCycles(void)
+{
+  return LastPassCycles;
+}
+
+uint32_t Profile_MaxPassCycles(void)
+{
+  return MaxPassCycles;
+}
+
+/*!
+** @}
+*/
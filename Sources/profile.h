@@ -0,0 +1,74 @@
+/*! @file
+ *
+ *  @brief Routines for measuring execution time with the Cortex-M4 cycle counter.
+ *
+ *  This contains the functions for operating the DWT cycle counter.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// new types
+#include "types.h"
+
+/*! @brief Enables the cycle counter before first use.
+ *
+ *  @param coreClock The core clock rate in Hz, used to time the wakeup count windows.
+ *  @return bool - TRUE if the cycle counter was successfully enabled.
+ */
+bool Profile_Init(const uint32_t coreClock);
+
+/*! @brief Gets the current cycle count.
+ *
+ *  @return uint32_t - The number of core clock cycles since the counter was enabled, wrapping at 2^32.
+ *  @note Assumes that Profile_Init has been called.
+ */
+uint32_t Profile_Cycles(void);
+
+/*! @brief Counts a thread wakeup towards the wakeups per second figure.
+ *
+ *  @note Call at the top of each thread loop, after the thread is woken.
+ */
+void Profile_CountWakeup(void);
+
+/*! @brief Records the cycles taken by one processing pass of the DSP thread.
+ *
+ *  @param cycles The core clock cycles spent in the pass.
+ */
+void Profile_PassCycles(const uint32_t cycles);
+
+/*! @brief Adds cycles spent on the signal path to the CPU load figure.
+ *
+ *  @param cycles The core clock cycles spent.
+ *  @note Profile_PassCycles counts its cycles towards the load itself.
+ */
+void Profile_Busy(const uint32_t cycles);
+
+/*! @brief Gets the share of the CPU taken by the signal path over the last whole second.
+ *
+ *  @return uint16_t - The CPU load in 0.01%.
+ */
+uint16_t Profile_Load(void);
+
+/*! @brief Gets the number of thread wakeups over the last whole second.
+ *
+ *  @return uint32_t - The wakeups counted in the last completed one second window.
+ */
+uint32_t Profile_WakeupsPerSecond(void);
+
+/*! @brief Gets the cycles taken by the most recent processing pass.
+ *
+ *  @return uint32_t - The cycles recorded by the last call to Profile_PassCycles.
+ */
+uint32_t Profile_LastPassCycles(void);
+
+/*! @brief Gets the worst case cycles taken by a processing pass.
+ *
+ *  @return uint32_t - The largest number of cycles recorded since Profile_Init.
+ */
+uint32_t Profile_MaxPassCycles(void);
+
+#endif
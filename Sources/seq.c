@@ -0,0 +1,71 @@
+/*! @file seq.c
+ *
+ *  @brief routines for calculating symmetrical components
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup seq_module seq module documentation
+**  @{
+*/
+
+#include "seq.h"
+
+// The operator a = -1/2 + j * sqrt(3)/2 in Q15
+#define A_RE (-16384)
+#define A_IM 28378
+
+// Rounds a Q15 product back to an integer
+#define Q15_ROUND(product) (int32_t)(((product) + (1 << 14)) >> 15)
+
+/*! @brief Rotates a phasor forwards by 120 degrees.
+ *
+ *  @param phasor The phasor.
+ *  @return TDFTBin - a * phasor.
+ */
+static TDFTBin RotateA(const TDFTBin * const phasor)
+{
+  return (TDFTBin){
+      Q15_ROUND((int64_t)A_RE * phasor->re - (int64_t)A_IM * phasor->im),
+      Q15_ROUND((int64_t)A_IM * phasor->re + (int64_t)A_RE * phasor->im),
+  };
+}
+
+/*! @brief Rotates a phasor forwards by 240 degrees.
+ *
+ *  @param phasor The phasor.
+ *  @return TDFTBin - a^2 * phasor, using a^2 = conj(a).
+ */
+static TDFTBin RotateA2(const TDFTBin * const phasor)
+{
+  return (TDFTBin){
+      Q15_ROUND((int64_t)A_RE * phasor->re + (int64_t)A_IM * phasor->im),
+      Q15_ROUND((int64_t)A_RE * phasor->im - (int64_t)A_IM * phasor->re),
+  };
+}
+
+void Seq_Calculate(const TDFTBin phases[DSP_NB_PHASES], TSequence * const sequence)
+{
+  TDFTBin aB = RotateA(&phases[1]);
+  TDFTBin a2B = RotateA2(&phases[1]);
+  TDFTBin aC = RotateA(&phases[2]);
+  TDFTBin a2C = RotateA2(&phases[2]);
+
+  sequence->zero.re = (phases[0].re + phases[1].re + phases[2].re) / 3;
+  sequence->zero.im = (phases[0].im + phases[1].im + phases[2].im) / 3;
+  sequence->positive.re = (phases[0].re + aB.re + a2C.re) / 3;
+  sequence->positive.im = (phases[0].im + aB.im + a2C.im) / 3;
+  sequence->negative.re = (phases[0].re + a2B.re + aC.re) / 3;
+  sequence->negative.im = (phases[0].im + a2B.im + aC.im) / 3;
+
+  // Each component is on the scale of a fundamental bin, so converts to a current the same way
+  sequence->zeroCurrent = DSP_RMSCurrent(DSP_DFTSumOfSquares(&sequence->zero));
+  sequence->positiveCurrent = DSP_RMSCurrent(DSP_DFTSumOfSquares(&sequence->positive));
+  sequence->negativeCurrent = DSP_RMSCurrent(DSP_DFTSumOfSquares(&sequence->negative));
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,41 @@
+/*! @file
+ *
+ *  @brief Routines for resolving the phases into symmetrical components.
+ *
+ *  This contains the functions for finding the zero, positive and negative sequence currents
+ *  from the fundamental phasor of each phase.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef SEQ_H
+#define SEQ_H
+
+// new types
+#include "types.h"
+#include "dsp.h"
+
+/*! @brief Symmetrical components of the three phases
+ *
+ */
+typedef struct
+{
+  TDFTBin zero;             /*!< Zero sequence phasor, on the scale of a fundamental DFT bin */
+  TDFTBin positive;         /*!< Positive sequence phasor, referred to phase A */
+  TDFTBin negative;         /*!< Negative sequence phasor, referred to phase A */
+  uint32_t zeroCurrent;     /*!< Zero sequence RMS current in Q16.16 amps */
+  uint32_t positiveCurrent; /*!< Positive sequence RMS current in Q16.16 amps */
+  uint32_t negativeCurrent; /*!< Negative sequence RMS current in Q16.16 amps */
+} TSequence;
+
+/*! @brief Resolves the fundamental phasors of phases A, B and C into symmetrical components.
+ *
+ *  I0 = (A + B + C) / 3, I1 = (A + aB + a^2C) / 3 and I2 = (A + a^2B + aC) / 3, where a rotates by
+ *  120 degrees using fixed-point constants.
+ *  @param phases The fundamental DFT bin of each phase, in the order A, B, C.
+ *  @param sequence A pointer to place the components.
+ */
+void Seq_Calculate(const TDFTBin phases[DSP_NB_PHASES], TSequence * const sequence);
+
+#endif
@@ -0,0 +1,221 @@
+/*! @file txq.c
+ *
+ *  @brief routines for queueing transmit bursts for a block transfer engine
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup txq_module txq module documentation
+**  @{
+*/
+
+#include "txq.h"
+#include "OS.h"
+
+#include <stddef.h>
+
+// Index of a free-running count within the buffer
+#define TXQ_MASK (TXQ_SIZE - 1)
+
+static uint8_t Buffer[TXQ_SIZE];
+
+static uint16_t Open;               /*!< Free-running count of bytes put, including an open burst */
+static uint16_t volatile Committed; /*!< Free-running count of bytes handed over to the engine */
+static uint16_t volatile Sent;      /*!< Free-running count of bytes the engine has finished */
+static uint16_t volatile InFlight;  /*!< Bytes in the span the engine is sending, 0 when idle */
+
+static uint8_t BurstDepth;
+static TTxQStart Start;
+static uint8_t FrameSize;
+static uint8_t SentPhase; /*!< Bytes of the frame at Sent already sent, 0 on a frame boundary */
+static uint32_t volatile NbTransfers;
+
+// Urgent bytes waiting to jump the queue, in two buffers so more can wait while the engine sends one
+static uint8_t Urgent[2][TXQ_URGENT_SIZE];
+static uint16_t NbUrgent[2];
+static uint8_t UrgentFill; /*!< Buffer urgent bytes are put into */
+static bool UrgentInFlight; /*!< TRUE while the engine is sending the other buffer rather than a span */
+
+static OS_ECB *SpaceAvailable;
+static bool volatile PutWaiting; /*!< TRUE while the producer is blocked waiting for space */
+
+/*! @brief Starts the engine on any urgent bytes once a frame boundary is reached, otherwise on the
+ *         longest contiguous span of committed bytes that ends within TXQ_SPAN_NB_FRAMES frames.
+ *
+ *  @note Call with interrupts disabled, or from the engine's interrupt, while the engine is idle.
+ */
+static void startNext(void)
+{
+  if (NbUrgent[UrgentFill] > 0 && SentPhase == 0)
+  {
+    // Send the filled buffer, and take any more urgent bytes in the other
+    uint8_t sending = UrgentFill;
+    UrgentFill ^= 1;
+    UrgentInFlight = true;
+    InFlight = NbUrgent[sending];
+    Start(Urgent[sending], InFlight);
+    return;
+  }
+
+  uint16_t waiting = (uint16_t)(Committed - Sent);
+
+  if (waiting == 0)
+    return;
+
+  // End the span on a frame boundary, so urgent bytes put meanwhile wait for at most one span
+  uint16_t toEnd = TXQ_SIZE - (Sent & TXQ_MASK);
+  uint16_t toBoundary = (uint16_t)FrameSize * TXQ_SPAN_NB_FRAMES - SentPhase;
+  InFlight = (waiting < toEnd) ? waiting : toEnd;
+  if (InFlight > toBoundary)
+    InFlight = toBoundary;
+
+  Start(&Buffer[Sent & TXQ_MASK], InFlight);
+}
+
+/*! @brief Hands everything put so far to the engine.
+ *
+ */
+static void commit(void)
+{
+  OS_DisableInterrupts();
+
+  Committed = Open;
+
+  if (InFlight == 0)
+    startNext();
+
+  OS_EnableInterrupts();
+}
+
+bool TxQ_Init(const TTxQStart start, const uint8_t frameSize)
+{
+  Open = 0;
+  Committed = 0;
+  Sent = 0;
+  InFlight = 0;
+  BurstDepth = 0;
+  SentPhase = 0;
+  NbUrgent[0] = 0;
+  NbUrgent[1] = 0;
+  UrgentFill = 0;
+  UrgentInFlight = false;
+  NbTransfers = 0;
+  PutWaiting = false;
+  Start = start;
+  FrameSize = frameSize;
+  SpaceAvailable = OS_SemaphoreCreate(0);
+
+  return (Start != NULL) && (FrameSize > 0) && (SpaceAvailable != NULL);
+}
+
+void TxQ_Begin(void)
+{
+  BurstDepth++;
+}
+
+void TxQ_End(void)
+{
+  if (BurstDepth > 0 && --BurstDepth == 0)
+    commit();
+}
+
+void TxQ_Put(const uint8_t data[], const uint16_t nbBytes)
+{
+  uint16_t nbPut = 0;
+
+  while (nbPut < nbBytes)
+  {
+    uint16_t space = TXQ_SIZE - (uint16_t)(Open - Sent);
+
+    if (space == 0)
+    {
+      // Let the engine drain what we have, then wait for it to free some room
+      commit();
+
+      PutWaiting = true;
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+      if ((uint16_t)(Open - Sent) == TXQ_SIZE)
+        OS_SemaphoreWait(SpaceAvailable, 0);
+
+      PutWaiting = false;
+      continue;
+    }
+
+    uint16_t nbCopy = (uint16_t)(nbBytes - nbPut);
+    if (nbCopy > space)
+      nbCopy = space;
+
+    for (uint16_t byteNb = 0; byteNb < nbCopy; byteNb++)
+      Buffer[(uint16_t)(Open + byteNb) & TXQ_MASK] = data[nbPut + byteNb];
+
+    Open += nbCopy;
+    nbPut += nbCopy;
+  }
+
+  if (BurstDepth == 0)
+    commit();
+}
+
+bool TxQ_PutUrgent(const uint8_t data[], const uint16_t nbBytes)
+{
+  bool queued = false;
+
+  OS_DisableInterrupts();
+
+  // The engine reads straight out of the other buffer, so this one can grow while it sends
+  if (nbBytes <= TXQ_URGENT_SIZE - NbUrgent[UrgentFill])
+  {
+    for (uint16_t byteNb = 0; byteNb < nbBytes; byteNb++)
+      Urgent[UrgentFill][NbUrgent[UrgentFill] + byteNb] = data[byteNb];
+
+    NbUrgent[UrgentFill] += nbBytes;
+    queued = true;
+
+    if (InFlight == 0)
+      startNext();
+  }
+
+  OS_EnableInterrupts();
+
+  return queued;
+}
+
+void TxQ_Done(void)
+{
+  if (UrgentInFlight)
+  {
+    UrgentInFlight = false;
+    NbUrgent[UrgentFill ^ 1] = 0;
+    InFlight = 0;
+    NbTransfers++;
+    startNext();
+    return;
+  }
+
+  Sent += InFlight;
+  SentPhase = (uint8_t)((SentPhase + InFlight) % FrameSize);
+  InFlight = 0;
+  NbTransfers++;
+
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  if (PutWaiting)
+  {
+    PutWaiting = false;
+    OS_SemaphoreSignal(SpaceAvailable);
+  }
+
+  startNext();
+}
+
+uint32_t TxQ_NbTransfers(void)
+{
+  return NbTransfers;
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,96 @@
+/*! @file
+ *
+ *  @brief Routines for queueing transmit bursts for a block transfer engine.
+ *
+ *  This contains the functions for collecting frames into a ring buffer and handing them to an
+ *  engine, such as the eDMA, as contiguous spans. The engine is passed in, so the queue can be
+ *  driven by a stand-in off target. Urgent frames jump the queue at the next frame boundary.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef TXQ_H
+#define TXQ_H
+
+// new types
+#include "types.h"
+
+// Bytes of queued transmit data, a power of two so the free-running indices wrap cleanly
+#define TXQ_SIZE 1024
+
+#if (TXQ_SIZE & (TXQ_SIZE - 1)) != 0 || TXQ_SIZE > 32768
+#error "TXQ_SIZE must be a power of two no larger than 32768"
+#endif
+
+// Most frames handed to the engine at once, which bounds how long an urgent frame waits
+#define TXQ_SPAN_NB_FRAMES 8
+
+// Bytes of urgent data that can wait to jump the queue, on top of any the engine is sending
+#define TXQ_URGENT_SIZE 40
+
+/*! @brief Starts the engine sending a span of the queue.
+ *
+ *  @param data The first byte of the span.
+ *  @param nbBytes The number of bytes in the span, at least 1.
+ *  @note The engine calls TxQ_Done once the whole span has been sent.
+ */
+typedef void (*TTxQStart)(const uint8_t *data, uint16_t nbBytes);
+
+/*! @brief Sets up the queue before first use.
+ *
+ *  @param start The function that starts the engine on a span.
+ *  @param frameSize The number of bytes in each frame, so urgent frames never split one.
+ *  @return bool - TRUE if the queue was successfully initialized.
+ */
+bool TxQ_Init(const TTxQStart start, const uint8_t frameSize);
+
+/*! @brief Opens a burst, so frames put until the matching TxQ_End go out together.
+ *
+ *  Bursts may be nested; only the outermost TxQ_End hands the burst over.
+ */
+void TxQ_Begin(void);
+
+/*! @brief Closes a burst and starts the engine if it is idle.
+ *
+ */
+void TxQ_End(void);
+
+/*! @brief Queues bytes to send, waiting for space as needed.
+ *
+ *  Outside a burst the bytes are handed over at once. If a burst outgrows the queue, what has been
+ *  queued so far is handed over early to make room.
+ *  @param data The bytes to send.
+ *  @param nbBytes The number of bytes.
+ *  @note Assumes that TxQ_Init has been called. Only one thread may put into the queue.
+ */
+void TxQ_Put(const uint8_t data[], const uint16_t nbBytes);
+
+/*! @brief Queues bytes to send ahead of everything put with TxQ_Put, without waiting.
+ *
+ *  The bytes go out at the next frame boundary, after at most TXQ_SPAN_NB_FRAMES queued frames, and
+ *  all together.
+ *  @param data The whole frames to send.
+ *  @param nbBytes The number of bytes.
+ *  @return bool - TRUE if the bytes were queued, FALSE if the urgent bytes already waiting leave
+ *                 no room for them. Bytes the engine is sending don't take up room.
+ *  @note Assumes that TxQ_Init has been called. May be called from any thread, alongside TxQ_Put.
+ */
+bool TxQ_PutUrgent(const uint8_t data[], const uint16_t nbBytes);
+
+/*! @brief Tells the queue the engine has finished the span it was given.
+ *
+ *  Frees the span, wakes a thread waiting for space, and starts the next span if there is one.
+ *  @note Called by the engine, usually from its completion interrupt.
+ */
+void TxQ_Done(void);
+
+/*! @brief Gets the number of spans the engine has completed.
+ *
+ *  @return uint32_t - The number of completions. Each TXQ_SPAN_NB_FRAMES frames of a burst cost
+ *                     one, plus one if it wraps the end of the queue; bursts queued while the
+ *                     engine is busy share them. Each batch of urgent frames costs one more.
+ */
+uint32_t TxQ_NbTransfers(void);
+
+#endif
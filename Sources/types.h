@@ -31,6 +31,8 @@ typedef enum
   Phase1 = 1,
   Phase2 = 2,
   Phase3 = 3,
+  NegativeSequence = 4,
+  EarthFault = 5,
 } FAULT;
 
 enum TIMER_STATUS
@@ -46,26 +48,36 @@ typedef enum
   OUTPUT_HIGH = 1,
 } OUTPUT_SIGNAL;
 
-/*! @brief Data structure used to pass channel data to thread
+/*! @brief A single DFT bin as a fixed-point complex value
+ *
+ */
+typedef struct
+{
+  int32_t re;
+  int32_t im;
+} TDFTBin;
+
+/*! @brief Data structure holding the protection state of a channel
  *
  */
 typedef struct DORThreadData
 {
-  OS_ECB *sampleSemaphore;
   uint8_t channelNb;
-  float samples[ANALOG_WINDOW_SIZE];
-  double iRMS;
-  double tripTime;
-  uint32_t intervalCounter;
-  uint32_t numberOfIntervals;
+  int16_t *samples;      // DC-filtered samples window, a row of the packed sample block
+  uint64_t sumOfSquares; // Running sum of squares of the filtered samples window
+  int16_t *rawSamples;   // Unfiltered ADC samples window, kept for comparison
+  uint64_t rawSumOfSquares; // Running sum of squares of the unfiltered samples window
+  int32_t dcOffset;      // DC level tracked by the DC-removal filter, in raw counts scaled by 2^DSP_DC_FILTER_Q
+  TDFTBin fundamental;   // Sliding DFT of the fundamental over the samples window
+  int16_t *halfCycleSamples; // Raw samples of the last half cycle, for the high-set element
+  uint32_t halfCycleSum; // Running sum of absolute raw samples over the last half cycle
+  uint32_t iRMS;         // RMS current in Q16.16 amps
+  float tripTime;        // Trip time at the present current, in seconds
+  uint64_t tripStart;    // Time the trip timer started, in microseconds
+  uint64_t tripIntegral; // Integral of 1/t(I) since pickup, the channel trips at TRIP_INTEGRAL_UNITY
   enum TIMER_STATUS timerStatus;
   bool tripped;
 
-  uint8_t crossingNb;
-  double offset1;
-  double offset2;
-  uint8_t sampleOffset;
-
 } TDORThreadData;
 
 // Unions to efficiently access hi and lo parts of integers and words
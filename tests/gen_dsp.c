@@ -0,0 +1,56 @@
+/*! @file gen_dsp.c
+ *
+ *  @brief Host generator of the DSP cosine table
+ *
+ *  Evaluates cos() in double precision at every point of a cycle and writes the table to standard
+ *  output as the C source of DSP_CosTable, in Q15 rounded to nearest. tests/Makefile runs it to
+ *  keep Sources/dsp_tables.c up to date, so the DFT and FFT twiddle factors are never typed by hand.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "dsp.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// Entries written on each line
+#define NB_PER_LINE 8
+
+int main(void)
+{
+  printf("/*! @file dsp_tables.c\n"
+         " *\n"
+         " *  @brief DSP cosine table\n"
+         " *\n"
+         " *  Generated by tests/gen_dsp.c, do not edit. Run make -C tests tables to regenerate.\n"
+         " *\n"
+         " *  @author 11989668\n"
+         " *  @date 2026-10-17\n"
+         " */\n"
+         "/*!\n"
+         "**  @addtogroup dsp_module DSP module documentation\n"
+         "**  @{\n"
+         "*/\n"
+         "\n"
+         "#include \"dsp.h\"\n"
+         "\n"
+         "const int16_t DSP_CosTable[DSP_COS_TABLE_SIZE] =\n"
+         "{");
+
+  for (unsigned i = 0; i < DSP_COS_TABLE_SIZE; i++)
+  {
+    if (i % NB_PER_LINE == 0)
+      printf("\n   ");
+    printf(" %6ld,", lround(INT16_MAX * cos(2 * M_PI * i / DSP_COS_TABLE_SIZE)));
+  }
+
+  printf("\n};\n"
+         "\n"
+         "/*!\n"
+         "** @}\n"
+         "*/\n");
+
+  return 0;
+}
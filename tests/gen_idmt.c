@@ -0,0 +1,101 @@
+/*! @file gen_idmt.c
+ *
+ *  @brief Host generator of the IDMT trip rate tables
+ *
+ *  Evaluates 1/t(I) = ((I^a) - 1) / k of each characteristic at every table point with pow() in
+ *  double precision, and writes the tables to standard output as the C source of IDMT_TripRates,
+ *  in Q8.24 per second. tests/Makefile runs it to keep Sources/idmt_tables.c up to date, so the
+ *  target builds the tables into Flash and never evaluates the curves itself.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "idmt.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// Entries written on each line
+#define NB_PER_LINE 8
+
+/*
+ * Inverse Timing values from https://www.jcalc.net/idmt-relay-trip-time-calculator
+ */
+static const double k[IDMT_NB_CHARACTERISTICS] = {
+    0.14, // Inverse
+    13.5, // VeryInverse
+    80    // ExtremelyInverse
+};
+
+static const double a[IDMT_NB_CHARACTERISTICS] = {
+    0.02, // Inverse
+    1,    // VeryInverse
+    2     // ExtremelyInverse
+};
+
+static const char *NAMES[IDMT_NB_CHARACTERISTICS] = {"Inverse", "VeryInverse", "ExtremelyInverse"};
+
+/*! @brief Gets the table entry of a characteristic at a table point.
+ *
+ *  @param characteristic The characteristic.
+ *  @param i The table point.
+ *  @return uint32_t - The trip rate in Q8.24 per second, saturated.
+ */
+static uint32_t entry(const unsigned characteristic, const unsigned i)
+{
+  unsigned octave = i / IDMT_TABLE_STEPS_PER_OCTAVE;
+  unsigned step = i % IDMT_TABLE_STEPS_PER_OCTAVE;
+  double current = (double)(1u << octave) * (1.0 + (double)step / IDMT_TABLE_STEPS_PER_OCTAVE);
+  double rate = (pow(current, a[characteristic]) - 1) / k[characteristic] * IDMT_RATE_ONE;
+
+  // Saturate, tripping within a few milliseconds anyway
+  if (rate >= UINT32_MAX)
+    return UINT32_MAX;
+
+  return (uint32_t)lround(rate);
+}
+
+int main(void)
+{
+  printf("/*! @file idmt_tables.c\n"
+         " *\n"
+         " *  @brief IDMT trip rate tables\n"
+         " *\n"
+         " *  Generated by tests/gen_idmt.c, do not edit. Run make -C tests tables to regenerate.\n"
+         " *\n"
+         " *  @author 11989668\n"
+         " *  @date 2026-10-17\n"
+         " */\n"
+         "/*!\n"
+         "**  @addtogroup idmt_module IDMT module documentation\n"
+         "**  @{\n"
+         "*/\n"
+         "\n"
+         "#include \"idmt.h\"\n"
+         "\n"
+         "const uint32_t IDMT_TripRates[IDMT_NB_CHARACTERISTICS][IDMT_TABLE_SIZE] =\n"
+         "{\n");
+
+  for (unsigned characteristic = 0; characteristic < IDMT_NB_CHARACTERISTICS; characteristic++)
+  {
+    printf("  // %s, k = %g, a = %g\n  {", NAMES[characteristic], k[characteristic], a[characteristic]);
+
+    for (unsigned i = 0; i < IDMT_TABLE_SIZE; i++)
+    {
+      if (i % NB_PER_LINE == 0)
+        printf("\n   ");
+      printf(" %10u,", (unsigned)entry(characteristic, i));
+    }
+
+    printf("\n  },\n");
+  }
+
+  printf("};\n"
+         "\n"
+         "/*!\n"
+         "** @}\n"
+         "*/\n");
+
+  return 0;
+}
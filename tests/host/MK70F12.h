@@ -0,0 +1,42 @@
+/*! @file
+ *
+ *  @brief Stand-in for the K70 memory map on the host.
+ *
+ *  This takes the register layouts and bit fields from the real MK70F12.h, and points the
+ *  peripherals the drivers under test touch at ordinary structures in registers.c, so a test can
+ *  set a status register, call an ISR and look at what it wrote.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef HOST_MK70F12_H
+#define HOST_MK70F12_H
+
+#include "../../Static_Code/IO_Map/MK70F12.h"
+
+extern struct UART_MemMap Host_UART2;
+extern struct DMA_MemMap Host_DMA;
+extern struct DMAMUX_MemMap Host_DMAMUX0;
+extern struct NVIC_MemMap Host_NVIC;
+extern struct SIM_MemMap Host_SIM;
+extern struct PORT_MemMap Host_PORTE;
+extern struct FTFE_MemMap Host_FTFE;
+
+#undef UART2_BASE_PTR
+#undef DMA_BASE_PTR
+#undef DMAMUX0_BASE_PTR
+#undef NVIC_BASE_PTR
+#undef SIM_BASE_PTR
+#undef PORTE_BASE_PTR
+#undef FTFE_BASE_PTR
+
+#define UART2_BASE_PTR ((UART_MemMapPtr)&Host_UART2)
+#define DMA_BASE_PTR ((DMA_MemMapPtr)&Host_DMA)
+#define DMAMUX0_BASE_PTR ((DMAMUX_MemMapPtr)&Host_DMAMUX0)
+#define NVIC_BASE_PTR ((NVIC_MemMapPtr)&Host_NVIC)
+#define SIM_BASE_PTR ((SIM_MemMapPtr)&Host_SIM)
+#define PORTE_BASE_PTR ((PORT_MemMapPtr)&Host_PORTE)
+#define FTFE_BASE_PTR ((FTFE_MemMapPtr)&Host_FTFE)
+
+#endif
@@ -0,0 +1,53 @@
+/*! @file
+ *
+ *  @brief Stand-in for the RTOS interface on the host.
+ *
+ *  This takes the types and prototypes from Library/OS.h, and masks interrupts by holding a lock
+ *  that the tests' stand-in interrupt threads also take. The OS functions are in os.c.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef HOST_OS_H
+#define HOST_OS_H
+
+#include "../../Library/OS.h"
+
+#undef OS_DisableInterrupts
+#undef OS_EnableInterrupts
+
+#define OS_DisableInterrupts() Host_DisableInterrupts()
+#define OS_EnableInterrupts() Host_EnableInterrupts()
+
+/*! @brief Takes the interrupt lock, as disabling interrupts does on the target.
+ *
+ *  @note Like CPSID, this does not nest.
+ */
+void Host_DisableInterrupts(void);
+
+/*! @brief Releases the interrupt lock.
+ *
+ */
+void Host_EnableInterrupts(void);
+
+/*! @brief Gets the number of semaphore signals since the program started.
+ *
+ *  @return uint32_t - The number of calls to OS_SemaphoreSignal.
+ */
+uint32_t Host_SemaphoreSignals(void);
+
+/*! @brief Gets the number of semaphore waits since the program started.
+ *
+ *  @return uint32_t - The number of calls to OS_SemaphoreWait.
+ */
+uint32_t Host_SemaphoreWaits(void);
+
+/*! @brief Gets the number of threads blocked on a semaphore now.
+ *
+ *  @return uint32_t - The number of threads inside OS_SemaphoreWait that no signal already given
+ *                     will release.
+ */
+uint32_t Host_SemaphoreBlocked(void);
+
+#endif
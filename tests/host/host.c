@@ -0,0 +1,62 @@
+/*! @file host.c
+ *
+ *  @brief Helpers shared by the host tests
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup host_module host module documentation
+**  @{
+*/
+
+#include "host.h"
+#include "dsp.h"
+
+#include <math.h>
+#include <time.h>
+
+static unsigned NbChecks;
+static unsigned NbFailures;
+
+void Host_Check(const bool passed, const char *text, const char *file, const int line)
+{
+  NbChecks++;
+
+  if (!passed)
+  {
+    NbFailures++;
+    printf("%s:%d: check failed: %s\n", file, line, text);
+  }
+}
+
+int Host_Result(void)
+{
+  printf("%u checks, %u failed\n", NbChecks, NbFailures);
+  return (NbFailures == 0) ? 0 : 1;
+}
+
+uint64_t Host_Nanoseconds(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+int16_t Host_Sample(const double amps, const double radians)
+{
+  double raw = round(amps * M_SQRT2 * DSP_RAW_PER_AMP * sin(radians));
+
+  if (raw > INT16_MAX)
+    return INT16_MAX;
+  if (raw < INT16_MIN)
+    return INT16_MIN;
+
+  return (int16_t)raw;
+}
+
+/*!
+** @}
+*/
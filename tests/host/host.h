@@ -0,0 +1,77 @@
+/*! @file
+ *
+ *  @brief Helpers shared by the host tests.
+ *
+ *  This contains the check macros, the timer and the signal generator used by the tests that
+ *  run the target modules on a workstation.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*! @brief Records a check, reporting where it failed, and carries on. */
+#define HOST_CHECK(condition) Host_Check((condition), #condition, __FILE__, __LINE__)
+
+/*! @brief Records a check.
+ *
+ *  @param passed TRUE if the check passed.
+ *  @param text The condition checked.
+ *  @param file The file of the check.
+ *  @param line The line of the check.
+ */
+void Host_Check(const bool passed, const char *text, const char *file, const int line);
+
+/*! @brief Prints the number of checks and failures.
+ *
+ *  @return int - The exit status of the test, 0 if every check passed.
+ */
+int Host_Result(void);
+
+/*! @brief Reads a monotonic clock for timing the kernels.
+ *
+ *  @return uint64_t - The time in nanoseconds. Host timings only compare methods with each other;
+ *                     they are not K70 cycle counts.
+ */
+uint64_t Host_Nanoseconds(void);
+
+/*! @brief Makes a raw ADC sample of a sinusoidal current.
+ *
+ *  @param amps The RMS current in amps.
+ *  @param radians The phase of the sinusoid at the sample.
+ *  @return int16_t - The raw sample, saturated to 16 bits.
+ */
+int16_t Host_Sample(const double amps, const double radians);
+
+/*! @brief Simulated time in microseconds, returned by PIT_TimeGet in pit.c. */
+extern uint64_t Host_Time;
+
+/*! @brief Looks at a one-shot PIT channel.
+ *
+ *  @param channelNb The timer channel.
+ *  @param due Place to return the time it expires, or NULL.
+ *  @return bool - TRUE if the channel is counting.
+ */
+bool Host_OneShotArmed(const uint8_t channelNb, uint64_t * const due);
+
+/*! @brief Fires a one-shot PIT channel if it has expired by Host_Time.
+ *
+ *  @param channelNb The timer channel.
+ *  @return bool - TRUE if it fired, as its interrupt would have.
+ */
+bool Host_OneShotFire(const uint8_t channelNb);
+
+/*! @brief Counts the one-shots started on a PIT channel.
+ *
+ *  @param channelNb The timer channel.
+ *  @return uint32_t - The number of calls to PIT_StartOneShot.
+ */
+uint32_t Host_OneShotStarts(const uint8_t channelNb);
+
+#endif
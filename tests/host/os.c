@@ -0,0 +1,123 @@
+/*! @file os.c
+ *
+ *  @brief Stand-in for the RTOS on the host
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup host_os_module host OS module documentation
+**  @{
+*/
+
+#include "OS.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+/*! @brief A semaphore, with the RTOS event control block first so it can be handed out
+ *
+ */
+typedef struct
+{
+  OS_ECB ecb;
+  pthread_mutex_t lock;
+  pthread_cond_t signalled;
+  uint32_t waiters; /*!< Threads waiting in OS_SemaphoreWait */
+} TSemaphore;
+
+static pthread_mutex_t InterruptLock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t Signals; /*!< Calls to OS_SemaphoreSignal */
+static uint32_t Waits;   /*!< Calls to OS_SemaphoreWait */
+static uint32_t Blocked; /*!< Threads waiting in OS_SemaphoreWait that no signal is yet due to release */
+
+uint32_t Host_SemaphoreSignals(void)
+{
+  return __atomic_load_n(&Signals, __ATOMIC_RELAXED);
+}
+
+uint32_t Host_SemaphoreWaits(void)
+{
+  return __atomic_load_n(&Waits, __ATOMIC_RELAXED);
+}
+
+uint32_t Host_SemaphoreBlocked(void)
+{
+  return __atomic_load_n(&Blocked, __ATOMIC_ACQUIRE);
+}
+
+void Host_DisableInterrupts(void)
+{
+  pthread_mutex_lock(&InterruptLock);
+}
+
+void Host_EnableInterrupts(void)
+{
+  pthread_mutex_unlock(&InterruptLock);
+}
+
+void OS_ISREnter(void)
+{
+}
+
+void OS_ISRExit(void)
+{
+}
+
+OS_ECB* OS_SemaphoreCreate(const uint32_t value)
+{
+  TSemaphore *semaphore = malloc(sizeof(TSemaphore));
+
+  if (!semaphore)
+    return NULL;
+
+  semaphore->ecb.count = value;
+  semaphore->ecb.waitList = 0;
+  semaphore->waiters = 0;
+  pthread_mutex_init(&semaphore->lock, NULL);
+  pthread_cond_init(&semaphore->signalled, NULL);
+
+  return &semaphore->ecb;
+}
+
+OS_ERROR OS_SemaphoreSignal(OS_ECB* const pEvent)
+{
+  TSemaphore *semaphore = (TSemaphore *)pEvent;
+
+  __atomic_fetch_add(&Signals, 1, __ATOMIC_RELAXED);
+  pthread_mutex_lock(&semaphore->lock);
+  // A waiter this signal releases is no longer blocked, even before it runs
+  if (semaphore->waiters > semaphore->ecb.count)
+    __atomic_fetch_sub(&Blocked, 1, __ATOMIC_RELAXED);
+  semaphore->ecb.count++;
+  pthread_cond_signal(&semaphore->signalled);
+  pthread_mutex_unlock(&semaphore->lock);
+
+  return OS_NO_ERROR;
+}
+
+OS_ERROR OS_SemaphoreWait(OS_ECB* const pEvent, const uint32_t timeout)
+{
+  TSemaphore *semaphore = (TSemaphore *)pEvent;
+
+  __atomic_fetch_add(&Waits, 1, __ATOMIC_RELAXED);
+  pthread_mutex_lock(&semaphore->lock);
+  if (semaphore->ecb.count == 0)
+  {
+    semaphore->waiters++;
+    __atomic_fetch_add(&Blocked, 1, __ATOMIC_RELEASE);
+    while (semaphore->ecb.count == 0)
+      pthread_cond_wait(&semaphore->signalled, &semaphore->lock);
+    semaphore->waiters--;
+  }
+  semaphore->ecb.count--;
+  pthread_mutex_unlock(&semaphore->lock);
+
+  return OS_NO_ERROR;
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,77 @@
+/*! @file pit.c
+ *
+ *  @brief Stand-in for the PIT on the host, running on simulated time
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup host_pit_module host PIT module documentation
+**  @{
+*/
+
+#include "host.h"
+#include "PIT.h"
+
+// Timer channels
+#define NB_CHANNELS 4
+
+uint64_t Host_Time;
+
+static uint64_t Due[NB_CHANNELS]; /*!< Time each one-shot channel expires */
+static bool Armed[NB_CHANNELS];
+static uint32_t NbStarts[NB_CHANNELS];
+
+bool PIT_Init(const uint32_t moduleClk)
+{
+  return true;
+}
+
+void PIT_Set(uint8_t channelNb, const uint32_t period, const bool restart)
+{
+}
+
+void PIT_StartOneShot(uint8_t channelNb, const uint32_t delay)
+{
+  Due[channelNb] = Host_Time + delay;
+  Armed[channelNb] = true;
+  NbStarts[channelNb]++;
+}
+
+uint64_t PIT_TimeGet(void)
+{
+  return Host_Time;
+}
+
+void PIT_Enable(uint8_t channelNb, const bool enable)
+{
+  if (!enable)
+    Armed[channelNb] = false;
+}
+
+bool Host_OneShotArmed(const uint8_t channelNb, uint64_t * const due)
+{
+  if (Armed[channelNb] && due)
+    *due = Due[channelNb];
+
+  return Armed[channelNb];
+}
+
+bool Host_OneShotFire(const uint8_t channelNb)
+{
+  if (!Armed[channelNb] || Host_Time < Due[channelNb])
+    return false;
+
+  Armed[channelNb] = false;
+  return true;
+}
+
+uint32_t Host_OneShotStarts(const uint8_t channelNb)
+{
+  return NbStarts[channelNb];
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,26 @@
+/*! @file registers.c
+ *
+ *  @brief Stand-in peripheral registers on the host
+ *
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+/*!
+**  @addtogroup host_registers_module host registers module documentation
+**  @{
+*/
+
+#include "MK70F12.h"
+
+struct UART_MemMap Host_UART2;
+struct DMA_MemMap Host_DMA;
+struct DMAMUX_MemMap Host_DMAMUX0;
+struct NVIC_MemMap Host_NVIC;
+struct SIM_MemMap Host_SIM;
+struct PORT_MemMap Host_PORTE;
+struct FTFE_MemMap Host_FTFE;
+
+/*!
+** @}
+*/
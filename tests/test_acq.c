@@ -0,0 +1,177 @@
+/*! @file test_acq.c
+ *
+ *  @brief Host test of the sample block hand-over
+ *
+ *  A producer thread stands in for the sampling interrupt, taking samples through Acq_Sample as
+ *  fast as it can and signalling each completed block, as SamplerThread does. The consumer takes the
+ *  blocks with Acq_Get, as DSPThread does, and checks every block it gets is whole and in order,
+ *  and that the blocks it got and the overruns account for every block completed. The producer's
+ *  sampling instants jitter by a known amount, which Acq_Jitter has to measure exactly.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "acq.h"
+#include "OS.h"
+#include "Cpu.h"
+
+#include <pthread.h>
+
+// Samples taken by the producer
+#define NB_SAMPLES 20000000
+
+// Core clock cycles between samples at 50 Hz, and the most a sampling instant is late
+#define SAMPLE_PERIOD (CPU_CORE_CLK_HZ / (50 * ANALOG_WINDOW_SIZE))
+#define MAX_LATENESS 3000
+
+static OS_ECB *BlockSemaphore;
+static volatile bool Finished;
+static uint32_t Cycles; /*!< Cycle count of the sample being taken, the same for every input */
+static uint32_t NbBlocks;
+static uint32_t MinInterval, MaxInterval; /*!< Shortest and longest time between samples the producer took */
+
+/*! @brief The value the stand-in ADC gives an input at a sample.
+ *
+ *  @param sampleNb The sample number, which is also its time.
+ *  @param inputNb The input.
+ *  @return int16_t - The sample.
+ */
+static int16_t expected(const uint64_t sampleNb, const uint8_t inputNb)
+{
+  return (int16_t)(sampleNb * ACQ_NB_INPUTS + inputNb);
+}
+
+bool Analog_Get(const uint8_t channelNb, int16_t * const valuePtr)
+{
+  *valuePtr = expected(Host_Time, channelNb);
+  return true;
+}
+
+uint32_t Profile_Cycles(void)
+{
+  return Cycles;
+}
+
+void Calib_Capture(const int16_t samples[ANALOG_NB_INPUTS])
+{
+}
+
+int16_t Calib_Correct(const uint8_t inputNb, const int16_t sample)
+{
+  return sample;
+}
+
+/*! @brief Takes samples as the sampling interrupt would, signalling each completed block.
+ *
+ *  @param arg Unused.
+ *  @return void* - Unused.
+ */
+static void *producer(void *arg)
+{
+  int16_t samples[ACQ_NB_INPUTS];
+  uint32_t seed = 7;
+
+  MinInterval = UINT32_MAX;
+  MaxInterval = 0;
+
+  for (uint32_t sampleNb = 0; sampleNb < NB_SAMPLES; sampleNb++)
+  {
+    uint32_t previous = Cycles;
+
+    // Every input is read at the same instant, so alignment leaves the samples alone
+    seed = seed * 1664525 + 1013904223;
+    Host_Time = sampleNb;
+    Cycles = sampleNb * SAMPLE_PERIOD + (seed >> 16) % (MAX_LATENESS + 1);
+
+    if (sampleNb > 0)
+    {
+      uint32_t interval = Cycles - previous;
+      MinInterval = (interval < MinInterval) ? interval : MinInterval;
+      MaxInterval = (interval > MaxInterval) ? interval : MaxInterval;
+    }
+
+    if (Acq_Sample(samples))
+    {
+      NbBlocks++;
+      OS_SemaphoreSignal(BlockSemaphore);
+    }
+  }
+
+  Finished = true;
+  OS_SemaphoreSignal(BlockSemaphore);
+  return NULL;
+}
+
+/*! @brief Runs the producer against a consumer and checks every block the consumer got.
+ *
+ *  @param poll TRUE to poll Acq_Get flat out, FALSE to wait for the producer's signal as DSPThread does.
+ */
+static void run(const bool poll)
+{
+  pthread_t thread;
+  TAcqBlock block;
+  uint32_t received = 0, broken = 0, outOfOrder = 0;
+  int64_t last = -1;
+
+  Acq_Init();
+  NbBlocks = 0;
+  Finished = false;
+  pthread_create(&thread, NULL, producer, NULL);
+
+  for (bool done = false; !done;)
+  {
+    if (!poll)
+      OS_SemaphoreWait(BlockSemaphore, 0);
+    done = Finished;
+
+    while (Acq_Get(&block))
+    {
+      received++;
+
+      for (uint8_t sampleNb = 0; sampleNb < ACQ_BLOCK_SIZE; sampleNb++)
+      {
+        bool whole = (block.time[sampleNb] == block.time[0] + sampleNb);
+        for (uint8_t inputNb = 0; inputNb < ACQ_NB_INPUTS; inputNb++)
+          whole = whole && (block.input[inputNb][sampleNb] == expected(block.time[sampleNb], inputNb));
+
+        if (!whole)
+        {
+          broken++;
+          break;
+        }
+      }
+
+      if ((int64_t)block.time[0] <= last || block.time[0] % ACQ_BLOCK_SIZE != 0)
+        outOfOrder++;
+      last = (int64_t)block.time[0];
+    }
+  }
+
+  pthread_join(thread, NULL);
+
+  // Drop the signals the polling consumer never waited for
+  while (poll && BlockSemaphore->count)
+    OS_SemaphoreWait(BlockSemaphore, 0);
+
+  printf("%s: %u blocks completed, %u received, %u overrun, %u copies retaken, %u broken, %u out of order, jitter %u cycles\n",
+         poll ? "polling" : "waiting", NbBlocks, received, Acq_Overruns(), Acq_TornCopies(), broken, outOfOrder, Acq_Jitter());
+
+  HOST_CHECK(broken == 0);
+  HOST_CHECK(outOfOrder == 0);
+  HOST_CHECK(received + Acq_Overruns() == NbBlocks);
+  HOST_CHECK(last == NB_SAMPLES - ACQ_BLOCK_SIZE);
+  HOST_CHECK(Acq_Jitter() == MaxInterval - MinInterval);
+  HOST_CHECK(Acq_Jitter() <= 2 * MAX_LATENESS);
+}
+
+int main(void)
+{
+  BlockSemaphore = OS_SemaphoreCreate(0);
+
+  run(false);
+  run(true);
+
+  return Host_Result();
+}
@@ -0,0 +1,143 @@
+/*! @file test_calib.c
+ *
+ *  @brief Host test of the ADC calibration capture and correction
+ *
+ *  Feeds a simulated reference injection, reading low and offset, through Calib_Capture as
+ *  Acq_Sample does, stores the result and checks Calib_Correct brings the input back to the
+ *  reference. The Flash is the stand-in FTFE in registers.c, which completes every command at once,
+ *  so the test also checks the last phrase programmed holds the stored table.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "calib.h"
+#include "dsp.h"
+#include "MK70F12.h"
+
+#include <math.h>
+
+// Input calibrated, in the last phrase of the table
+#define INPUT 3
+
+// Reference injection in 0.1 A, and cycles averaged, as the defaults of F1x and F2x
+#define REFERENCE 50
+#define NB_CYCLES 50
+
+// The error the calibration has to take out: the input reads 7% low with an offset of 123 counts
+#define READING 0.93
+#define OFFSET 123
+
+// Samples timed through Calib_Correct
+#define NB_TIMED_SAMPLES 100000000
+
+static volatile int16_t Sink;
+
+/*! @brief Runs a capture of a simulated injection on one input.
+ *
+ *  @param inputNb The input.
+ *  @param amps The injected RMS current in amps.
+ *  @return CALIB_STATUS - The status once the capture has taken every sample.
+ */
+static CALIB_STATUS capture(const uint8_t inputNb, const double amps)
+{
+  int16_t samples[ANALOG_NB_INPUTS] = {0};
+
+  HOST_CHECK(Calib_Start(inputNb, REFERENCE, NB_CYCLES, ANALOG_WINDOW_SIZE));
+  HOST_CHECK(Calib_Status() == CALIB_CAPTURING);
+
+  for (unsigned n = 0; n < NB_CYCLES * ANALOG_WINDOW_SIZE; n++)
+  {
+    samples[inputNb] = (int16_t)(Host_Sample(amps * READING, 2 * M_PI * n / ANALOG_WINDOW_SIZE) + OFFSET);
+    Calib_Capture(samples);
+  }
+
+  return Calib_Status();
+}
+
+/*! @brief Measures the RMS current of an input after correction.
+ *
+ *  @param inputNb The input.
+ *  @param amps The injected RMS current in amps.
+ *  @return double - The corrected RMS current in amps.
+ */
+static double corrected(const uint8_t inputNb, const double amps)
+{
+  double sumOfSquares = 0;
+
+  for (unsigned n = 0; n < ANALOG_WINDOW_SIZE; n++)
+  {
+    int16_t sample = Calib_Correct(inputNb, (int16_t)(Host_Sample(amps * READING, 2 * M_PI * n / ANALOG_WINDOW_SIZE) + OFFSET));
+    sumOfSquares += (double)sample * sample;
+  }
+
+  return sqrt(sumOfSquares / ANALOG_WINDOW_SIZE) / DSP_RAW_PER_AMP;
+}
+
+int main(void)
+{
+  // The stand-in Flash is always ready for the next command
+  Host_FTFE.FSTAT = FTFE_FSTAT_CCIF_MASK;
+
+  for (uint8_t inputNb = 0; inputNb < ANALOG_NB_INPUTS; inputNb++)
+    HOST_CHECK(Calib_Reset(inputNb));
+
+  // At nominal a sample passes through unchanged
+  HOST_CHECK(Calib_Correct(INPUT, -12345) == -12345);
+  HOST_CHECK(Calib_Correct(INPUT, INT16_MAX) == INT16_MAX);
+
+  // The capture finds the offset and the gain, and the corrected input reads the reference
+  HOST_CHECK(capture(INPUT, REFERENCE / 10.0) == CALIB_READY);
+  HOST_CHECK(!Calib_Store(INPUT - 1));
+  HOST_CHECK(Calib_Store(INPUT));
+  HOST_CHECK(Calib_Status() == CALIB_IDLE);
+
+  TCalibration calibration = Calib_Get(INPUT);
+  double amps = corrected(INPUT, REFERENCE / 10.0);
+
+  printf("injection %.1f A reading %.0f%% with %d counts offset: offset %d, gain %.4f, corrected %.4f A\n", REFERENCE / 10.0,
+         READING * 100, OFFSET, calibration.offset, (double)calibration.gain / CALIB_GAIN_ONE, amps);
+  HOST_CHECK(calibration.offset == -OFFSET);
+  HOST_CHECK(fabs((double)calibration.gain / CALIB_GAIN_ONE - 1 / READING) < 1e-3);
+  HOST_CHECK(fabs(amps - REFERENCE / 10.0) < 1e-3);
+
+  // The correction is linear, so it holds away from the reference
+  HOST_CHECK(fabs(corrected(INPUT, 1.0) - 1.0) < 1e-3);
+  HOST_CHECK(fabs(corrected(INPUT, 12.0) - 12.0) < 1e-3);
+
+  // The other inputs are left at nominal
+  HOST_CHECK(Calib_Get(0).gain == CALIB_GAIN_ONE && Calib_Get(0).offset == 0);
+
+  // The last phrase programmed holds the entries of inputs 2 and 3, each word most significant byte first
+  TCalibration previous = Calib_Get(INPUT - 1);
+  uint32_t address = ((uint32_t)Host_FTFE.FCCOB1 << 16) | ((uint32_t)Host_FTFE.FCCOB2 << 8) | Host_FTFE.FCCOB3;
+  uint32_t first = ((uint32_t)Host_FTFE.FCCOB4 << 24) | ((uint32_t)Host_FTFE.FCCOB5 << 16) | ((uint32_t)Host_FTFE.FCCOB6 << 8) | Host_FTFE.FCCOB7;
+  uint32_t second = ((uint32_t)Host_FTFE.FCCOB8 << 24) | ((uint32_t)Host_FTFE.FCCOB9 << 16) | ((uint32_t)Host_FTFE.FCCOBA << 8) | Host_FTFE.FCCOBB;
+
+  HOST_CHECK(address == CALIB_FLASH_START + (INPUT - 1) * sizeof(TCalibration));
+  HOST_CHECK(first == (((uint32_t)previous.gain << 16) | (uint16_t)previous.offset));
+  HOST_CHECK(second == (((uint32_t)calibration.gain << 16) | (uint16_t)calibration.offset));
+
+  // An injection too far from the reference is refused, and leaves the coefficients in use alone
+  HOST_CHECK(capture(INPUT, REFERENCE / 10.0 / 4) == CALIB_FAILED);
+  HOST_CHECK(!Calib_Store(INPUT));
+  HOST_CHECK(Calib_Get(INPUT).gain == calibration.gain);
+
+  // Back to nominal
+  HOST_CHECK(Calib_Reset(INPUT));
+  HOST_CHECK(Calib_Correct(INPUT, 1000) == 1000);
+
+  // The per-sample correction
+  HOST_CHECK(capture(INPUT, REFERENCE / 10.0) == CALIB_READY);
+  HOST_CHECK(Calib_Store(INPUT));
+
+  uint64_t start = Host_Nanoseconds();
+
+  for (uint32_t n = 0; n < NB_TIMED_SAMPLES; n++)
+    Sink = Calib_Correct(n & (ANALOG_NB_INPUTS - 1), (int16_t)(n * 40503u));
+
+  printf("host ns per corrected sample: %.2f\n", (double)(Host_Nanoseconds() - start) / NB_TIMED_SAMPLES);
+
+  return Host_Result();
+}
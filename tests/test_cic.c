@@ -0,0 +1,122 @@
+/*! @file test_cic.c
+ *
+ *  @brief Host test and benchmark of the CIC decimator at the configured oversampling ratio
+ *
+ *  Built once for each DSP_OVERSAMPLING_RATIO. Checks the decimator's gain at DC and at the
+ *  fundamental against DSP_CIC_GAIN, reports how far it attenuates the tones that fold onto the
+ *  fundamental, and times the acquisition work per raw sample as a share of real time.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "acq.h"
+#include "dsp.h"
+
+#include <math.h>
+
+// Cycles of the fundamental run through the decimator for each measurement
+#define NB_CYCLES 64
+
+// Raw samples timed
+#define NB_TIMED_SAMPLES 50000000
+
+// Raw samples per second at 50 Hz
+#define RAW_RATE (50.0 * DSP_RAW_WINDOW_SIZE)
+
+static volatile int16_t Sink;
+
+/*! @brief Measures the gain of the decimator at a frequency.
+ *
+ *  @param harmonic The frequency in multiples of the fundamental.
+ *  @return double - The ratio of the output amplitude to the input amplitude.
+ */
+static double gain(const double harmonic)
+{
+  TCICDecimator cic = {{0}, {0}};
+  double re = 0, im = 0;
+  unsigned nbOutputs = 0;
+
+  for (unsigned n = 0; n < NB_CYCLES * DSP_RAW_WINDOW_SIZE; n++)
+  {
+    DSP_CICIntegrate(&cic, Host_Sample(10.0, 2 * M_PI * harmonic * n / DSP_RAW_WINDOW_SIZE));
+
+    if ((n + 1) % DSP_OVERSAMPLING_RATIO != 0)
+      continue;
+
+    int16_t output = DSP_CICDecimate(&cic);
+
+    // Correlate with the fundamental at the decimated rate, after a cycle to settle
+    if (n >= DSP_RAW_WINDOW_SIZE)
+    {
+      double angle = 2 * M_PI * nbOutputs / ANALOG_WINDOW_SIZE;
+      re += output * cos(angle);
+      im += output * sin(angle);
+      nbOutputs++;
+    }
+  }
+
+  // The amplitude of the sinusoid, against the amplitude put in
+  return 2 * hypot(re, im) / nbOutputs / (10.0 * M_SQRT2 * DSP_RAW_PER_AMP);
+}
+
+int main(void)
+{
+  printf("oversampling ratio %d, %d raw samples per cycle\n", DSP_OVERSAMPLING_RATIO, DSP_RAW_WINDOW_SIZE);
+
+  // A constant passes through unchanged
+  TCICDecimator cic = {{0}, {0}};
+  int16_t output = 0;
+
+  for (unsigned n = 0; n < 4 * DSP_OVERSAMPLING_RATIO; n++)
+  {
+    DSP_CICIntegrate(&cic, -12345);
+    if ((n + 1) % DSP_OVERSAMPLING_RATIO == 0)
+      output = DSP_CICDecimate(&cic);
+  }
+
+  HOST_CHECK(output == -12345);
+
+  // The gain at the fundamental is the one DSP_SAMPLE_PER_AMP allows for
+  double fundamental = gain(1);
+  printf("gain at the fundamental %.6f, DSP_CIC_GAIN %.6f\n", fundamental, DSP_CIC_GAIN);
+  HOST_CHECK(fabs(fundamental - DSP_CIC_GAIN) < 1e-3);
+
+  // Tones either side of each multiple of the decimated rate fold onto the fundamental
+  if (DSP_OVERSAMPLING_RATIO > 1)
+  {
+    double worst = 0;
+
+    for (unsigned m = 1; m < DSP_OVERSAMPLING_RATIO; m++)
+    {
+      double below = gain(m * ANALOG_WINDOW_SIZE - 1);
+      double above = gain(m * ANALOG_WINDOW_SIZE + 1);
+      worst = fmax(worst, fmax(below, above));
+    }
+
+    printf("worst alias onto the fundamental %.1f dB\n", 20 * log10(worst / fundamental));
+    HOST_CHECK(20 * log10(worst / fundamental) < -20);
+  }
+
+  // What Acq_Sample adds per raw sample: every input through the integrators, and a decimation per ratio
+  TCICDecimator decimators[ACQ_NB_INPUTS] = {{{0}, {0}}};
+  uint64_t start = Host_Nanoseconds();
+
+  for (uint32_t n = 0; n < NB_TIMED_SAMPLES; n++)
+  {
+    for (uint8_t inputNb = 0; inputNb < ACQ_NB_INPUTS; inputNb++)
+      DSP_CICIntegrate(&decimators[inputNb], (int16_t)(n * 40503u));
+
+    if ((n + 1) % DSP_OVERSAMPLING_RATIO == 0)
+    {
+      for (uint8_t inputNb = 0; inputNb < ACQ_NB_INPUTS; inputNb++)
+        Sink = DSP_CICDecimate(&decimators[inputNb]);
+    }
+  }
+
+  double ns = (double)(Host_Nanoseconds() - start) / NB_TIMED_SAMPLES;
+  printf("host ns per raw sample of every input %.2f, %.4f%% of real time at %.0f Hz\n", ns, ns * RAW_RATE / 1e7, RAW_RATE);
+
+  return Host_Result();
+}
@@ -0,0 +1,181 @@
+/*! @file test_dcf.c
+ *
+ *  @brief Host replay of asymmetrical faults through the DC-removal filter
+ *
+ *  Replays faults with a fully offset decaying DC component through DSP_DCFilter and the sliding
+ *  sum of squares, as processSample does, and integrates 1/t(I) on every sample as handleTrip does.
+ *  Compares the trip times with the filter off and at two time constants against the same fault
+ *  without its DC component, checks the filter keeps unity gain at the fundamental, and times it.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "idmt.h"
+#include "dsp.h"
+
+#include <math.h>
+
+// Processed sample period in microseconds at 50 Hz
+#define SAMPLE_PERIOD 1250
+
+// Overcurrent setting in amps, so the faults reach high multiples without clipping the ADC
+#define SETTING 0.5
+
+// Longest replay in seconds
+#define MAX_REPLAY 20
+
+// Samples timed
+#define NB_TIMED_SAMPLES 100000000
+
+static const uint64_t TRIP_INTEGRAL_UNITY = 1000000ULL << IDMT_RATE_Q;
+
+static const char *NAMES[3] = {"Inverse", "VeryInverse", "ExtremelyInverse"};
+
+static volatile int16_t Sink;
+
+/*! @brief Replays an asymmetrical fault until the channel trips.
+ *
+ *  The fault is I * sqrt(2) * (sin(wt - pi/2) + exp(-t / tau)), inception at a voltage zero on a
+ *  purely inductive circuit, which gives the largest offset.
+ *  @param characteristic The IDMT characteristic.
+ *  @param amps The RMS fault current in amps.
+ *  @param tau The time constant of the DC component in seconds, 0 for none.
+ *  @param shift The filter setting, 0 for off.
+ *  @return double - The trip time in seconds, or -1 if it didn't trip.
+ */
+static double tripTime(const RELAY_CHARACTERISTIC characteristic, const double amps, const double tau, const uint8_t shift)
+{
+  int16_t window[ANALOG_WINDOW_SIZE] = {0};
+  uint32_t sumOfSquares = 0;
+  int32_t dcOffset = 0;
+  uint64_t integral = 0;
+
+  for (unsigned n = 0; n < MAX_REPLAY * 1000000 / SAMPLE_PERIOD; n++)
+  {
+    double time = n * SAMPLE_PERIOD * 1e-6;
+    double offset = (tau > 0) ? exp(-time / tau) : 0;
+    double raw = amps * M_SQRT2 * DSP_SAMPLE_PER_AMP * (sin(2 * M_PI * n / ANALOG_WINDOW_SIZE - M_PI / 2) + offset);
+    int16_t sample = DSP_DCFilter(&dcOffset, (int16_t)lround(fmax(fmin(raw, INT16_MAX), INT16_MIN)), shift);
+
+    uint8_t count = n % ANALOG_WINDOW_SIZE;
+    sumOfSquares += (uint32_t)(sample * sample);
+    sumOfSquares -= (uint32_t)(window[count] * window[count]);
+    window[count] = sample;
+
+    // Multiples of the setting, picking up at 1.03
+    uint32_t current = (uint32_t)((uint64_t)DSP_RMSCurrent(sumOfSquares) * 10 / (uint32_t)(SETTING * 10));
+    if (current < DSP_CURRENT(1.03))
+    {
+      integral = 0;
+      continue;
+    }
+
+    integral += (uint64_t)IDMT_TripRate(characteristic, current) * SAMPLE_PERIOD;
+    if (integral >= TRIP_INTEGRAL_UNITY)
+      return time;
+  }
+
+  return -1;
+}
+
+/*! @brief Compares trip times with the filter off and on against the fault without its DC component.
+ *
+ */
+static void testReplay(void)
+{
+  static const double faults[] = {2, 4, 8};
+  static const double taus[] = {0.02, 0.06, 0.12};
+
+  printf("curve             fault  tau (ms)  symmetrical  off (error)        shift 5 (error)    shift 7 (error)\n");
+
+  for (RELAY_CHARACTERISTIC characteristic = Inverse; characteristic <= ExtremelyInverse; characteristic++)
+  {
+    for (unsigned f = 0; f < sizeof(faults) / sizeof(faults[0]); f++)
+    {
+      double symmetrical = tripTime(characteristic, faults[f], 0, 0);
+      double symmetricalFiltered = tripTime(characteristic, faults[f], 0, 5);
+
+      // The filter alone must not move the trip of a fault without DC by more than a sample or two
+      HOST_CHECK(fabs(symmetricalFiltered - symmetrical) <= 2.0 * SAMPLE_PERIOD * 1e-6);
+
+      for (unsigned t = 0; t < sizeof(taus) / sizeof(taus[0]); t++)
+      {
+        double off = tripTime(characteristic, faults[f], taus[t], 0);
+        double shift5 = tripTime(characteristic, faults[f], taus[t], 5);
+        double shift7 = tripTime(characteristic, faults[f], taus[t], 7);
+
+        printf("%-16s  %3.0fx  %8.0f  %11.3f  %.3f (%6.1f%%)  %.3f (%6.1f%%)  %.3f (%6.1f%%)\n", NAMES[characteristic],
+               faults[f] / SETTING, taus[t] * 1000, symmetrical, off, 100 * (off / symmetrical - 1),
+               shift5, 100 * (shift5 / symmetrical - 1), shift7, 100 * (shift7 / symmetrical - 1));
+
+        // The DC brings the trip forward; a time constant near the fault's takes most of it out, to within a sample
+        HOST_CHECK(off <= symmetrical);
+        HOST_CHECK(fabs(shift5 - symmetrical) <= fabs(off - symmetrical) + SAMPLE_PERIOD * 1e-6);
+      }
+    }
+  }
+}
+
+/*! @brief Checks the filter reads a sinusoid on a steady DC level at its true RMS at every setting.
+ *
+ */
+static void testGain(void)
+{
+  printf("shift  3 A on 500 counts of DC reads (A)\n");
+
+  for (uint8_t shift = DSP_DC_FILTER_SHIFT_MIN; shift <= DSP_DC_FILTER_SHIFT_MAX; shift++)
+  {
+    int16_t window[ANALOG_WINDOW_SIZE] = {0};
+    uint32_t sumOfSquares = 0;
+    int32_t dcOffset = 0;
+
+    // Long enough for the level to settle to well under a count
+    for (unsigned n = 0; n < (16u << shift) + 4 * ANALOG_WINDOW_SIZE; n++)
+    {
+      int16_t raw = (int16_t)lround(3 * M_SQRT2 * DSP_SAMPLE_PER_AMP * sin(2 * M_PI * n / ANALOG_WINDOW_SIZE) + 500);
+      int16_t sample = DSP_DCFilter(&dcOffset, raw, shift);
+
+      uint8_t count = n % ANALOG_WINDOW_SIZE;
+      sumOfSquares += (uint32_t)(sample * sample);
+      sumOfSquares -= (uint32_t)(window[count] * window[count]);
+      window[count] = sample;
+    }
+
+    double amps = (double)DSP_RMSCurrent(sumOfSquares) / DSP_CURRENT_ONE;
+    printf("%5u  %.4f\n", shift, amps);
+    HOST_CHECK(fabs(amps - 3) < 0.003);
+  }
+}
+
+/*! @brief Times the filter against passing the sample through.
+ *
+ */
+static void testCost(void)
+{
+  int32_t dcOffset = 0;
+  uint64_t start = Host_Nanoseconds();
+
+  for (unsigned n = 0; n < NB_TIMED_SAMPLES; n++)
+    Sink = DSP_DCFilter(&dcOffset, (int16_t)(n * 2654435761u >> 20), 0);
+
+  double offNs = (double)(Host_Nanoseconds() - start) / NB_TIMED_SAMPLES;
+  start = Host_Nanoseconds();
+
+  for (unsigned n = 0; n < NB_TIMED_SAMPLES; n++)
+    Sink = DSP_DCFilter(&dcOffset, (int16_t)(n * 2654435761u >> 20), 5);
+
+  double onNs = (double)(Host_Nanoseconds() - start) / NB_TIMED_SAMPLES;
+
+  printf("host ns per sample: filter off %.2f, on %.2f\n", offNs, onNs);
+}
+
+int main(void)
+{
+  testReplay();
+  testGain();
+  testCost();
+
+  return Host_Result();
+}
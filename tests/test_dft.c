@@ -0,0 +1,158 @@
+/*! @file test_dft.c
+ *
+ *  @brief Host test of the sliding fundamental DFT bin
+ *
+ *  Slides synthetic waveforms through DSP_DFTUpdate, as processSample does for SensitiveMode, and
+ *  checks how well the fundamental bin rejects each harmonic and how much it costs per sample.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "dsp.h"
+
+#include <math.h>
+
+// Cycles slid through for each waveform, so the result is checked at every window position
+#define NB_CYCLES 8
+
+// Phases tried for each harmonic
+#define NB_ANGLES 16
+
+// Samples slid through when timing
+#define NB_TIMED_SAMPLES 100000000
+
+static volatile int32_t Sink;
+
+/*! @brief Slides a waveform through the fundamental bin, as processSample does.
+ *
+ *  @param amps The RMS current of each harmonic in amps, from the fundamental up.
+ *  @param nbHarmonics The number of harmonics.
+ *  @param angle The phase of every harmonic at the first sample, in radians.
+ *  @param worst Place to return the largest fundamental RMS seen after the first window.
+ *  @return double - The smallest fundamental RMS seen after the first window.
+ */
+static double slide(const double amps[], const uint8_t nbHarmonics, const double angle, double *worst)
+{
+  TDFTBin bin = {0, 0};
+  int16_t window[ANALOG_WINDOW_SIZE] = {0};
+  double least = INFINITY;
+
+  *worst = 0;
+
+  for (unsigned n = 0; n < NB_CYCLES * ANALOG_WINDOW_SIZE; n++)
+  {
+    double sample = 0;
+    for (uint8_t h = 0; h < nbHarmonics; h++)
+      sample += Host_Sample(amps[h], (h + 1) * (angle + 2 * M_PI * n / ANALOG_WINDOW_SIZE));
+
+    uint8_t count = n % ANALOG_WINDOW_SIZE;
+    int16_t newSample = (int16_t)sample;
+
+    DSP_DFTUpdate(&bin, newSample, window[count], count);
+    window[count] = newSample;
+
+    if (n >= ANALOG_WINDOW_SIZE - 1)
+    {
+      // From the bin itself, as the integer sum of squares hides residues of a few counts
+      double rms = hypot(bin.re, bin.im) * M_SQRT2 / ANALOG_WINDOW_SIZE / DSP_SAMPLE_PER_AMP;
+      if (rms < least)
+        least = rms;
+      if (rms > *worst)
+        *worst = rms;
+    }
+  }
+
+  return least;
+}
+
+/*! @brief Measures the response of the fundamental bin to each harmonic alone.
+ *
+ */
+static void testRejection(void)
+{
+  static const double FUNDAMENTAL = 5.0;
+
+  printf("harmonic  rejection (dB, worst over phase and window position)\n");
+
+  for (uint8_t h = 2; h <= 7; h++)
+  {
+    double amps[7] = {0};
+    double worst = 0;
+
+    amps[h - 1] = FUNDAMENTAL;
+
+    for (unsigned a = 0; a < NB_ANGLES; a++)
+    {
+      double largest;
+      slide(amps, h, 2 * M_PI * a / NB_ANGLES, &largest);
+      if (largest > worst)
+        worst = largest;
+    }
+
+    // An exact zero reads as a residue of one count in the bin
+    if (worst == 0)
+      worst = M_SQRT2 / ANALOG_WINDOW_SIZE / DSP_SAMPLE_PER_AMP;
+
+    double rejection = 20 * log10(FUNDAMENTAL / worst);
+    printf("%8u  %9.1f\n", h, rejection);
+    HOST_CHECK(rejection > 60);
+  }
+}
+
+/*! @brief Checks the fundamental is measured alone in a waveform with 3rd, 5th and 7th harmonics.
+ *
+ */
+static void testDistortedWaveform(void)
+{
+  static const double amps[7] = {1.0, 0, 0.3, 0, 0.2, 0, 0.14};
+
+  double trueRMS = sqrt(1.0 + 0.3 * 0.3 + 0.2 * 0.2 + 0.14 * 0.14);
+  double worstError = 0;
+
+  for (unsigned a = 0; a < NB_ANGLES; a++)
+  {
+    double largest;
+    double least = slide(amps, 7, 2 * M_PI * a / NB_ANGLES, &largest);
+
+    if (fabs(least - 1.0) > worstError)
+      worstError = fabs(least - 1.0);
+    if (fabs(largest - 1.0) > worstError)
+      worstError = fabs(largest - 1.0);
+  }
+
+  printf("1 A with 30%% 3rd, 20%% 5th, 14%% 7th: true RMS %.3f A, fundamental within %.3f mA of 1 A\n", trueRMS, worstError * 1000);
+  HOST_CHECK(worstError < 0.002);
+}
+
+/*! @brief Times the sliding update.
+ *
+ */
+static void testCost(void)
+{
+  TDFTBin bin = {0, 0};
+  int16_t window[ANALOG_WINDOW_SIZE] = {0};
+  uint64_t start = Host_Nanoseconds();
+
+  for (unsigned n = 0; n < NB_TIMED_SAMPLES; n++)
+  {
+    uint8_t count = n % ANALOG_WINDOW_SIZE;
+    int16_t newSample = (int16_t)(n * 2654435761u >> 16);
+
+    DSP_DFTUpdate(&bin, newSample, window[count], count);
+    window[count] = newSample;
+  }
+
+  Sink = bin.re + bin.im;
+  printf("host ns per sample: %.2f\n", (double)(Host_Nanoseconds() - start) / NB_TIMED_SAMPLES);
+}
+
+int main(void)
+{
+  testRejection();
+  testDistortedWaveform();
+  testCost();
+
+  return Host_Result();
+}
@@ -0,0 +1,184 @@
+/*! @file test_fft.c
+ *
+ *  @brief Host test and benchmark of the fixed-point FFT and harmonic analysis
+ *
+ *  Checks the generated cosine table against cosf, checks DSP_FFT against a double-precision DFT,
+ *  checks DSP_Harmonics on waveforms of known content, and times both.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "dsp.h"
+
+#include <math.h>
+
+// Random windows compared with the reference DFT
+#define NB_RANDOM_WINDOWS 100000
+
+// Transforms run when timing
+#define NB_TIMED_FFTS 2000000
+
+static volatile int32_t Sink;
+
+/*! @brief Compares every entry of the cosine table with cosf.
+ *
+ */
+static void testTable(void)
+{
+  for (unsigned i = 0; i < DSP_COS_TABLE_SIZE; i++)
+    HOST_CHECK(fabsf(DSP_CosTable[i] - INT16_MAX * cosf(2 * (float)M_PI * i / DSP_COS_TABLE_SIZE)) <= 0.5f);
+}
+
+/*! @brief Compares DSP_FFT with a double-precision DFT on random full-scale windows.
+ *
+ */
+static void testAccuracy(void)
+{
+  uint32_t seed = 99;
+  double worstError = 0;
+
+  for (unsigned n = 0; n < NB_RANDOM_WINDOWS; n++)
+  {
+    int32_t re[DSP_FFT_SIZE], im[DSP_FFT_SIZE];
+    int16_t samples[DSP_FFT_SIZE];
+
+    for (uint8_t i = 0; i < DSP_FFT_SIZE; i++)
+    {
+      seed = seed * 1664525 + 1013904223;
+      samples[i] = (int16_t)(seed >> 16);
+      re[i] = samples[i];
+      im[i] = 0;
+    }
+
+    DSP_FFT(re, im);
+
+    for (uint8_t k = 0; k < DSP_FFT_SIZE; k++)
+    {
+      double expectedRe = 0, expectedIm = 0;
+
+      for (uint8_t i = 0; i < DSP_FFT_SIZE; i++)
+      {
+        expectedRe += samples[i] * cos(2 * M_PI * k * i / DSP_FFT_SIZE);
+        expectedIm -= samples[i] * sin(2 * M_PI * k * i / DSP_FFT_SIZE);
+      }
+
+      double error = hypot(re[k] - expectedRe, im[k] - expectedIm);
+      if (error > worstError)
+        worstError = error;
+    }
+  }
+
+  // Against a full-scale bin of DSP_FFT_SIZE * 32768
+  printf("FFT: worst bin error %.1f counts, %.1f dB below a full-scale bin\n", worstError,
+         20 * log10(DSP_FFT_SIZE * 32768.0 / worstError));
+  HOST_CHECK(worstError < DSP_FFT_SIZE * 32768.0 * 1e-4);
+}
+
+/*! @brief Checks the harmonic magnitudes and THD of a distorted waveform.
+ *
+ */
+static void testHarmonics(void)
+{
+  // Percentages of the fundamental for harmonics 1 to 7
+  static const double content[7] = {100, 0, 25, 0, 12, 0, 8};
+
+  double thd = sqrt(25.0 * 25 + 12 * 12 + 8 * 8);
+  double worstHarmonic = 0, worstTHD = 0;
+
+  for (unsigned a = 0; a < 16; a++)
+  {
+    int16_t samples[DSP_FFT_SIZE];
+    THarmonics harmonics;
+
+    for (uint8_t i = 0; i < DSP_FFT_SIZE; i++)
+    {
+      double sample = 0;
+      for (uint8_t h = 1; h <= 7; h++)
+        sample += Host_Sample(5.0 * content[h - 1] / 100, h * (2 * M_PI * (i + a / 16.0) / DSP_FFT_SIZE));
+      samples[i] = (int16_t)sample;
+    }
+
+    DSP_Harmonics(samples, &harmonics);
+
+    for (uint8_t h = 1; h <= DSP_NB_HARMONICS; h++)
+    {
+      double expected = (h <= 7) ? content[h - 1] : 0;
+      double error = fabs(harmonics.harmonic[h - 1] / 100.0 - expected);
+      if (error > worstHarmonic)
+        worstHarmonic = error;
+    }
+
+    if (fabs(harmonics.thd / 100.0 - thd) > worstTHD)
+      worstTHD = fabs(harmonics.thd / 100.0 - thd);
+  }
+
+  printf("harmonics of 5 A with 25%% 3rd, 12%% 5th, 8%% 7th: worst magnitude error %.2f%%, THD %.2f%% within %.2f%%\n",
+         worstHarmonic, thd, worstTHD);
+  HOST_CHECK(worstHarmonic < 0.1);
+  HOST_CHECK(worstTHD < 0.1);
+
+  // A pure sinusoid has no distortion
+  int16_t samples[DSP_FFT_SIZE];
+  THarmonics harmonics;
+
+  for (uint8_t i = 0; i < DSP_FFT_SIZE; i++)
+    samples[i] = Host_Sample(5.0, 2 * M_PI * i / DSP_FFT_SIZE);
+
+  DSP_Harmonics(samples, &harmonics);
+  HOST_CHECK(harmonics.harmonic[0] == 10000);
+  HOST_CHECK(harmonics.thd < 10);
+}
+
+/*! @brief Times the FFT, and the FFT with the harmonic analysis.
+ *
+ */
+static void testCost(void)
+{
+  int16_t samples[DSP_FFT_SIZE];
+  for (uint8_t i = 0; i < DSP_FFT_SIZE; i++)
+    samples[i] = Host_Sample(5.0, 2 * M_PI * i / DSP_FFT_SIZE);
+
+  uint64_t start = Host_Nanoseconds();
+
+  for (unsigned n = 0; n < NB_TIMED_FFTS; n++)
+  {
+    int32_t re[DSP_FFT_SIZE], im[DSP_FFT_SIZE];
+
+    for (uint8_t i = 0; i < DSP_FFT_SIZE; i++)
+    {
+      re[i] = samples[i] + (int32_t)(n & 7);
+      im[i] = 0;
+    }
+
+    DSP_FFT(re, im);
+    Sink = re[1];
+  }
+
+  double fftNs = (double)(Host_Nanoseconds() - start) / NB_TIMED_FFTS;
+
+  THarmonics harmonics;
+  start = Host_Nanoseconds();
+
+  for (unsigned n = 0; n < NB_TIMED_FFTS; n++)
+  {
+    samples[n % DSP_FFT_SIZE] ^= 1;
+    DSP_Harmonics(samples, &harmonics);
+    Sink = harmonics.thd;
+  }
+
+  double harmonicsNs = (double)(Host_Nanoseconds() - start) / NB_TIMED_FFTS;
+
+  printf("host ns per %u-point FFT: %.1f, with the harmonics and THD: %.1f\n", DSP_FFT_SIZE, fftNs, harmonicsNs);
+}
+
+int main(void)
+{
+  testTable();
+  testAccuracy();
+  testHarmonics();
+  testCost();
+
+  return Host_Result();
+}
@@ -0,0 +1,261 @@
+/*! @file test_fifo.c
+ *
+ *  @brief Host stress test and benchmark of the FIFO
+ *
+ *  A producer and a consumer thread pass a counting pattern through a FIFO with the waiting calls,
+ *  in chunks of changing size, and the consumer checks every byte. The same is done through the
+ *  semaphore FIFO FIFO.c had before the ring buffer, copied here, and the bytes per second and
+ *  semaphore calls per byte of each are reported. Also checks the non-waiting calls at the edges.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "FIFO.h"
+
+#include <pthread.h>
+
+// Bytes passed through each FIFO in a run
+#define NB_BYTES 5000000
+
+// Largest chunk put or got in one call
+#define MAX_CHUNK 64
+
+/*! @brief The semaphore FIFO FIFO.c had before the ring buffer
+ *
+ */
+typedef struct
+{
+  uint16_t Start;
+  uint16_t End;
+  uint16_t volatile NbBytes;
+  uint8_t Buffer[FIFO_SIZE];
+  OS_ECB *BufferAccess;
+  OS_ECB *SpaceAvailable;
+  OS_ECB *ItemsAvailable;
+} TOldFIFO;
+
+/*! @brief A run of the stress test
+ *
+ */
+typedef struct
+{
+  bool old;        /*!< TRUE to run the semaphore FIFO */
+  uint16_t chunk;  /*!< Largest chunk per call, 1 for a byte at a time */
+  TFIFO fifo;
+  TOldFIFO oldFIFO;
+  uint32_t errors; /*!< Bytes the consumer got out of sequence */
+} TRun;
+
+/*! @brief Initializes the semaphore FIFO.
+ *
+ *  @param fifo The FIFO.
+ */
+static void oldInit(TOldFIFO * const fifo)
+{
+  fifo->Start = 0;
+  fifo->End = 0;
+  fifo->NbBytes = 0;
+  fifo->BufferAccess = OS_SemaphoreCreate(1);
+  fifo->SpaceAvailable = OS_SemaphoreCreate(FIFO_SIZE);
+  fifo->ItemsAvailable = OS_SemaphoreCreate(0);
+}
+
+/*! @brief Puts one byte into the semaphore FIFO, waiting for space.
+ *
+ *  @param fifo The FIFO.
+ *  @param data The byte.
+ */
+static void oldPut(TOldFIFO * const fifo, const uint8_t data)
+{
+  OS_SemaphoreWait(fifo->SpaceAvailable, 0);
+  OS_SemaphoreWait(fifo->BufferAccess, 0);
+
+  fifo->NbBytes++;
+  fifo->Buffer[fifo->End] = data;
+  fifo->End = (fifo->End + 1) % FIFO_SIZE;
+
+  OS_SemaphoreSignal(fifo->BufferAccess);
+  OS_SemaphoreSignal(fifo->ItemsAvailable);
+}
+
+/*! @brief Gets one byte from the semaphore FIFO, waiting for it to arrive.
+ *
+ *  @param fifo The FIFO.
+ *  @param dataPtr Place to return the byte.
+ */
+static void oldGet(TOldFIFO * const fifo, uint8_t * const dataPtr)
+{
+  OS_SemaphoreWait(fifo->ItemsAvailable, 0);
+  OS_SemaphoreWait(fifo->BufferAccess, 0);
+
+  *dataPtr = fifo->Buffer[fifo->Start];
+  fifo->Start = (fifo->Start + 1) % FIFO_SIZE;
+  fifo->NbBytes--;
+
+  OS_SemaphoreSignal(fifo->BufferAccess);
+  OS_SemaphoreSignal(fifo->SpaceAvailable);
+}
+
+/*! @brief Gets the size of the next chunk, varying so the indices wrap at every offset.
+ *
+ *  @param run The run.
+ *  @param chunkNb The chunk number.
+ *  @param left The bytes left to pass.
+ *  @return uint16_t - The chunk size.
+ */
+static uint16_t chunkSize(const TRun * const run, const uint32_t chunkNb, const uint32_t left)
+{
+  uint16_t size = 1 + (chunkNb * 37) % run->chunk;
+
+  return (size < left) ? size : (uint16_t)left;
+}
+
+/*! @brief Puts the counting pattern into the FIFO.
+ *
+ *  @param arg The run.
+ *  @return void* - Unused.
+ */
+static void *producer(void *arg)
+{
+  TRun *run = arg;
+  uint8_t chunk[MAX_CHUNK];
+  uint32_t sent = 0;
+
+  for (uint32_t chunkNb = 0; sent < NB_BYTES; chunkNb++)
+  {
+    uint16_t size = chunkSize(run, chunkNb, NB_BYTES - sent);
+
+    for (uint16_t byteNb = 0; byteNb < size; byteNb++)
+      chunk[byteNb] = (uint8_t)(sent + byteNb);
+
+    if (run->old)
+    {
+      for (uint16_t byteNb = 0; byteNb < size; byteNb++)
+        oldPut(&run->oldFIFO, chunk[byteNb]);
+    }
+    else
+      FIFO_PutWait(&run->fifo, chunk, size);
+
+    sent += size;
+  }
+
+  return NULL;
+}
+
+/*! @brief Passes the pattern from a producer thread to this one and checks it.
+ *
+ *  @param run The run.
+ *  @return double - The bytes per second.
+ */
+static double stress(TRun * const run)
+{
+  pthread_t thread;
+  uint8_t chunk[MAX_CHUNK];
+  uint32_t got = 0;
+
+  if (run->old)
+    oldInit(&run->oldFIFO);
+  else
+    HOST_CHECK(FIFO_Init(&run->fifo));
+
+  run->errors = 0;
+  uint64_t start = Host_Nanoseconds();
+  pthread_create(&thread, NULL, producer, run);
+
+  // A different chunk pattern from the producer's, so puts and gets don't line up
+  for (uint32_t chunkNb = 11; got < NB_BYTES; chunkNb++)
+  {
+    uint16_t size = chunkSize(run, chunkNb, NB_BYTES - got);
+
+    if (run->old)
+    {
+      for (uint16_t byteNb = 0; byteNb < size; byteNb++)
+        oldGet(&run->oldFIFO, &chunk[byteNb]);
+    }
+    else
+      FIFO_GetWait(&run->fifo, chunk, size);
+
+    for (uint16_t byteNb = 0; byteNb < size; byteNb++)
+      run->errors += (chunk[byteNb] != (uint8_t)(got + byteNb));
+
+    got += size;
+  }
+
+  pthread_join(thread, NULL);
+
+  return NB_BYTES / ((Host_Nanoseconds() - start) * 1e-9);
+}
+
+/*! @brief Runs each FIFO a byte at a time and the ring buffer in chunks, reporting the throughput.
+ *
+ */
+static void testStress(void)
+{
+  static TRun runs[] =
+  {
+    {.old = true, .chunk = 1},
+    {.old = false, .chunk = 1},
+    {.old = false, .chunk = 8},
+    {.old = false, .chunk = MAX_CHUNK},
+  };
+
+  printf("FIFO               chunk  MB/s    semaphore calls per byte  errors\n");
+
+  for (unsigned r = 0; r < sizeof(runs) / sizeof(runs[0]); r++)
+  {
+    uint32_t calls = Host_SemaphoreSignals() + Host_SemaphoreWaits();
+    double rate = stress(&runs[r]);
+    calls = Host_SemaphoreSignals() + Host_SemaphoreWaits() - calls;
+
+    printf("%-17s  %5u  %6.2f  %24.3f  %6u\n", runs[r].old ? "semaphores" : "ring buffer", runs[r].chunk, rate / 1e6,
+           (double)calls / NB_BYTES, runs[r].errors);
+
+    HOST_CHECK(runs[r].errors == 0);
+
+    // The ring buffer only touches a semaphore when one side has to wait
+    if (!runs[r].old)
+      HOST_CHECK(calls < NB_BYTES / 4);
+  }
+}
+
+/*! @brief Checks the non-waiting calls stop at full and empty.
+ *
+ */
+static void testEdges(void)
+{
+  static TFIFO fifo;
+  uint8_t data[FIFO_SIZE + 10];
+
+  for (uint16_t byteNb = 0; byteNb < sizeof(data); byteNb++)
+    data[byteNb] = (uint8_t)byteNb;
+
+  HOST_CHECK(FIFO_Init(&fifo));
+  HOST_CHECK(FIFO_Get(&fifo, data, 1) == 0);
+
+  // Off the start, so the full buffer wraps
+  HOST_CHECK(FIFO_Put(&fifo, data, 5) == 5);
+  HOST_CHECK(FIFO_Get(&fifo, data, 5) == 5);
+
+  HOST_CHECK(FIFO_Put(&fifo, data, sizeof(data)) == FIFO_SIZE);
+  HOST_CHECK(FIFO_NbBytes(&fifo) == FIFO_SIZE);
+  HOST_CHECK(FIFO_Put(&fifo, data, 1) == 0);
+
+  uint8_t got[FIFO_SIZE + 10];
+  HOST_CHECK(FIFO_Get(&fifo, got, sizeof(got)) == FIFO_SIZE);
+  HOST_CHECK(FIFO_NbBytes(&fifo) == 0);
+
+  bool same = true;
+  for (uint16_t byteNb = 0; byteNb < FIFO_SIZE; byteNb++)
+    same = same && (got[byteNb] == (uint8_t)byteNb);
+  HOST_CHECK(same);
+}
+
+int main(void)
+{
+  testEdges();
+  testStress();
+
+  return Host_Result();
+}
@@ -0,0 +1,165 @@
+/*! @file test_fixed.c
+ *
+ *  @brief Host test and benchmark of the fixed-point measurement path
+ *
+ *  Compares the RMS current from DSP_RMSCurrent with the float path it replaced, which converted
+ *  every sample to volts with pow() in double and found the RMS in float, and times both per sample.
+ *  The host has a double-precision FPU, so the timings understate what the float path cost on the
+ *  single-precision K70.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "dsp.h"
+
+#include <math.h>
+
+// Phases tried at each current
+#define NB_ANGLES 32
+
+// Windows run through each path when timing
+#define NB_TIMED_WINDOWS 1000000
+
+static volatile uint32_t FixedSink;
+static volatile float FloatSink;
+
+/*! @brief Converts a raw sample to volts as the float path did.
+ *
+ *  @param raw The raw sample.
+ *  @return float - The voltage.
+ */
+static float rawToVoltage(int16_t raw)
+{
+  return ((float)raw * 20) / pow(2, 16);
+}
+
+/*! @brief Finds the RMS current of a window of voltages as the float path did.
+ *
+ *  @param values The window in volts.
+ *  @return float - The RMS current in amps.
+ */
+static float calculateRMS(float values[])
+{
+  float sumOfVoltages = 0;
+
+  for (int i = 0; i < ANALOG_WINDOW_SIZE; i++)
+    sumOfVoltages += (values[i] * values[i]);
+
+  return sqrtf(sumOfVoltages / ANALOG_WINDOW_SIZE) / 0.35f;
+}
+
+/*! @brief Compares the fixed-point RMS with the float RMS over the measuring range.
+ *
+ */
+static void testError(void)
+{
+  double worstError = 0, worstRelative = 0;
+  unsigned disagreements = 0;
+
+  for (double amps = 0.05; amps < DSP_MAX_CURRENT; amps *= 1.05)
+  {
+    for (unsigned a = 0; a < NB_ANGLES; a++)
+    {
+      int16_t samples[ANALOG_WINDOW_SIZE];
+      float volts[ANALOG_WINDOW_SIZE];
+      uint64_t sumOfSquares = 0;
+
+      for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE; i++)
+      {
+        samples[i] = Host_Sample(amps, 2 * M_PI * (i + (double)a / NB_ANGLES) / ANALOG_WINDOW_SIZE);
+        volts[i] = rawToVoltage(samples[i]);
+        sumOfSquares += (uint64_t)((int32_t)samples[i] * samples[i]);
+      }
+
+      double fixed = DSP_RMSCurrent(sumOfSquares) / (double)DSP_CURRENT_ONE;
+      double reference = calculateRMS(volts);
+      double error = fabs(fixed - reference);
+
+      if (error > worstError)
+        worstError = error;
+      if (error / reference > worstRelative)
+        worstRelative = error / reference;
+
+      // Away from the setting, both paths must make the same pickup decision
+      if (fabs(amps - 1.03) > 0.01 && ((sumOfSquares >= DSP_SUM_OF_SQUARES(1.03)) != (reference >= 1.03f)))
+        disagreements++;
+    }
+  }
+
+  printf("error against float: worst %.3f mA, worst relative %.4f%%, %u pickup disagreements\n",
+         worstError * 1000, worstRelative * 100, disagreements);
+  HOST_CHECK(worstError < 2.0 / DSP_CURRENT_ONE); // Within two steps of Q16.16
+  HOST_CHECK(disagreements == 0);
+}
+
+/*! @brief Times both paths, each doing what it did per sample.
+ *
+ */
+static void testCost(void)
+{
+  int16_t samples[ANALOG_WINDOW_SIZE];
+  for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE; i++)
+    samples[i] = Host_Sample(2.0, 2 * M_PI * i / ANALOG_WINDOW_SIZE);
+
+  // Fixed point: slide the sum of squares and find the RMS on every sample
+  int16_t window[ANALOG_WINDOW_SIZE] = {0};
+  uint64_t sumOfSquares = 0;
+  uint64_t start = Host_Nanoseconds();
+
+  for (unsigned w = 0; w < NB_TIMED_WINDOWS; w++)
+  {
+    for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE; i++)
+    {
+      int16_t sample = samples[i] + (int16_t)(w & 7);
+      sumOfSquares += (uint32_t)(sample * sample);
+      sumOfSquares -= (uint32_t)(window[i] * window[i]);
+      window[i] = sample;
+      FixedSink = DSP_RMSCurrent(sumOfSquares);
+    }
+  }
+
+  double fixedNs = (double)(Host_Nanoseconds() - start) / (NB_TIMED_WINDOWS * ANALOG_WINDOW_SIZE);
+
+  // Fixed point with the RMS once a window, like for like with the float path
+  start = Host_Nanoseconds();
+
+  for (unsigned w = 0; w < NB_TIMED_WINDOWS; w++)
+  {
+    for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE; i++)
+    {
+      int16_t sample = samples[i] + (int16_t)(w & 7);
+      sumOfSquares += (uint32_t)(sample * sample);
+      sumOfSquares -= (uint32_t)(window[i] * window[i]);
+      window[i] = sample;
+    }
+    FixedSink = DSP_RMSCurrent(sumOfSquares);
+  }
+
+  double fixedWindowNs = (double)(Host_Nanoseconds() - start) / (NB_TIMED_WINDOWS * ANALOG_WINDOW_SIZE);
+
+  // Float: convert every sample, and find the RMS once a window
+  float volts[ANALOG_WINDOW_SIZE];
+  start = Host_Nanoseconds();
+
+  for (unsigned w = 0; w < NB_TIMED_WINDOWS; w++)
+  {
+    for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE; i++)
+      volts[i] = rawToVoltage(samples[i] + (int16_t)(w & 7));
+    FloatSink = calculateRMS(volts);
+  }
+
+  double floatNs = (double)(Host_Nanoseconds() - start) / (NB_TIMED_WINDOWS * ANALOG_WINDOW_SIZE);
+
+  printf("host ns per sample: fixed point %.2f with the RMS every sample, %.2f with it every window; float %.2f with it every window\n",
+         fixedNs, fixedWindowNs, floatNs);
+}
+
+int main(void)
+{
+  testError();
+  testCost();
+
+  return Host_Result();
+}
@@ -0,0 +1,289 @@
+/*! @file test_freq.c
+ *
+ *  @brief Host test of the frequency tracker against steps, ramps, noise and loss of signal
+ *
+ *  Closes the loop retuneSampling in main.c closes: three phases are sampled at the rate the last
+ *  estimate set, stamped in whole microseconds as PIT_TimeGet does, and passed to Freq_Update, with
+ *  Freq_Estimate called once a cycle. Reports the tracking error, the settling time and the ROCOF
+ *  error of each case, checks the history the estimates leave, and times the loss and return of lock.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "freq.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// Current in each phase in amps
+#define CURRENT 10.0
+
+// Band an estimate must stay within to have settled, in Hz
+#define SETTLED_BAND 0.05
+
+/*! @brief A frequency profile, stepping or ramping from one frequency to another
+ *
+ */
+typedef struct
+{
+  const char *name;
+  double from;     /*!< Frequency at the start in Hz */
+  double to;       /*!< Frequency at the end in Hz */
+  double change;   /*!< Time the change starts in seconds */
+  double rate;     /*!< Rate of the change in Hz/s, 0 for a step */
+  double noise;    /*!< RMS noise on each sample as a fraction of the amplitude */
+  double duration; /*!< Length of the run in seconds */
+  double lost;     /*!< Time the signal is lost in seconds, 0 if it never is */
+  double restored; /*!< Time the signal returns in seconds */
+} TProfile;
+
+/*! @brief The results of a run
+ *
+ */
+typedef struct
+{
+  double steadyError; /*!< Worst error once settled at the final frequency in Hz */
+  double rampError;   /*!< Worst error during the ramp in Hz */
+  double settling;    /*!< Time from the end of the change to settling in seconds, negative if it never settled */
+  double rocofError;  /*!< Worst ROCOF error once the ROCOF window is within the ramp, or in the steady state, in Hz/s */
+  double unlocking;   /*!< Time from the loss of signal to the loss of lock in seconds, negative if it stayed locked */
+  double relocking;   /*!< Time from the return of signal to lock in seconds, negative if it never locked again */
+  bool unlockedQuiet; /*!< TRUE if nothing was added to the history and the ROCOF read 0 while unlocked */
+} TResult;
+
+/*! @brief Gets the frequency of a profile at a time.
+ *
+ *  @param profile The profile.
+ *  @param time The time in seconds.
+ *  @return double - The frequency in Hz.
+ */
+static double frequencyAt(const TProfile * const profile, const double time)
+{
+  if (time < profile->change)
+    return profile->from;
+
+  if (profile->rate == 0)
+    return profile->to;
+
+  double frequency = profile->from + copysign(profile->rate * (time - profile->change), profile->to - profile->from);
+
+  return (profile->to > profile->from) ? fmin(frequency, profile->to) : fmax(frequency, profile->to);
+}
+
+/*! @brief Gets the rate of change of a profile at a time.
+ *
+ *  @param profile The profile.
+ *  @param time The time in seconds.
+ *  @return double - The rate of change in Hz/s.
+ */
+static double rateAt(const TProfile * const profile, const double time)
+{
+  if (profile->rate == 0 || time < profile->change || fabs(frequencyAt(profile, time) - profile->to) < 1e-9)
+    return 0;
+
+  return copysign(profile->rate, profile->to - profile->from);
+}
+
+/*! @brief Gets the time a profile reaches its final frequency.
+ *
+ *  @param profile The profile.
+ *  @return double - The time in seconds.
+ */
+static double changeEnd(const TProfile * const profile)
+{
+  return profile->change + ((profile->rate == 0) ? 0 : fabs(profile->to - profile->from) / profile->rate);
+}
+
+/*! @brief Draws normally distributed noise.
+ *
+ *  @return double - A sample of unit variance.
+ */
+static double gaussian(void)
+{
+  double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+  double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+  return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+/*! @brief Gets the time of the newest estimate in the history.
+ *
+ *  @return uint64_t - The time in microseconds, 0 if the history is empty.
+ */
+static uint64_t newestEstimate(void)
+{
+  TFreqSample history[FREQ_HISTORY_SIZE];
+  uint8_t count = Freq_History(history);
+
+  return (count > 0) ? history[count - 1].time : 0;
+}
+
+/*! @brief Tracks a frequency profile, retuning the sample rate after each estimate as main.c does.
+ *
+ *  @param profile The profile.
+ *  @param result Place to return the results.
+ */
+static void run(const TProfile * const profile, TResult * const result)
+{
+  double phase = 0;
+  uint64_t nanoseconds = 0;
+  uint32_t period = (uint32_t)(1e9 / FREQ_NOMINAL / ANALOG_WINDOW_SIZE);
+  double end = changeEnd(profile), settled = -1;
+  // The ROCOF is fitted to a window of estimates a cycle apart, each lagging by half the crossings fitted
+  // and the smoothing
+  double rocofSpan = (FREQ_ROCOF_WINDOW + FREQ_NB_CYCLES / 2 + 1 / FREQ_SMOOTHING) / profile->from;
+
+  *result = (TResult){0, 0, -1, 0, -1, -1, true};
+  Freq_Init();
+  srand(1);
+
+  for (unsigned n = 0; nanoseconds < profile->duration * 1e9; n++)
+  {
+    double time = nanoseconds * 1e-9;
+    int16_t samples[DSP_NB_PHASES];
+    bool live = (profile->lost == 0 || time < profile->lost || time >= profile->restored);
+
+    for (uint8_t phaseNb = 0; phaseNb < DSP_NB_PHASES; phaseNb++)
+    {
+      if (!live)
+      {
+        samples[phaseNb] = 0;
+        continue;
+      }
+
+      double noise = profile->noise * CURRENT * M_SQRT2 * DSP_RAW_PER_AMP * gaussian();
+      samples[phaseNb] = Host_Sample(CURRENT, phase - 2 * M_PI * phaseNb / 3) + (int16_t)lround(noise);
+    }
+
+    Freq_Update(samples, nanoseconds / 1000);
+
+    if (n % ANALOG_WINDOW_SIZE == ANALOG_WINDOW_SIZE - 1)
+    {
+      uint64_t newest = newestEstimate();
+
+      if (Freq_Estimate(nanoseconds / 1000))
+      {
+        double error = fabs(Freq_Get() - frequencyAt(profile, time));
+
+        if (time >= profile->change && time < end)
+          result->rampError = fmax(result->rampError, error);
+
+        if (time >= end)
+        {
+          // Settled from the first estimate that stays in the band to the end
+          if (error > SETTLED_BAND)
+            settled = -1;
+          else if (settled < 0)
+            settled = time;
+        }
+
+        // The estimates over the last half second are steady state
+        if (time >= profile->duration - 0.5)
+          result->steadyError = fmax(result->steadyError, error);
+
+        // Within a ramp once the window has filled with it, and in the steady state
+        if ((time >= profile->change + rocofSpan && time < end) || time >= profile->duration - 0.5)
+          result->rocofError = fmax(result->rocofError, fabs(Freq_ROCOF() - rateAt(profile, time)));
+
+        if (profile->lost > 0 && time >= profile->restored && result->relocking < 0)
+          result->relocking = time - profile->restored;
+
+        period = (uint32_t)((1e9f / Freq_Get()) / ANALOG_WINDOW_SIZE);
+      }
+      else if (!Freq_Locked())
+      {
+        if (profile->lost > 0 && time >= profile->lost && result->unlocking < 0)
+          result->unlocking = time - profile->lost;
+
+        if (Freq_ROCOF() != 0 || newestEstimate() != newest)
+          result->unlockedQuiet = false;
+      }
+    }
+
+    // The phase advances at the true frequency over the period the PIT was set to
+    phase += 2 * M_PI * frequencyAt(profile, time) * period * 1e-9;
+    nanoseconds += period;
+  }
+
+  result->settling = (settled < 0) ? -1 : settled - end;
+}
+
+int main(void)
+{
+  static const TProfile profiles[] =
+  {
+    {"50 Hz",               50, 50, 0, 0, 0, 3},
+    {"60 Hz from start",    60, 60, 0, 0, 0, 3},
+    {"45 Hz",               45, 45, 0, 0, 0, 3},
+    {"65 Hz",               65, 65, 0, 0, 0, 3},
+    {"step 50 to 51 Hz",    50, 51, 1, 0, 0, 3},
+    {"step 60 to 58 Hz",    60, 58, 1, 0, 0, 3},
+    {"ramp 50 to 49 at 1",  50, 49, 1, 1, 0, 4},
+    {"ramp 50 to 47 at 5",  50, 47, 1, 5, 0, 3},
+    {"ramp 60 to 62 at 2",  60, 62, 1, 2, 0, 4},
+    {"50 Hz, 1% noise",     50, 50, 0, 0, 0.01, 3},
+    {"50 Hz, 5% noise",     50, 50, 0, 0, 0.05, 3},
+    {"ramp at 1, 5% noise", 50, 49, 1, 1, 0.05, 4},
+    {"50 Hz, lost for 0.5", 50, 50, 0, 0, 0, 3, 1, 1.5},
+    {"60 Hz, lost for 0.1", 60, 60, 0, 0, 0, 3, 1, 1.1},
+  };
+
+  printf("case                   ramp error  settling  steady error  ROCOF error (Hz, s, Hz, Hz/s)\n");
+
+  for (unsigned p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++)
+  {
+    const TProfile *profile = &profiles[p];
+    TResult result;
+
+    run(profile, &result);
+    printf("%-21s  %10.4f  %8.3f  %12.5f  %11.4f\n",
+           profile->name, result.rampError, result.settling, result.steadyError, result.rocofError);
+
+    // Settles within half a second of the change ending, about the 8 cycle fit plus the smoothing, and then
+    // holds to within a few mHz, more with noise
+    HOST_CHECK(result.settling >= 0 && result.settling < 0.5);
+    HOST_CHECK(result.steadyError < 0.002 + profile->noise * 0.5);
+
+    // A ramp is followed at a lag of a few cycles: the fit spans 8 and the smoothing adds about 3
+    if (profile->rate > 0)
+      HOST_CHECK(result.rampError < profile->rate * 12 / profile->from + SETTLED_BAND);
+
+    // Without noise the ROCOF reads a ramp to within 15% once its window is in the ramp, and 0 when steady
+    if (profile->noise == 0)
+      HOST_CHECK(result.rocofError < 0.01 + 0.15 * profile->rate);
+
+    if (profile->lost > 0)
+    {
+      printf("  lock lost %.3f s after the signal, regained %.3f s after it returned\n", result.unlocking, result.relocking);
+
+      // Two nominal periods without a crossing age every series out, then the next estimate fails
+      HOST_CHECK(result.unlocking >= 0 && result.unlocking <= 3.0 / FREQ_NOMINAL);
+      HOST_CHECK(result.relocking >= 0 && result.relocking <= 3.0 / profile->to);
+      HOST_CHECK(result.unlockedQuiet);
+    }
+  }
+
+  // The history holds the latest estimates a cycle apart, oldest first, ending with the current one
+  TFreqSample history[FREQ_HISTORY_SIZE];
+  uint8_t count = Freq_History(history);
+  bool ordered = true;
+
+  for (uint8_t i = 1; i < count; i++)
+  {
+    double interval = (history[i].time - history[i - 1].time) * 1e-6;
+    ordered = ordered && fabs(interval - 1 / history[i].frequency) < 0.002;
+  }
+
+  HOST_CHECK(count == FREQ_HISTORY_SIZE);
+  HOST_CHECK(ordered);
+  HOST_CHECK(history[count - 1].frequency == Freq_Get());
+
+  // The ROCOF window is bounded by the history
+  HOST_CHECK(!Freq_SetROCOFWindow(1));
+  HOST_CHECK(!Freq_SetROCOFWindow(FREQ_HISTORY_SIZE + 1));
+  HOST_CHECK(Freq_SetROCOFWindow(FREQ_HISTORY_SIZE));
+
+  return Host_Result();
+}
@@ -0,0 +1,125 @@
+/*! @file test_highset.c
+ *
+ *  @brief Host benchmark of the high-set element's operating time
+ *
+ *  Replays faults through the half-cycle sum of absolute samples that highSetSample in main.c
+ *  keeps, and reports the time from fault inception to the sample that asks for the trip. The DSP
+ *  thread is signalled on that sample, so this is the operating time less one wakeup.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "dsp.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// High-set setting in 0.1 A, not a whole number of amps
+#define SETTING 55
+
+// Load current before each fault
+#define LOAD_CURRENT 1.0
+
+// Raw sample period in microseconds at 50 Hz
+#define RAW_SAMPLE_PERIOD (1250.0 / DSP_OVERSAMPLING_RATIO)
+
+// Inception angles tried for each fault, evenly spread over a cycle
+#define NB_ANGLES 64
+
+// Cycles a fault below the setting is held without operating
+#define NB_SECURE_CYCLES 20
+
+static const uint32_t highSetSumPerAmp = DSP_HALF_CYCLE_ABS_SUM(1.0);
+
+/*! @brief The half-cycle history of a channel, as main.c keeps it
+ *
+ */
+typedef struct
+{
+  int16_t samples[DSP_RAW_WINDOW_SIZE / 2];
+  uint32_t sum;
+  uint8_t position;
+} THalfCycle;
+
+/*! @brief Adds a sample to the half-cycle sum, as highSetSample does.
+ *
+ *  @param halfCycle The half-cycle history.
+ *  @param sample The raw sample.
+ *  @return bool - TRUE if the element operates.
+ */
+static bool highSet(THalfCycle * const halfCycle, const int16_t sample)
+{
+  halfCycle->sum += abs(sample);
+  halfCycle->sum -= abs(halfCycle->samples[halfCycle->position]);
+  halfCycle->samples[halfCycle->position] = sample;
+  halfCycle->position = (halfCycle->position + 1) % (DSP_RAW_WINDOW_SIZE / 2);
+
+  return halfCycle->sum * 10 >= SETTING * highSetSumPerAmp;
+}
+
+/*! @brief Replays a fault after a cycle of load.
+ *
+ *  @param amps The fault current in amps.
+ *  @param angle The phase at inception in radians.
+ *  @param nbCycles The cycles of fault to replay.
+ *  @return unsigned - The samples from inception to operation, or 0 if it didn't operate.
+ */
+static unsigned replay(const double amps, const double angle, const unsigned nbCycles)
+{
+  THalfCycle halfCycle = {{0}, 0, 0};
+  double step = 2 * M_PI / DSP_RAW_WINDOW_SIZE;
+
+  for (int n = -2 * DSP_RAW_WINDOW_SIZE; n < 0; n++)
+  {
+    if (highSet(&halfCycle, Host_Sample(LOAD_CURRENT, angle + n * step)))
+      return 0;
+  }
+
+  for (unsigned n = 0; n < nbCycles * DSP_RAW_WINDOW_SIZE; n++)
+  {
+    if (highSet(&halfCycle, Host_Sample(amps, angle + n * step)))
+      return n + 1;
+  }
+
+  return 0;
+}
+
+int main(void)
+{
+  static const double multiples[] = {1.2, 1.5, 2, 3, 3.8};
+
+  printf("fault (x %.1f A)  operating time mean / worst (ms)\n", SETTING / 10.0);
+
+  for (unsigned m = 0; m < sizeof(multiples) / sizeof(multiples[0]); m++)
+  {
+    double total = 0, worst = 0;
+
+    for (unsigned a = 0; a < NB_ANGLES; a++)
+    {
+      unsigned samples = replay(SETTING / 10.0 * multiples[m], 2 * M_PI * a / NB_ANGLES, 2);
+      double time = samples * RAW_SAMPLE_PERIOD / 1000;
+
+      HOST_CHECK(samples != 0);
+      total += time;
+      if (time > worst)
+        worst = time;
+    }
+
+    printf("%13.1f  %8.2f / %.2f\n", multiples[m], total / NB_ANGLES, worst);
+
+    // Within half a cycle, well inside the one cycle asked for
+    HOST_CHECK(worst <= 10.0);
+  }
+
+  // Just below the setting it must never operate, whatever the inception angle
+  unsigned operations = 0;
+  for (unsigned a = 0; a < NB_ANGLES; a++)
+    operations += (replay(SETTING / 10.0 * 0.97, 2 * M_PI * a / NB_ANGLES, NB_SECURE_CYCLES) != 0);
+
+  printf("0.97x setting for %d cycles: %u operations in %d angles\n", NB_SECURE_CYCLES, operations, NB_ANGLES);
+  HOST_CHECK(operations == 0);
+
+  return Host_Result();
+}
@@ -0,0 +1,105 @@
+/*! @file test_idmt.c
+ *
+ *  @brief Host test and benchmark of the IDMT trip rate tables
+ *
+ *  Sweeps IDMT_TripRate across the range of each table, reporting its worst error against pow(),
+ *  the Flash the generated tables take and the time of a lookup against a call to powf.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "idmt.h"
+#include "dsp.h"
+
+#include <math.h>
+
+// Number of relay characteristics
+#define NB_CHARACTERISTICS 3
+
+// Lookups timed for each method
+#define NB_TIMED_LOOKUPS 50000000
+
+static const double k[NB_CHARACTERISTICS] = {0.14, 13.5, 80};
+static const double a[NB_CHARACTERISTICS] = {0.02, 1, 2};
+static const char *NAMES[NB_CHARACTERISTICS] = {"Inverse", "VeryInverse", "ExtremelyInverse"};
+
+static volatile uint32_t Sink;
+static volatile float FloatSink;
+
+/*! @brief Compares every Q16.16 step of the first octave, and a dense sweep above it, with pow().
+ *
+ */
+static void testError(void)
+{
+  printf("curve             worst error from 1.03x to 64x  at\n");
+
+  for (RELAY_CHARACTERISTIC characteristic = Inverse; characteristic <= ExtremelyInverse; characteristic++)
+  {
+    double worstError = 0, worstAt = 0;
+    uint32_t previous = 0;
+    bool monotonic = true;
+
+    for (uint32_t current = DSP_CURRENT(1.03); current < DSP_CURRENT(64); current += (current < DSP_CURRENT(2)) ? 1 : 37)
+    {
+      uint32_t rate = IDMT_TripRate(characteristic, current);
+      double multiple = (double)current / DSP_CURRENT_ONE;
+      double expected = (pow(multiple, a[characteristic]) - 1) / k[characteristic];
+      double error = fabs((double)rate / IDMT_RATE_ONE - expected) / expected;
+
+      if (error > worstError)
+      {
+        worstError = error;
+        worstAt = multiple;
+      }
+
+      if (rate < previous)
+        monotonic = false;
+      previous = rate;
+    }
+
+    printf("%-16s  %28.4f%%  %.3fx\n", NAMES[characteristic], worstError * 100, worstAt);
+    HOST_CHECK(worstError < 0.005);
+    HOST_CHECK(monotonic);
+
+    // Never trips at or below the setting, and holds the last entry beyond the table
+    HOST_CHECK(IDMT_TripRate(characteristic, DSP_CURRENT_ONE) == 0);
+    HOST_CHECK(IDMT_TripRate(characteristic, DSP_CURRENT(0.5)) == 0);
+    HOST_CHECK(IDMT_TripRate(characteristic, DSP_CURRENT(100)) == IDMT_TripRate(characteristic, DSP_CURRENT(64)));
+  }
+}
+
+/*! @brief Times a table lookup against the powf call it replaced.
+ *
+ */
+static void testCost(void)
+{
+  uint64_t start = Host_Nanoseconds();
+
+  for (uint32_t n = 0; n < NB_TIMED_LOOKUPS; n++)
+    Sink = IDMT_TripRate(Inverse, DSP_CURRENT(1.1) + (n & 0xFFFFF));
+
+  double lookupNs = (double)(Host_Nanoseconds() - start) / NB_TIMED_LOOKUPS;
+
+  start = Host_Nanoseconds();
+
+  for (uint32_t n = 0; n < NB_TIMED_LOOKUPS; n++)
+  {
+    float multiple = (float)(DSP_CURRENT(1.1) + (n & 0xFFFFF)) / DSP_CURRENT_ONE;
+    FloatSink = 0.14f / (powf(multiple, 0.02f) - 1);
+  }
+
+  double powNs = (double)(Host_Nanoseconds() - start) / NB_TIMED_LOOKUPS;
+
+  printf("tables: %u bytes of Flash; host ns per lookup %.2f, per powf trip time %.2f\n", (unsigned)sizeof(IDMT_TripRates), lookupNs,
+         powNs);
+}
+
+int main(void)
+{
+  testError();
+  testCost();
+
+  return Host_Result();
+}
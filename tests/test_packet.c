@@ -0,0 +1,238 @@
+/*! @file test_packet.c
+ *
+ *  @brief Host fuzz test and benchmark of the packet parser
+ *
+ *  Streams random packets with bit errors injected at a range of error rates through Packet_Get,
+ *  from a stand-in UART_InChars that hands over a few bytes at a time as the receive FIFO would.
+ *  Reports the goodput, the false packets let through, and the resync latency: the clean packets
+ *  lost after each error before the parser locks back on. Then times the parser taking batches of
+ *  packets from chunks of changing size.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "packet.h"
+#include "UART.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Packets streamed at each error rate
+#define NB_PACKETS 1000000
+
+// Packets taken per call when timing, as the packet thread takes them
+#define BATCH_NB_PACKETS 8
+
+static uint8_t *Stream;     /*!< The bytes on the wire */
+static uint32_t StreamPos;  /*!< Bytes handed over so far */
+static uint32_t StreamSize;
+static uint16_t Chunk;      /*!< Most bytes handed over per call, as the receive FIFO holds */
+
+uint16_t UART_InChars(uint8_t data[], const uint16_t nbBytes)
+{
+  uint32_t nbCopy = (Chunk < nbBytes) ? Chunk : nbBytes;
+
+  if (nbCopy > StreamSize - StreamPos)
+    nbCopy = StreamSize - StreamPos;
+
+  memcpy(data, &Stream[StreamPos], nbCopy);
+  StreamPos += nbCopy;
+
+  return (uint16_t)nbCopy;
+}
+
+bool UART_Init(const uint32_t baudRate, const uint32_t moduleClk)
+{
+  return true;
+}
+
+bool UART_OutChars(const uint8_t data[], const uint8_t nbBytes)
+{
+  return true;
+}
+
+bool UART_OutUrgent(const uint8_t data[], const uint8_t nbBytes)
+{
+  return true;
+}
+
+void UART_BeginBurst(void)
+{
+}
+
+void UART_EndBurst(void)
+{
+}
+
+/*! @brief Gets the next number of a fixed pseudo-random sequence, so each run streams the same bytes.
+ *
+ *  @param state The sequence's state.
+ *  @return uint32_t - The next number.
+ */
+static uint32_t next(uint64_t * const state)
+{
+  *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+  return (uint32_t)(*state >> 32);
+}
+
+/*! @brief Fills the stream with packets, then flips bits at random at the given rate.
+ *
+ *  @param packets A place to put the packets as sent.
+ *  @param hit A place to mark the packets a bit error landed in.
+ *  @param errorRate The chance of each bit being flipped.
+ *  @return uint32_t - The number of packets hit.
+ */
+static uint32_t fill(TPacket packets[], bool hit[], const double errorRate)
+{
+  uint64_t state = 1234;
+  uint32_t nbHit = 0;
+
+  for (uint32_t packetNb = 0; packetNb < NB_PACKETS; packetNb++)
+  {
+    uint8_t *bytes = packets[packetNb].bytes;
+    uint32_t random = next(&state);
+
+    bytes[0] = (uint8_t)random;
+    bytes[1] = (uint8_t)(random >> 8);
+    bytes[2] = (uint8_t)(random >> 16);
+    bytes[3] = (uint8_t)(random >> 24);
+    bytes[4] = bytes[0] ^ bytes[1] ^ bytes[2] ^ bytes[3];
+
+    memcpy(&Stream[packetNb * PACKET_NB_BYTES], bytes, PACKET_NB_BYTES);
+    hit[packetNb] = false;
+  }
+
+  // The gaps between errors are geometric, so the errors can be placed without visiting every bit
+  uint64_t bitNb = 0;
+  while (errorRate > 0)
+  {
+    double uniform = (next(&state) + 1.0) / 4294967296.0;
+    bitNb += 1 + (uint64_t)(log(uniform) / log1p(-errorRate));
+    if (bitNb >= (uint64_t)StreamSize * 8)
+      break;
+
+    Stream[bitNb / 8] ^= (uint8_t)(1 << (bitNb % 8));
+
+    uint32_t packetNb = (uint32_t)(bitNb / (8 * PACKET_NB_BYTES));
+    nbHit += !hit[packetNb];
+    hit[packetNb] = true;
+  }
+
+  return nbHit;
+}
+
+/*! @brief Streams packets with bit errors through the parser, a packet per call, and checks what it lets through.
+ *
+ */
+static void testFuzz(void)
+{
+  static const double errorRates[] = {0, 1e-5, 1e-4, 1e-3, 1e-2};
+
+  TPacket *packets = malloc(NB_PACKETS * sizeof(TPacket));
+  bool *hit = malloc(NB_PACKETS * sizeof(bool));
+  bool *delivered = malloc(NB_PACKETS * sizeof(bool));
+
+  printf("bit error rate  packets hit  goodput of clean packets  false packets  clean packets lost per error\n");
+
+  for (unsigned r = 0; r < sizeof(errorRates) / sizeof(errorRates[0]); r++)
+  {
+    uint32_t nbHit = fill(packets, hit, errorRates[r]);
+    uint32_t nbGood = 0, nbFalse = 0;
+    TPacket packet;
+
+    memset(delivered, 0, NB_PACKETS * sizeof(bool));
+    StreamPos = 0;
+    Chunk = PACKET_NB_BYTES;
+
+    // Taking one packet at a time, the parser stops reading on the packet's last byte
+    while (StreamPos < StreamSize)
+    {
+      if (Packet_Get(&packet, 1) == 0)
+        continue;
+
+      uint32_t packetNb = StreamPos / PACKET_NB_BYTES - 1;
+      if (StreamPos % PACKET_NB_BYTES == 0 && !hit[packetNb] && memcmp(packet.bytes, packets[packetNb].bytes, PACKET_NB_BYTES) == 0)
+      {
+        delivered[packetNb] = true;
+        nbGood++;
+      }
+      else
+        nbFalse++;
+    }
+
+    // Count the clean packets from each run of errors up to the first one delivered
+    uint32_t nbLost = 0, nbRuns = 0;
+    for (uint32_t packetNb = 0; packetNb < NB_PACKETS; packetNb++)
+    {
+      if (!hit[packetNb])
+        continue;
+
+      nbRuns++;
+      while (packetNb + 1 < NB_PACKETS && !delivered[packetNb + 1])
+        nbLost += !hit[++packetNb];
+    }
+
+    double goodput = (double)nbGood / (NB_PACKETS - nbHit);
+    double lostPerError = nbRuns ? (double)nbLost / nbRuns : 0;
+
+    printf("%14g  %11u  %23.3f%%  %13u  %28.3f\n", errorRates[r], nbHit, goodput * 100, nbFalse, lostPerError);
+
+    // Clean packets are only lost while the parser locks back on, which takes under a packet on average
+    if (errorRates[r] == 0)
+      HOST_CHECK(nbGood == NB_PACKETS && nbFalse == 0);
+    if (errorRates[r] <= 1e-3)
+      HOST_CHECK(goodput > 0.99);
+    HOST_CHECK(lostPerError < 1);
+  }
+
+  free(packets);
+  free(hit);
+  free(delivered);
+}
+
+/*! @brief Times the parser taking batches of packets from chunks of changing size.
+ *
+ */
+static void testThroughput(void)
+{
+  TPacket *packets = malloc(NB_PACKETS * sizeof(TPacket));
+  bool *hit = malloc(NB_PACKETS * sizeof(bool));
+  TPacket batch[BATCH_NB_PACKETS];
+  uint32_t nbGot = 0;
+
+  fill(packets, hit, 0);
+  StreamPos = 0;
+  uint64_t start = Host_Nanoseconds();
+
+  while (StreamPos < StreamSize)
+  {
+    Chunk = 1 + (StreamPos * 2654435761u >> 27);
+    nbGot += Packet_Get(batch, BATCH_NB_PACKETS);
+  }
+
+  double ns = (double)(Host_Nanoseconds() - start);
+  printf("batches of %u from chunks of 1 to 32 bytes: host ns per byte %.2f, %.0f MB/s\n", BATCH_NB_PACKETS, ns / StreamSize,
+         StreamSize / ns * 1e3);
+
+  // Bytes the last fuzz run left in the window can cost the first packet
+  HOST_CHECK(nbGot >= NB_PACKETS - 1);
+
+  free(packets);
+  free(hit);
+}
+
+int main(void)
+{
+  StreamSize = NB_PACKETS * PACKET_NB_BYTES;
+  Stream = malloc(StreamSize);
+
+  testFuzz();
+  testThroughput();
+
+  free(Stream);
+
+  return Host_Result();
+}
@@ -0,0 +1,249 @@
+/*! @file test_phasor.c
+ *
+ *  @brief Host test and benchmark of the phasors read from the sliding fundamental DFT
+ *
+ *  Slides three-phase sets through a DSP_DFTUpdate bin per phase, as processSample does, and reads
+ *  the phasors the way CMD_SendDORPhasorPacket in cmd.c does: magnitude through DSP_DFTSumOfSquares
+ *  and DSP_RMSCurrent, angle from DSP_DFTAngle relative to phase A. Reports the magnitude and angle
+ *  errors at and off the tracked frequency, and the cost of a sliding update against a batch DFT of
+ *  the window on every sample.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "dsp.h"
+
+#include <math.h>
+
+// Cycles slid through for each case, the phasors being read at every sample of the last
+#define NB_CYCLES 4
+
+// Phases of phase A tried for each case
+#define NB_ANGLES 16
+
+// Samples slid through when timing
+#define NB_TIMED_SAMPLES 20000000
+
+static volatile int32_t Sink;
+
+/*! @brief The worst errors of a case
+ *
+ */
+typedef struct
+{
+  double magnitude; /*!< Worst magnitude error as a fraction of the true magnitude */
+  double angle;     /*!< Worst angle error in degrees */
+} TErrors;
+
+/*! @brief Reads a phasor as CMD_SendDORPhasorPacket does.
+ *
+ *  @param bin The phase's fundamental bin.
+ *  @param reference The angle of phase A in degrees.
+ *  @param amps Place to return the magnitude in amps RMS.
+ *  @return double - The angle relative to phase A, from -180 to 180 degrees.
+ */
+static double readPhasor(const TDFTBin * const bin, const float reference, double * const amps)
+{
+  *amps = (double)DSP_RMSCurrent(DSP_DFTSumOfSquares(bin)) / DSP_CURRENT_ONE;
+
+  float angle = DSP_DFTAngle(bin) - reference;
+  if (angle > 180.0f)
+    angle -= 360.0f;
+  else if (angle <= -180.0f)
+    angle += 360.0f;
+
+  return angle;
+}
+
+/*! @brief Slides an unbalanced three-phase set through the bins and reads the phasors at every sample.
+ *
+ *  @param amps The RMS current of each phase in amps.
+ *  @param angles The angle of each phase relative to phase A in degrees.
+ *  @param frequency The frequency as a multiple of the one the sample rate is locked to.
+ *  @param errors Place to return the worst errors.
+ */
+static void slide(const double amps[DSP_NB_PHASES], const double angles[DSP_NB_PHASES], const double frequency, TErrors * const errors)
+{
+  *errors = (TErrors){0, 0};
+
+  for (unsigned a = 0; a < NB_ANGLES; a++)
+  {
+    TDFTBin bins[DSP_NB_PHASES] = {{0, 0}};
+    int16_t windows[DSP_NB_PHASES][ANALOG_WINDOW_SIZE] = {{0}};
+    double start = 2 * M_PI * a / NB_ANGLES;
+
+    for (unsigned n = 0; n < NB_CYCLES * ANALOG_WINDOW_SIZE; n++)
+    {
+      uint8_t position = n % ANALOG_WINDOW_SIZE;
+
+      for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+      {
+        double radians = start + angles[phase] * M_PI / 180 + 2 * M_PI * frequency * n / ANALOG_WINDOW_SIZE;
+        int16_t sample = Host_Sample(amps[phase], radians);
+
+        DSP_DFTUpdate(&bins[phase], sample, windows[phase][position], position);
+        windows[phase][position] = sample;
+      }
+
+      if (n < (NB_CYCLES - 1) * ANALOG_WINDOW_SIZE)
+        continue;
+
+      float reference = DSP_DFTAngle(&bins[0]);
+
+      for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+      {
+        double magnitude;
+        double angle = readPhasor(&bins[phase], reference, &magnitude);
+
+        errors->magnitude = fmax(errors->magnitude, fabs(magnitude - amps[phase]) / amps[phase]);
+        errors->angle = fmax(errors->angle, fabs(remainder(angle - angles[phase], 360)));
+      }
+    }
+  }
+}
+
+/*! @brief Checks the phasors of balanced and unbalanced sets across the current range.
+ *
+ */
+static void testAccuracy(void)
+{
+  static const double sets[][2][DSP_NB_PHASES] =
+  {
+    {{1, 1, 1},       {0, -120, 120}},
+    {{0.2, 0.2, 0.2}, {0, -120, 120}},
+    {{15, 15, 15},    {0, -120, 120}},
+    {{5, 2, 8},       {0, -100, 150}},
+    {{10, 0.5, 0.5},  {0, -170, 170}},
+  };
+
+  printf("phases (A)         angles (degrees)   magnitude error  angle error (degrees)\n");
+
+  for (unsigned s = 0; s < sizeof(sets) / sizeof(sets[0]); s++)
+  {
+    TErrors errors;
+
+    slide(sets[s][0], sets[s][1], 1.0, &errors);
+    printf("%4.1f %4.1f %4.1f     %4.0f %4.0f %4.0f     %14.3f%%  %11.3f\n", sets[s][0][0], sets[s][0][1], sets[s][0][2],
+           sets[s][1][0], sets[s][1][1], sets[s][1][2], errors.magnitude * 100, errors.angle);
+
+    // Quantisation of the smallest currents dominates, a few counts in a peak of a few hundred
+    HOST_CHECK(errors.magnitude < 0.005);
+    HOST_CHECK(errors.angle < 0.5);
+  }
+}
+
+/*! @brief Reports the errors when the frequency is off the one the sample rate is locked to.
+ *
+ */
+static void testOffFrequency(void)
+{
+  static const double amps[DSP_NB_PHASES] = {5, 5, 5};
+  static const double angles[DSP_NB_PHASES] = {0, -120, 120};
+  static const double offsets[] = {0.01, 0.05, 0.2, 0.5, 1.0};
+
+  printf("frequency off by (Hz at 50 Hz)  magnitude error  angle error (degrees)\n");
+
+  for (unsigned o = 0; o < sizeof(offsets) / sizeof(offsets[0]); o++)
+  {
+    TErrors errors;
+
+    slide(amps, angles, 1 + offsets[o] / 50, &errors);
+    printf("%30.2f  %14.3f%%  %11.3f\n", offsets[o], errors.magnitude * 100, errors.angle);
+
+    // The tracker holds the rate within a few mHz; the errors grow with the offset, about 1% per Hz
+    if (offsets[o] <= 0.05)
+    {
+      HOST_CHECK(errors.magnitude < 0.005);
+      HOST_CHECK(errors.angle < 0.5);
+    }
+  }
+}
+
+/*! @brief Times the sliding update, and the batch DFT of the window it replaces, for three phases.
+ *
+ */
+static void testCost(void)
+{
+  TDFTBin bins[DSP_NB_PHASES] = {{0, 0}};
+  int16_t windows[DSP_NB_PHASES][ANALOG_WINDOW_SIZE] = {{0}};
+  int32_t cosines[ANALOG_WINDOW_SIZE], sines[ANALOG_WINDOW_SIZE];
+
+  for (uint8_t m = 0; m < ANALOG_WINDOW_SIZE; m++)
+  {
+    cosines[m] = (int32_t)lround(32767 * cos(2 * M_PI * m / ANALOG_WINDOW_SIZE));
+    sines[m] = (int32_t)lround(32767 * sin(2 * M_PI * m / ANALOG_WINDOW_SIZE));
+  }
+
+  uint64_t start = Host_Nanoseconds();
+
+  for (unsigned n = 0; n < NB_TIMED_SAMPLES; n++)
+  {
+    uint8_t position = n % ANALOG_WINDOW_SIZE;
+
+    for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+    {
+      int16_t sample = (int16_t)((n + phase) * 2654435761u >> 16);
+
+      DSP_DFTUpdate(&bins[phase], sample, windows[phase][position], position);
+      windows[phase][position] = sample;
+    }
+  }
+
+  double slidingNs = (double)(Host_Nanoseconds() - start) / NB_TIMED_SAMPLES;
+  Sink = bins[0].re + bins[1].im + bins[2].re;
+  start = Host_Nanoseconds();
+
+  for (unsigned n = 0; n < NB_TIMED_SAMPLES; n++)
+  {
+    uint8_t position = n % ANALOG_WINDOW_SIZE;
+
+    for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+    {
+      windows[phase][position] = (int16_t)((n + phase) * 2654435761u >> 16);
+
+      int32_t re = 0, im = 0;
+      for (uint8_t m = 0; m < ANALOG_WINDOW_SIZE; m++)
+      {
+        re += (windows[phase][m] * cosines[m] + (1 << 14)) >> 15;
+        im -= (windows[phase][m] * sines[m] + (1 << 14)) >> 15;
+      }
+      bins[phase] = (TDFTBin){re, im};
+    }
+  }
+
+  double batchNs = (double)(Host_Nanoseconds() - start) / NB_TIMED_SAMPLES;
+  Sink = bins[0].re + bins[1].im + bins[2].re;
+
+  // Reading the phasors is done per request, not per sample
+  start = Host_Nanoseconds();
+  double total = 0;
+
+  for (unsigned n = 0; n < NB_TIMED_SAMPLES / 10; n++)
+  {
+    bins[n % DSP_NB_PHASES].re += 1;
+    float reference = DSP_DFTAngle(&bins[0]);
+
+    for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+    {
+      double magnitude;
+      total += readPhasor(&bins[phase], reference, &magnitude) + magnitude;
+    }
+  }
+
+  double readNs = (double)(Host_Nanoseconds() - start) / (NB_TIMED_SAMPLES / 10);
+  Sink = (int32_t)total;
+
+  printf("host ns per sample of three phases: sliding %.2f, batch DFT of the window %.2f; per read of three phasors %.2f\n",
+         slidingNs, batchNs, readNs);
+}
+
+int main(void)
+{
+  testAccuracy();
+  testOffFrequency();
+  testCost();
+
+  return Host_Result();
+}
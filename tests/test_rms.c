@@ -0,0 +1,204 @@
+/*! @file test_rms.c
+ *
+ *  @brief Host test of the sliding-window RMS pickup
+ *
+ *  Replays step faults through the sliding sum of squares that processSample in main.c keeps,
+ *  and through the batch method it replaced, which found the RMS in float once every window.
+ *  Reports the pickup latency of each, and checks the sliding sum never drifts from the window.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "dsp.h"
+
+#include <math.h>
+
+// Load current before each fault, below pickup
+#define LOAD_CURRENT 0.5
+
+// Samples of load run before the fault, so both windows are full
+#define LOAD_SAMPLES (4 * ANALOG_WINDOW_SIZE)
+
+// Samples of random signal run through the sliding sum
+#define DRIFT_SAMPLES 10000000
+
+static const double FAULT_CURRENTS[] = {1.1, 1.5, 2.0, 5.0, 10.0};
+#define NB_FAULT_CURRENTS (sizeof(FAULT_CURRENTS) / sizeof(FAULT_CURRENTS[0]))
+
+// Inception angles tried for each fault, evenly spread over a cycle
+#define NB_ANGLES 16
+
+// The sliding window, updated as processSample does
+typedef struct
+{
+  int16_t samples[ANALOG_WINDOW_SIZE];
+  uint64_t sumOfSquares;
+  uint8_t count;
+} TWindow;
+
+// The batch method: a window of float samples in volts, checked when it fills
+typedef struct
+{
+  float samples[ANALOG_WINDOW_SIZE];
+  uint8_t count;
+} TBatch;
+
+static const uint64_t sumOfSquaresThreshold = DSP_SUM_OF_SQUARES(1.03);
+
+/*! @brief Slides a sample into the window.
+ *
+ *  @param window The window.
+ *  @param sample The raw sample.
+ *  @return bool - TRUE if the window is over pickup.
+ */
+static bool slide(TWindow * const window, const int16_t sample)
+{
+  int16_t oldSample = window->samples[window->count];
+  window->sumOfSquares += (uint32_t)(sample * sample);
+  window->sumOfSquares -= (uint32_t)(oldSample * oldSample);
+  window->samples[window->count] = sample;
+  window->count = (window->count + 1) % ANALOG_WINDOW_SIZE;
+
+  return window->sumOfSquares >= sumOfSquaresThreshold;
+}
+
+/*! @brief Adds a sample to the batch window, finding the RMS when it fills.
+ *
+ *  @param batch The batch window.
+ *  @param sample The raw sample.
+ *  @return bool - TRUE if the window has just filled and is over pickup.
+ */
+static bool batch(TBatch * const batch, const int16_t sample)
+{
+  batch->samples[batch->count++] = ((float)sample * 20) / 65536.0f;
+
+  if (batch->count < ANALOG_WINDOW_SIZE)
+    return false;
+
+  batch->count = 0;
+
+  float sumOfVoltages = 0;
+  for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE; i++)
+    sumOfVoltages += batch->samples[i] * batch->samples[i];
+
+  return sqrtf(sumOfVoltages / ANALOG_WINDOW_SIZE) / 0.35f >= 1.03f;
+}
+
+/*! @brief Replays a step from the load current to a fault.
+ *
+ *  @param fault The fault current in amps.
+ *  @param angle The phase at inception in radians.
+ *  @param offset The samples already in the batch window at inception.
+ *  @param slidingLatency Place to return the samples the sliding window took to pick up.
+ *  @param batchLatency Place to return the samples the batch method took to pick up.
+ */
+static void replay(const double fault, const double angle, const uint8_t offset, unsigned *slidingLatency, unsigned *batchLatency)
+{
+  TWindow window = {{0}, 0, 0};
+  TBatch batchWindow = {{0}, 0};
+  double step = 2 * M_PI / ANALOG_WINDOW_SIZE;
+  double start = angle - (LOAD_SAMPLES + offset) * step;
+
+  for (unsigned n = 0; n < LOAD_SAMPLES + offset; n++)
+  {
+    int16_t sample = Host_Sample(LOAD_CURRENT, start + n * step);
+    HOST_CHECK(!slide(&window, sample));
+    HOST_CHECK(!batch(&batchWindow, sample));
+  }
+
+  *slidingLatency = 0;
+  *batchLatency = 0;
+
+  for (unsigned n = 1; n <= 4 * ANALOG_WINDOW_SIZE && !*batchLatency; n++)
+  {
+    int16_t sample = Host_Sample(fault, angle + (n - 1) * step);
+
+    if (slide(&window, sample) && !*slidingLatency)
+      *slidingLatency = n;
+    if (batch(&batchWindow, sample))
+      *batchLatency = n;
+  }
+}
+
+/*! @brief Replays step faults and compares the pickup latencies.
+ *
+ */
+static void testLatency(void)
+{
+  printf("fault A  sliding mean/max  batch mean/max (samples from inception to pickup)\n");
+
+  for (unsigned f = 0; f < NB_FAULT_CURRENTS; f++)
+  {
+    unsigned slidingTotal = 0, slidingMax = 0, batchTotal = 0, batchMax = 0, nbCases = 0;
+
+    for (unsigned a = 0; a < NB_ANGLES; a++)
+    {
+      for (uint8_t offset = 0; offset < ANALOG_WINDOW_SIZE; offset++)
+      {
+        unsigned slidingLatency, batchLatency;
+
+        replay(FAULT_CURRENTS[f], 2 * M_PI * a / NB_ANGLES, offset, &slidingLatency, &batchLatency);
+
+        // Both see the same window when the batch fills, so the sliding check can't be later
+        HOST_CHECK(slidingLatency != 0 && batchLatency != 0);
+        HOST_CHECK(slidingLatency <= batchLatency);
+        HOST_CHECK(slidingLatency <= ANALOG_WINDOW_SIZE);
+
+        slidingTotal += slidingLatency;
+        batchTotal += batchLatency;
+        if (slidingLatency > slidingMax)
+          slidingMax = slidingLatency;
+        if (batchLatency > batchMax)
+          batchMax = batchLatency;
+        nbCases++;
+      }
+    }
+
+    printf("%7.1f  %8.2f / %-4u   %6.2f / %-4u\n", FAULT_CURRENTS[f],
+           (double)slidingTotal / nbCases, slidingMax, (double)batchTotal / nbCases, batchMax);
+  }
+}
+
+/*! @brief Runs random samples through the sliding sum and compares it with the window each time.
+ *
+ */
+static void testDrift(void)
+{
+  TWindow window = {{0}, 0, 0};
+  uint32_t seed = 1;
+  unsigned mismatches = 0;
+  double worstError = 0;
+
+  for (unsigned n = 0; n < DRIFT_SAMPLES; n++)
+  {
+    seed = seed * 1664525 + 1013904223;
+    slide(&window, (int16_t)(seed >> 16));
+
+    uint64_t sumOfSquares = 0;
+    for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE; i++)
+      sumOfSquares += (uint64_t)((int32_t)window.samples[i] * window.samples[i]);
+
+    if (window.sumOfSquares != sumOfSquares)
+      mismatches++;
+
+    // The fixed-point RMS against the exact RMS of the window
+    double exact = sqrt((double)sumOfSquares / ANALOG_WINDOW_SIZE) / DSP_SAMPLE_PER_AMP;
+    double error = fabs(DSP_RMSCurrent(window.sumOfSquares) / (double)DSP_CURRENT_ONE - exact);
+    if (error > worstError)
+      worstError = error;
+  }
+
+  printf("drift: %u mismatches in %u samples, worst RMS error %.3f mA\n", mismatches, DRIFT_SAMPLES, worstError * 1000);
+  HOST_CHECK(mismatches == 0);
+  HOST_CHECK(worstError < 1.0 / DSP_CURRENT_ONE * 2);
+}
+
+int main(void)
+{
+  testLatency();
+  testDrift();
+
+  return Host_Result();
+}
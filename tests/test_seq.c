@@ -0,0 +1,207 @@
+/*! @file test_seq.c
+ *
+ *  @brief Host test and benchmark of the symmetrical components
+ *
+ *  Slides balanced, unbalanced and fault sets through a fundamental DFT bin per phase, as
+ *  processSample does, resolves them with Seq_Calculate, and checks each sequence current against
+ *  the components worked out in double precision. The pickup of the negative sequence (46) and
+ *  residual earth-fault elements is checked as checkElement in main.c decides it. Also times a
+ *  Seq_Calculate call, which runs once a cycle, against the same calculation with trigonometric
+ *  rotations.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "seq.h"
+
+#include <complex.h>
+#include <math.h>
+
+// Calls timed for each method
+#define NB_TIMED_CALLS 20000000
+
+// Pickup settings in 0.1 A, and the multiple of the setting an element picks up at
+#define NEGATIVE_SEQUENCE_PICKUP 10
+#define EARTH_FAULT_PICKUP 10
+#define PICKUP_MULTIPLE 1.03
+
+static volatile uint32_t Sink;
+
+// Read on every call, so the rotations can't be worked out at compile time
+static volatile float Rotation = 2 * (float)M_PI / 3;
+
+/*! @brief A three-phase set and the elements it should pick up
+ *
+ */
+typedef struct
+{
+  const char *name;
+  double amps[DSP_NB_PHASES];   /*!< RMS current of each phase in amps */
+  double angles[DSP_NB_PHASES]; /*!< Angle of each phase in degrees */
+  bool negativeSequence;        /*!< TRUE if the 46 element picks up */
+  bool earthFault;              /*!< TRUE if the residual earth-fault element picks up */
+} TCase;
+
+/*! @brief Slides a set through the phase bins, as processSample does.
+ *
+ *  @param set The set.
+ *  @param bins An array to place the fundamental bin of each phase in.
+ */
+static void slide(const TCase * const set, TDFTBin bins[DSP_NB_PHASES])
+{
+  int16_t windows[DSP_NB_PHASES][ANALOG_WINDOW_SIZE] = {{0}};
+
+  for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+    bins[phase] = (TDFTBin){0, 0};
+
+  for (unsigned n = 0; n < 2 * ANALOG_WINDOW_SIZE; n++)
+  {
+    uint8_t position = n % ANALOG_WINDOW_SIZE;
+
+    for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+    {
+      int16_t sample = Host_Sample(set->amps[phase], set->angles[phase] * M_PI / 180 + 2 * M_PI * n / ANALOG_WINDOW_SIZE);
+
+      DSP_DFTUpdate(&bins[phase], sample, windows[phase][position], position);
+      windows[phase][position] = sample;
+    }
+  }
+}
+
+/*! @brief Decides whether an element picks up, as checkElement does.
+ *
+ *  @param current The element's current in Q16.16 amps.
+ *  @param pickup The setting in 0.1 A.
+ *  @return bool - TRUE if the element picks up.
+ */
+static bool picksUp(const uint32_t current, const uint8_t pickup)
+{
+  return ((uint64_t)current * 10) / pickup >= DSP_CURRENT(PICKUP_MULTIPLE);
+}
+
+/*! @brief Checks the components of each set against double precision, and the elements they pick up.
+ *
+ */
+static void testComponents(void)
+{
+  static const TCase cases[] =
+  {
+    {"balanced load",         {10, 10, 10},      {0, -120, 120},    false, false},
+    {"balanced, 15 A",        {15, 15, 15},      {0, -120, 120},    false, false},
+    {"reversed rotation",     {5, 5, 5},         {0, 120, -120},    true,  false},
+    {"A to earth, 3 A",       {3, 0, 0},         {0, 0, 0},         false, true},
+    {"A to earth on load",    {8, 5, 5},         {-30, -120, 120},  true,  true},
+    {"B to C, 6 A",           {0, 6, 6},         {0, -90, 90},      true,  false},
+    {"B and C to earth",      {1, 7, 7},         {0, -150, 150},    false, true},
+    {"unbalanced load",       {10, 9.5, 10.5},   {0, -118, 121},    false, false},
+    {"open phase C on load",  {5, 5, 0},         {0, -120, 0},      true,  true},
+  };
+
+  printf("case                   I0 / I1 / I2 (A)         worst error (mA)  46  EF\n");
+
+  for (unsigned c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+  {
+    const TCase *set = &cases[c];
+    TDFTBin bins[DSP_NB_PHASES];
+    TSequence sequence;
+
+    slide(set, bins);
+    Seq_Calculate(bins, &sequence);
+
+    // The components in double precision
+    double complex a = cexp(I * 2 * M_PI / 3), phases[DSP_NB_PHASES];
+    for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+      phases[phase] = set->amps[phase] * cexp(I * set->angles[phase] * M_PI / 180);
+
+    double expected[3] =
+    {
+      cabs(phases[0] + phases[1] + phases[2]) / 3,
+      cabs(phases[0] + a * phases[1] + a * a * phases[2]) / 3,
+      cabs(phases[0] + a * a * phases[1] + a * phases[2]) / 3,
+    };
+    double measured[3] =
+    {
+      (double)sequence.zeroCurrent / DSP_CURRENT_ONE,
+      (double)sequence.positiveCurrent / DSP_CURRENT_ONE,
+      (double)sequence.negativeCurrent / DSP_CURRENT_ONE,
+    };
+
+    double worst = 0;
+    for (uint8_t component = 0; component < 3; component++)
+      worst = fmax(worst, fabs(measured[component] - expected[component]));
+
+    bool negativeSequence = picksUp(sequence.negativeCurrent, NEGATIVE_SEQUENCE_PICKUP);
+    bool earthFault = picksUp(3 * sequence.zeroCurrent, EARTH_FAULT_PICKUP);
+
+    printf("%-21s  %6.3f / %6.3f / %6.3f  %16.2f  %2s  %2s\n", set->name, measured[0], measured[1], measured[2], worst * 1000,
+           negativeSequence ? "up" : "-", earthFault ? "up" : "-");
+
+    // A few counts of quantisation in each phase, spread over the components
+    HOST_CHECK(worst < 0.01);
+    HOST_CHECK(negativeSequence == set->negativeSequence);
+    HOST_CHECK(earthFault == set->earthFault);
+  }
+}
+
+/*! @brief Resolves the phases with trigonometric rotations, as the fixed constants replace.
+ *
+ *  @param phases The fundamental DFT bin of each phase.
+ *  @param sequence A pointer to place the components.
+ */
+static void trigCalculate(const TDFTBin phases[DSP_NB_PHASES], TSequence * const sequence)
+{
+  float c = cosf(Rotation), s = sinf(Rotation);
+  float bRe = phases[1].re, bIm = phases[1].im, cRe = phases[2].re, cIm = phases[2].im;
+
+  sequence->zero.re = (phases[0].re + phases[1].re + phases[2].re) / 3;
+  sequence->zero.im = (phases[0].im + phases[1].im + phases[2].im) / 3;
+  sequence->positive.re = (int32_t)((phases[0].re + (c * bRe - s * bIm) + (c * cRe + s * cIm)) / 3);
+  sequence->positive.im = (int32_t)((phases[0].im + (s * bRe + c * bIm) + (c * cIm - s * cRe)) / 3);
+  sequence->negative.re = (int32_t)((phases[0].re + (c * bRe + s * bIm) + (c * cRe - s * cIm)) / 3);
+  sequence->negative.im = (int32_t)((phases[0].im + (c * bIm - s * bRe) + (s * cRe + c * cIm)) / 3);
+
+  sequence->zeroCurrent = DSP_RMSCurrent(DSP_DFTSumOfSquares(&sequence->zero));
+  sequence->positiveCurrent = DSP_RMSCurrent(DSP_DFTSumOfSquares(&sequence->positive));
+  sequence->negativeCurrent = DSP_RMSCurrent(DSP_DFTSumOfSquares(&sequence->negative));
+}
+
+/*! @brief Times a call of each method.
+ *
+ */
+static void testCost(void)
+{
+  TDFTBin bins[DSP_NB_PHASES] = {{20000, 0}, {-10000, -17320}, {-10000, 17320}};
+  TSequence sequence;
+  uint64_t start = Host_Nanoseconds();
+
+  for (unsigned n = 0; n < NB_TIMED_CALLS; n++)
+  {
+    bins[n % DSP_NB_PHASES].re ^= 1;
+    Seq_Calculate(bins, &sequence);
+    Sink = sequence.negativeCurrent;
+  }
+
+  double fixedNs = (double)(Host_Nanoseconds() - start) / NB_TIMED_CALLS;
+  start = Host_Nanoseconds();
+
+  for (unsigned n = 0; n < NB_TIMED_CALLS; n++)
+  {
+    bins[n % DSP_NB_PHASES].re ^= 1;
+    trigCalculate(bins, &sequence);
+    Sink = sequence.negativeCurrent;
+  }
+
+  double trigNs = (double)(Host_Nanoseconds() - start) / NB_TIMED_CALLS;
+
+  printf("host ns per cycle: fixed rotations %.2f, trigonometric rotations %.2f\n", fixedNs, trigNs);
+}
+
+int main(void)
+{
+  testComponents();
+  testCost();
+
+  return Host_Result();
+}
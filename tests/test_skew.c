@@ -0,0 +1,156 @@
+/*! @file test_skew.c
+ *
+ *  @brief Host test of the alignment of phases B and C and the neutral to phase A's sampling instant
+ *
+ *  Samples a balanced three-phase set with phases B and C read a known, varying time after phase A,
+ *  as the back to back reads in Acq_Sample are, and the neutral, carrying phase A's current, read
+ *  last. Every sample is passed through Acq_Align. The angles of the fundamental DFT bins of the
+ *  aligned phases must be 120 degrees apart, and the neutral in phase with phase A, where those of
+ *  the unaligned inputs are out by the skew.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "acq.h"
+#include "dsp.h"
+#include "Cpu.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// Samples run through each case, the last window of which is measured
+#define NB_SAMPLES (8 * ANALOG_WINDOW_SIZE)
+
+// Core clock cycles between samples at 50 Hz
+#define SAMPLE_PERIOD (CPU_CORE_CLK_HZ / (50.0 * ANALOG_WINDOW_SIZE))
+
+// Fault current in amps
+#define CURRENT 10.0
+
+// Acq_Sample is not run here, so the hardware it reads is never called
+bool Analog_Get(const uint8_t channelNb, int16_t * const valuePtr)
+{
+  return false;
+}
+
+uint32_t Profile_Cycles(void)
+{
+  return 0;
+}
+
+void Calib_Capture(const int16_t samples[ANALOG_NB_INPUTS])
+{
+}
+
+int16_t Calib_Correct(const uint8_t inputNb, const int16_t sample)
+{
+  return sample;
+}
+
+/*! @brief Gets the difference between two angles.
+ *
+ *  @param a The first angle in degrees.
+ *  @param b The second angle in degrees.
+ *  @return double - a - b, from -180 to 180 degrees.
+ */
+static double difference(const double a, const double b)
+{
+  return remainder(a - b, 360);
+}
+
+/*! @brief Samples the inputs with skew, and measures the angles of the later inputs from phase A.
+ *
+ *  @param skewB Phase B's mean delay behind phase A as a fraction of the sample period.
+ *  @param skewC Phase C's mean delay behind phase A as a fraction of the sample period.
+ *  @param jitter The most each delay varies either side of its mean, as a fraction of the sample period.
+ *  @param align TRUE to pass the samples through Acq_Align.
+ *  @param worst Place to return the worst error of the three angles in degrees.
+ */
+static void run(const double skewB, const double skewC, const double jitter, const bool align, double * const worst)
+{
+  const double skews[ACQ_NB_INPUTS] = {0, skewB, skewC};
+  int16_t history[ACQ_NB_INPUTS][ANALOG_WINDOW_SIZE] = {{0}};
+  TDFTBin bins[ACQ_NB_INPUTS] = {{0, 0}};
+
+  Acq_Init();
+  srand(1);
+
+  for (unsigned n = 0; n < NB_SAMPLES; n++)
+  {
+    int16_t samples[ACQ_NB_INPUTS];
+    uint32_t stamps[ACQ_NB_INPUTS];
+    double delay = 0;
+
+    for (uint8_t inputNb = 0; inputNb < ACQ_NB_INPUTS; inputNb++)
+    {
+      // Each read follows the last, so the later inputs never come before phase A
+      if (inputNb > 0)
+        delay = fmax(delay, skews[inputNb] + jitter * (2.0 * rand() / RAND_MAX - 1));
+
+      double time = n + delay;
+      stamps[inputNb] = (uint32_t)llround(time * SAMPLE_PERIOD);
+      samples[inputNb] = Host_Sample(CURRENT, 2 * M_PI * (time / ANALOG_WINDOW_SIZE - inputNb / 3.0));
+    }
+
+    if (align)
+      Acq_Align(samples, stamps);
+
+    uint8_t position = n % ANALOG_WINDOW_SIZE;
+    for (uint8_t inputNb = 0; inputNb < ACQ_NB_INPUTS; inputNb++)
+    {
+      DSP_DFTUpdate(&bins[inputNb], samples[inputNb], history[inputNb][position], position);
+      history[inputNb][position] = samples[inputNb];
+    }
+  }
+
+  double a = DSP_DFTAngle(&bins[0]);
+  double errorB = difference(DSP_DFTAngle(&bins[1]) - a, -120);
+  double errorC = difference(DSP_DFTAngle(&bins[2]) - a, 120);
+  double errorN = difference(DSP_DFTAngle(&bins[ACQ_NEUTRAL_INPUT]) - a, 0);
+
+  *worst = fmax(fmax(fabs(errorB), fabs(errorC)), fabs(errorN));
+}
+
+int main(void)
+{
+  // Delays of phases B and C behind phase A, as fractions of the sample period
+  static const double cases[][3] =
+  {
+    {0.05, 0.10, 0},
+    {0.20, 0.40, 0},
+    {0.30, 0.60, 0},
+    {0.05, 0.10, 0.04},
+    {0.20, 0.40, 0.10},
+    {0.30, 0.60, 0.20},
+  };
+
+  printf("skew B / C (samples)  jitter  angle error unaligned / aligned (degrees)\n");
+
+  for (unsigned c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+  {
+    double unaligned, aligned;
+
+    run(cases[c][0], cases[c][1], cases[c][2], false, &unaligned);
+    run(cases[c][0], cases[c][1], cases[c][2], true, &aligned);
+
+    printf("%9.2f / %.2f  %11.2f  %15.3f / %.3f\n", cases[c][0], cases[c][1], cases[c][2], unaligned, aligned);
+
+    // Each sample of skew is 22.5 degrees, and the straight line between samples leaves well under a degree
+    HOST_CHECK(aligned < 0.5);
+    HOST_CHECK(aligned < unaligned / 4);
+  }
+
+  // The skew reported is the delay of the last sample
+  int16_t samples[ACQ_NB_INPUTS] = {0};
+  const uint32_t stamps[ACQ_NB_INPUTS] = {1000, 1250, 1600, 1900};
+
+  Acq_Init();
+  Acq_Align(samples, stamps);
+  HOST_CHECK(Acq_Skew(1) == 250);
+  HOST_CHECK(Acq_Skew(2) == 600);
+  HOST_CHECK(Acq_Skew(ACQ_NEUTRAL_INPUT) == 900);
+
+  return Host_Result();
+}
@@ -0,0 +1,110 @@
+/*! @file test_sumsq.c
+ *
+ *  @brief Host test of the packed sum-of-squares kernel
+ *
+ *  The host builds the portable C fallback of DSP_SumOfSquares. This checks it bit for bit against
+ *  a model of the SMLALD path, which walks each window as packed words and adds the product of
+ *  each half with itself to a 64-bit accumulator, as the Cortex-M4 instruction does.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "dsp.h"
+
+#include <string.h>
+
+// Random blocks compared
+#define NB_RANDOM_BLOCKS 1000000
+
+/*! @brief Models SMLALD with both operands the same word.
+ *
+ *  @param pair Two packed 16-bit samples.
+ *  @param accumulator The running sum.
+ *  @return int64_t - The accumulator plus the squares of both halves, wrapping in 64 bits.
+ */
+static int64_t smlald(const uint32_t pair, const int64_t accumulator)
+{
+  int32_t lo = (int16_t)(pair & 0xFFFF);
+  int32_t hi = (int16_t)(pair >> 16);
+
+  return (int64_t)((uint64_t)accumulator + (uint64_t)(int64_t)(lo * lo) + (uint64_t)(int64_t)(hi * hi));
+}
+
+/*! @brief Finds the sums of squares as the SMLALD path does.
+ *
+ *  @param block The packed sample windows.
+ *  @param sums An array to place the sum of squares of each phase.
+ */
+static void modelSumOfSquares(const TSampleBlock * const block, uint64_t sums[DSP_NB_PHASES])
+{
+  for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+  {
+    uint32_t pairs[ANALOG_WINDOW_SIZE / 2];
+    int64_t sum = 0;
+
+    memcpy(pairs, block->phase[phase], sizeof(pairs));
+
+    for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE / 2; i++)
+      sum = smlald(pairs[i], sum);
+
+    sums[phase] = (uint64_t)sum;
+  }
+}
+
+/*! @brief Compares the kernel with the model on one block.
+ *
+ *  @param block The packed sample windows.
+ *  @return bool - TRUE if every sum matched.
+ */
+static bool compare(const TSampleBlock * const block)
+{
+  uint64_t sums[DSP_NB_PHASES], expected[DSP_NB_PHASES];
+
+  DSP_SumOfSquares(block, sums);
+  modelSumOfSquares(block, expected);
+
+  return memcmp(sums, expected, sizeof(sums)) == 0;
+}
+
+int main(void)
+{
+  TSampleBlock block;
+
+  // The extremes: a full window at the most negative sample has the largest sum, 2^34
+  for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+  {
+    for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE; i++)
+      block.phase[phase][i] = (phase == 0) ? INT16_MIN : (phase == 1) ? INT16_MAX : (int16_t)((i & 1) ? INT16_MIN : INT16_MAX);
+  }
+
+  uint64_t sums[DSP_NB_PHASES];
+  DSP_SumOfSquares(&block, sums);
+  HOST_CHECK(sums[0] == ANALOG_WINDOW_SIZE * (1ULL << 30));
+  HOST_CHECK(compare(&block));
+
+  // Random windows, mismatches counted rather than checked one by one
+  uint32_t seed = 12345;
+  unsigned mismatches = 0;
+
+  for (unsigned n = 0; n < NB_RANDOM_BLOCKS; n++)
+  {
+    for (uint8_t phase = 0; phase < DSP_NB_PHASES; phase++)
+    {
+      for (uint8_t i = 0; i < ANALOG_WINDOW_SIZE; i++)
+      {
+        seed = seed * 1664525 + 1013904223;
+        block.phase[phase][i] = (int16_t)(seed >> 16);
+      }
+    }
+
+    if (!compare(&block))
+      mismatches++;
+  }
+
+  printf("%u mismatches in %u random blocks\n", mismatches, NB_RANDOM_BLOCKS);
+  HOST_CHECK(mismatches == 0);
+
+  return Host_Result();
+}
@@ -0,0 +1,322 @@
+/*! @file test_trip.c
+ *
+ *  @brief Host test of IDMT trip timing through the deadline scheduler
+ *
+ *  Runs trip timers the way handleTrip and serviceTrips in main.c do, with the IDMT tables and the
+ *  deadline scheduler on a simulated PIT, and checks the trip times across each IDMT curve.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "deadline.h"
+#include "idmt.h"
+#include "dsp.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// Timer channel the scheduler wakes on
+#define DEADLINE_PIT_CHANNEL 1
+
+// Processed sample period in microseconds at 50 Hz
+#define SAMPLE_PERIOD 1250
+
+// Time of the first sample of each run, away from zero
+#define START_TIME 1000000
+
+// Multiples of the setting tried on each curve, evenly spaced in log from 1.05 to 60
+#define NB_CURRENTS 40
+
+static const uint64_t TRIP_INTEGRAL_UNITY = 1000000ULL << IDMT_RATE_Q;
+
+static const double k[3] = {0.14, 13.5, 80};
+static const double a[3] = {0.02, 1, 2};
+static const char *NAMES[3] = {"Inverse", "VeryInverse", "ExtremelyInverse"};
+
+/*! @brief A channel's trip timer, as main.c keeps it
+ *
+ */
+typedef struct
+{
+  uint8_t channelNb;
+  bool active;
+  bool tripped;
+  uint64_t integral;
+  uint64_t tripAt; /*!< Time the channel tripped */
+} TTimer;
+
+/*! @brief Runs a trip timer on one sample, as handleTrip does.
+ *
+ *  @param timer The trip timer.
+ *  @param characteristic The IDMT characteristic.
+ *  @param current The current in Q16.16 multiples of the setting.
+ *  @param time The time of the sample in microseconds.
+ *  @param period The time since the previous sample in microseconds.
+ */
+static void evaluate(TTimer * const timer, const RELAY_CHARACTERISTIC characteristic, const uint32_t current, const uint64_t time,
+                     const uint32_t period)
+{
+  if (timer->tripped)
+    return;
+
+  uint32_t rate = IDMT_TripRate(characteristic, current);
+  uint64_t increment = (uint64_t)rate * period;
+
+  if (!timer->active)
+  {
+    timer->integral = 0;
+    timer->active = true;
+  }
+
+  timer->integral += increment;
+
+  if (timer->integral >= TRIP_INTEGRAL_UNITY)
+  {
+    timer->tripped = true;
+    timer->active = false;
+    timer->tripAt = time;
+    Deadline_Cancel(timer->channelNb);
+  }
+  else if (timer->integral + increment >= TRIP_INTEGRAL_UNITY)
+    Deadline_Set(timer->channelNb, time + (TRIP_INTEGRAL_UNITY - timer->integral) / rate);
+}
+
+/*! @brief Stops a trip timer once the current drops below pickup, as deactivateTimer does.
+ *
+ *  @param timer The trip timer.
+ */
+static void reset(TTimer * const timer)
+{
+  if (timer->active)
+  {
+    timer->active = false;
+    timer->integral = 0;
+    Deadline_Cancel(timer->channelNb);
+  }
+}
+
+/*! @brief Fires the one-shot if it is due by a time, tripping the expired channels as serviceTrips does.
+ *
+ *  @param timers The trip timers, indexed by channel.
+ *  @param nbTimers The number of timers.
+ *  @param time The time to run up to.
+ */
+static void runUntil(TTimer timers[], const uint8_t nbTimers, const uint64_t time)
+{
+  uint64_t due;
+
+  while (Host_OneShotArmed(DEADLINE_PIT_CHANNEL, &due) && due <= time)
+  {
+    Host_Time = due;
+    HOST_CHECK(Host_OneShotFire(DEADLINE_PIT_CHANNEL));
+
+    uint8_t expired = Deadline_Expired();
+
+    for (uint8_t timerNb = 0; timerNb < nbTimers; timerNb++)
+    {
+      if ((expired & (1 << timers[timerNb].channelNb)) && timers[timerNb].active)
+      {
+        timers[timerNb].tripped = true;
+        timers[timerNb].active = false;
+        timers[timerNb].tripAt = Host_Time;
+      }
+    }
+  }
+
+  Host_Time = time;
+}
+
+/*! @brief Finds the trip time of the IDMT formula.
+ *
+ *  @param characteristic The IDMT characteristic.
+ *  @param multiple The current in multiples of the setting.
+ *  @return double - The trip time in microseconds.
+ */
+static double formula(const RELAY_CHARACTERISTIC characteristic, const double multiple)
+{
+  return k[characteristic] / (pow(multiple, a[characteristic]) - 1) * 1e6;
+}
+
+/*! @brief Times a constant fault on one channel across each curve.
+ *
+ *  The fault starts one sample period before the pickup sample, whose evaluation covers that period.
+ */
+static void testConstantFaults(void)
+{
+  printf("curve             scheduler error (us)  error against formula  one-shots per trip\n");
+
+  for (RELAY_CHARACTERISTIC characteristic = Inverse; characteristic <= ExtremelyInverse; characteristic++)
+  {
+    double worstError = 0, worstRelative = 0;
+    uint32_t worstStarts = 0;
+
+    for (unsigned c = 0; c < NB_CURRENTS; c++)
+    {
+      double multiple = 1.05 * pow(60 / 1.05, (double)c / (NB_CURRENTS - 1));
+      uint32_t current = DSP_CURRENT(multiple);
+      TTimer timer = {.channelNb = 0};
+
+      Deadline_Init();
+      uint32_t starts = Host_OneShotStarts(DEADLINE_PIT_CHANNEL);
+
+      for (uint64_t time = START_TIME; !timer.tripped; time += SAMPLE_PERIOD)
+      {
+        runUntil(&timer, 1, time);
+        if (!timer.tripped)
+          evaluate(&timer, characteristic, current, time, SAMPLE_PERIOD);
+      }
+
+      // The scheduler against the trip time of the interpolated rate, and the whole against the formula
+      double tripTime = (double)(timer.tripAt - (START_TIME - SAMPLE_PERIOD));
+      double tableTime = 1e6 * IDMT_RATE_ONE / IDMT_TripRate(characteristic, current);
+      double expected = formula(characteristic, (double)current / DSP_CURRENT_ONE);
+
+      if (fabs(tripTime - tableTime) > worstError)
+        worstError = fabs(tripTime - tableTime);
+      if (fabs(tripTime - expected) / expected > worstRelative)
+        worstRelative = fabs(tripTime - expected) / expected;
+
+      starts = Host_OneShotStarts(DEADLINE_PIT_CHANNEL) - starts;
+      if (starts > worstStarts)
+        worstStarts = starts;
+
+      // Nothing left to wait for, so no more wakeups
+      HOST_CHECK(!Host_OneShotArmed(DEADLINE_PIT_CHANNEL, NULL));
+    }
+
+    printf("%-16s  %20.1f  %20.4f%%  %18u\n", NAMES[characteristic], worstError, worstRelative * 100, worstStarts);
+    HOST_CHECK(worstError <= 2);
+    HOST_CHECK(worstRelative < 0.005); // The table's interpolation error, well inside the 2% of accuracy class 2
+    HOST_CHECK(worstStarts == 1);
+  }
+}
+
+/*! @brief Times faults on three channels at once, so the scheduler has to pick the earliest each time.
+ *
+ */
+static void testConcurrentFaults(void)
+{
+  static const double multiples[3] = {20, 4, 8};
+  TTimer timers[3];
+
+  Deadline_Init();
+
+  for (uint8_t timerNb = 0; timerNb < 3; timerNb++)
+    timers[timerNb] = (TTimer){.channelNb = timerNb};
+
+  for (uint64_t time = START_TIME; !(timers[0].tripped && timers[1].tripped && timers[2].tripped); time += SAMPLE_PERIOD)
+  {
+    runUntil(timers, 3, time);
+    for (uint8_t timerNb = 0; timerNb < 3; timerNb++)
+      evaluate(&timers[timerNb], VeryInverse, DSP_CURRENT(multiples[timerNb]), time, SAMPLE_PERIOD);
+  }
+
+  for (uint8_t timerNb = 0; timerNb < 3; timerNb++)
+  {
+    double tripTime = (double)(timers[timerNb].tripAt - (START_TIME - SAMPLE_PERIOD));
+    double expected = formula(VeryInverse, (double)DSP_CURRENT(multiples[timerNb]) / DSP_CURRENT_ONE);
+
+    printf("channel %u at %.0fx: tripped after %.1f us, formula %.1f us\n", timerNb, multiples[timerNb], tripTime, expected);
+    HOST_CHECK(fabs(tripTime - expected) / expected < 0.005);
+  }
+}
+
+/*! @brief Times faults whose current changes before they trip.
+ *
+ *  The timer integrates 1/t(I), so it trips when the integral of the formula's rate over the
+ *  fault reaches one. A dropout below pickup resets it.
+ */
+static void testVaryingFaults(void)
+{
+  // Multiples at the start and end of each fault, and whether it ramps rather than steps half way
+  static const struct
+  {
+    double from, to;
+    bool ramp;
+  } faults[] = {{2, 10, false}, {10, 2, false}, {1.5, 20, true}, {20, 1.5, true}, {1.2, 3, false}};
+
+  printf("varying fault (VeryInverse, ExtremelyInverse)  error against the integrated formula\n");
+
+  for (unsigned f = 0; f < sizeof(faults) / sizeof(faults[0]); f++)
+  {
+    for (RELAY_CHARACTERISTIC characteristic = VeryInverse; characteristic <= ExtremelyInverse; characteristic++)
+    {
+      // The change is spread over the time the starting current alone would take to trip
+      double span = formula(characteristic, faults[f].from);
+      // After the change the integral grows at least as fast as at the final current, with margin for the tables
+      size_t nbSamples = (size_t)(1.01 * (span + formula(characteristic, faults[f].to)) / SAMPLE_PERIOD) + 16;
+      uint32_t *currents = malloc(nbSamples * sizeof(uint32_t));
+      double integral = 0, expected = 0;
+
+      // The current at each sample, and where the formula's integral over them reaches one
+      for (unsigned n = 0; n < nbSamples; n++)
+      {
+        double elapsed = (double)n * SAMPLE_PERIOD;
+        double multiple = faults[f].ramp ? faults[f].from + (faults[f].to - faults[f].from) * fmin(elapsed / span, 1)
+                                         : (elapsed < span / 2 ? faults[f].from : faults[f].to);
+
+        currents[n] = DSP_CURRENT(multiple);
+
+        double rate = 1 / formula(characteristic, (double)currents[n] / DSP_CURRENT_ONE);
+        if (expected == 0 && integral + rate * SAMPLE_PERIOD >= 1)
+          expected = elapsed + (1 - integral) / rate;
+        integral += rate * SAMPLE_PERIOD;
+      }
+
+      TTimer timer = {.channelNb = 0};
+      Deadline_Init();
+
+      for (unsigned n = 0; !timer.tripped && n < nbSamples; n++)
+      {
+        uint64_t time = START_TIME + (uint64_t)n * SAMPLE_PERIOD;
+
+        runUntil(&timer, 1, time);
+        if (!timer.tripped)
+          evaluate(&timer, characteristic, currents[n], time, SAMPLE_PERIOD);
+      }
+
+      free(currents);
+
+      double tripTime = (double)(timer.tripAt - (START_TIME - SAMPLE_PERIOD));
+      double error = fabs(tripTime - expected) / expected;
+
+      HOST_CHECK(timer.tripped);
+
+      printf("  %4.1fx to %4.1fx %-5s %-16s %.4f%%\n", faults[f].from, faults[f].to, faults[f].ramp ? "ramp" : "step",
+             NAMES[characteristic], error * 100);
+      HOST_CHECK(error < 0.005);
+    }
+  }
+
+  // A fault that drops out half way starts timing again from zero when it returns
+  TTimer timer = {.channelNb = 0};
+  double full = formula(VeryInverse, (double)DSP_CURRENT(5) / DSP_CURRENT_ONE);
+  uint64_t dropout = START_TIME + (uint64_t)(full / 2);
+  uint64_t restart = dropout + 100 * SAMPLE_PERIOD;
+
+  Deadline_Init();
+
+  for (uint64_t time = START_TIME; !timer.tripped; time += SAMPLE_PERIOD)
+  {
+    runUntil(&timer, 1, time);
+    if (time >= dropout && time < restart)
+      reset(&timer);
+    else if (!timer.tripped)
+      evaluate(&timer, VeryInverse, DSP_CURRENT(5), time, SAMPLE_PERIOD);
+  }
+
+  double tripTime = (double)(timer.tripAt - (restart - SAMPLE_PERIOD));
+  printf("dropout half way at 5x: tripped %.1f us after the fault returned, formula %.1f us\n", tripTime, full);
+  HOST_CHECK(fabs(tripTime - full) / full < 0.005);
+}
+
+int main(void)
+{
+  testConstantFaults();
+  testConcurrentFaults();
+  testVaryingFaults();
+
+  return Host_Result();
+}
@@ -0,0 +1,399 @@
+/*! @file test_txq.c
+ *
+ *  @brief Host test of the transmit queue with a stand-in eDMA engine
+ *
+ *  A thread plays the eDMA: it copies each span it is started on to a wire buffer, takes a
+ *  microsecond a byte to send it, and calls TxQ_Done with the interrupt lock held, as the channel's
+ *  completion interrupt does. Single packets, response bursts and a burst many times the size of
+ *  the queue are sent through it, and the wire is checked against what was put, with the
+ *  completions counted against the interrupt a byte the FIFO path took. Trip events are pushed
+ *  with TxQ_PutUrgent while a long download is going out, and checked to arrive whole, on a frame
+ *  boundary and within a span, with the download intact around them. Then the queue is driven
+ *  through UART.c on the stand-in registers, to check UART_DMAErrorISR resumes a failed span from
+ *  the byte that failed, and drops it after DMA_MAX_RETRIES so the queue moves on.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "txq.h"
+#include "UART.h"
+#include "packet.h"
+#include "MK70F12.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+// Packets in each response burst, as CMD_SendDORCurrentPacket sends one per phase
+#define BURST_NB_PACKETS 3
+
+// Bursts sent back to back
+#define NB_BURSTS 20
+
+// Packets in a download many times the size of the queue
+#define NB_DOWNLOAD_PACKETS 4000
+
+// Trip events pushed during a download, each the four packets CMD_SendDORTripPacket sends
+#define NB_EVENTS 10
+#define EVENT_NB_BYTES (4 * PACKET_NB_BYTES)
+
+// Largest number of bytes put on the wire in the test
+#define WIRE_SIZE 100000
+
+static const uint8_t * volatile SpanData; /*!< First byte of the span the engine is sending */
+static volatile uint16_t SpanBytes;       /*!< Bytes in the span the engine is sending */
+static volatile bool Busy;                /*!< TRUE while the engine is sending a span */
+static volatile bool Stop;                /*!< TRUE to stop the engine thread */
+static uint32_t Overlaps;                 /*!< Spans started while the engine was busy */
+
+static uint8_t Wire[WIRE_SIZE];
+static volatile uint32_t WireBytes;
+static uint8_t Expected[WIRE_SIZE];
+static uint32_t ExpectedBytes;
+
+uint32_t Profile_Cycles(void)
+{
+  return (uint32_t)Host_Nanoseconds();
+}
+
+/*! @brief Starts the stand-in engine on a span, as startDMA does the channel.
+ *
+ *  @param data The first byte of the span.
+ *  @param nbBytes The number of bytes in the span.
+ */
+static void start(const uint8_t *data, uint16_t nbBytes)
+{
+  Overlaps += Busy;
+  SpanData = data;
+  SpanBytes = nbBytes;
+  __atomic_store_n(&Busy, true, __ATOMIC_RELEASE);
+}
+
+/*! @brief Sends each span it is started on, then completes it as the interrupt would.
+ *
+ *  @param arg Unused.
+ *  @return void* - Unused.
+ */
+static void *engine(void *arg)
+{
+  while (!Stop)
+  {
+    if (!__atomic_load_n(&Busy, __ATOMIC_ACQUIRE))
+    {
+      usleep(20);
+      continue;
+    }
+
+    if (WireBytes + SpanBytes <= WIRE_SIZE)
+      memcpy(&Wire[WireBytes], (const uint8_t *)SpanData, SpanBytes);
+    usleep(SpanBytes);
+
+    Host_DisableInterrupts();
+    WireBytes += SpanBytes;
+    Busy = false;
+    TxQ_Done();
+    Host_EnableInterrupts();
+  }
+
+  return NULL;
+}
+
+/*! @brief Puts a packet of the next bytes of the pattern, keeping a copy of what the wire should carry.
+ *
+ */
+static void putPacket(void)
+{
+  uint8_t packet[PACKET_NB_BYTES];
+
+  for (uint8_t byteNb = 0; byteNb < PACKET_NB_BYTES; byteNb++)
+  {
+    packet[byteNb] = (uint8_t)(ExpectedBytes * 7 + 3);
+    Expected[ExpectedBytes++] = packet[byteNb];
+  }
+
+  TxQ_Put(packet, PACKET_NB_BYTES);
+}
+
+/*! @brief Waits for the engine to put everything put so far on the wire.
+ *
+ *  @return bool - TRUE if it did within a few seconds.
+ */
+static bool drained(void)
+{
+  for (unsigned tries = 0; tries < 100000; tries++)
+  {
+    Host_DisableInterrupts();
+    bool done = !Busy && (WireBytes == ExpectedBytes);
+    Host_EnableInterrupts();
+
+    if (done)
+      return true;
+    usleep(50);
+  }
+
+  return false;
+}
+
+/*! @brief Checks a burst waits for its end, then goes out in one span.
+ *
+ */
+static void testBurst(void)
+{
+  uint32_t transfers = TxQ_NbTransfers();
+
+  TxQ_Begin();
+  for (uint8_t packetNb = 0; packetNb < BURST_NB_PACKETS; packetNb++)
+    putPacket();
+
+  usleep(1000);
+  HOST_CHECK(!Busy && WireBytes == 0);
+
+  TxQ_End();
+  HOST_CHECK(drained());
+  HOST_CHECK(TxQ_NbTransfers() - transfers == 1);
+
+  // A packet on its own goes at once
+  putPacket();
+  HOST_CHECK(drained());
+  HOST_CHECK(TxQ_NbTransfers() - transfers == 2);
+}
+
+/*! @brief Sends bursts back to back, which share spans while the engine is busy.
+ *
+ */
+static void testBackToBack(void)
+{
+  uint32_t transfers = TxQ_NbTransfers();
+
+  for (uint8_t burstNb = 0; burstNb < NB_BURSTS; burstNb++)
+  {
+    TxQ_Begin();
+    for (uint8_t packetNb = 0; packetNb < BURST_NB_PACKETS; packetNb++)
+      putPacket();
+    TxQ_End();
+  }
+
+  HOST_CHECK(drained());
+  transfers = TxQ_NbTransfers() - transfers;
+
+  printf("%u bursts of %u packets back to back: %u completions\n", NB_BURSTS, BURST_NB_PACKETS, transfers);
+  HOST_CHECK(transfers <= NB_BURSTS);
+}
+
+/*! @brief Sends a download many times the size of the queue in one burst, so the producer waits for space.
+ *
+ */
+static void testDownload(void)
+{
+  uint32_t transfers = TxQ_NbTransfers();
+  uint32_t nbBytes = NB_DOWNLOAD_PACKETS * PACKET_NB_BYTES;
+  uint64_t start = Host_Nanoseconds();
+
+  TxQ_Begin();
+  for (uint16_t packetNb = 0; packetNb < NB_DOWNLOAD_PACKETS; packetNb++)
+    putPacket();
+  TxQ_End();
+
+  HOST_CHECK(drained());
+  double seconds = (Host_Nanoseconds() - start) * 1e-9;
+  transfers = TxQ_NbTransfers() - transfers;
+
+  printf("%u-byte download through a %u-byte queue: %u completions, %.1f per kB against 1024 a byte at a time, %.0f kB/s\n",
+         nbBytes, TXQ_SIZE, transfers, transfers * 1024.0 / nbBytes, nbBytes / 1024.0 / seconds);
+
+  // A completion every TXQ_SPAN_NB_FRAMES packets, and one more each time the span wraps the queue
+  HOST_CHECK(transfers <= NB_DOWNLOAD_PACKETS / TXQ_SPAN_NB_FRAMES + nbBytes / TXQ_SIZE + 1);
+}
+
+/*! @brief Sends a download with the top bit of each byte clear, for trip events to be pushed into.
+ *
+ *  @param arg Unused.
+ *  @return void* - Unused.
+ */
+static void *download(void *arg)
+{
+  uint8_t packet[PACKET_NB_BYTES];
+
+  TxQ_Begin();
+  for (uint32_t packetNb = 0; packetNb < NB_DOWNLOAD_PACKETS * 2; packetNb++)
+  {
+    for (uint8_t byteNb = 0; byteNb < PACKET_NB_BYTES; byteNb++)
+      packet[byteNb] = (uint8_t)(packetNb * PACKET_NB_BYTES + byteNb) & 0x7F;
+    TxQ_Put(packet, PACKET_NB_BYTES);
+  }
+  TxQ_End();
+
+  return NULL;
+}
+
+/*! @brief Waits for a trip event to reach the wire.
+ *
+ *  @param start The wire position to look from.
+ *  @param marker The byte the event is made of.
+ *  @return uint32_t - The wire position of the event, or WIRE_SIZE if it didn't arrive within a second.
+ */
+static uint32_t find(const uint32_t start, const uint8_t marker)
+{
+  for (unsigned tries = 0; tries < 10000; tries++)
+  {
+    uint32_t end = __atomic_load_n(&WireBytes, __ATOMIC_ACQUIRE);
+    const uint8_t *found = memchr(&Wire[start], marker, end - start);
+
+    if (found)
+      return found - Wire;
+    usleep(100);
+  }
+
+  return WIRE_SIZE;
+}
+
+/*! @brief Pushes trip events, two at a time, into a download, and checks where they land.
+ *
+ */
+static void testUrgent(void)
+{
+  pthread_t thread;
+  uint32_t base = WireBytes, worst = 0, nbPushed = 0;
+  uint8_t event[EVENT_NB_BYTES];
+  bool whole = true;
+
+  pthread_create(&thread, NULL, download, NULL);
+
+  for (uint8_t eventNb = 0; eventNb < NB_EVENTS; eventNb++)
+  {
+    usleep(2000 + eventNb * 700);
+
+    // Whatever the engine is sending when the event is pushed must finish first
+    Host_DisableInterrupts();
+    uint32_t due = WireBytes + (Busy ? SpanBytes : 0);
+    Host_EnableInterrupts();
+
+    // The second waits in the other buffer while the engine sends the first
+    memset(event, 0x80 | eventNb, sizeof(event));
+    HOST_CHECK(TxQ_PutUrgent(event, sizeof(event)));
+    memset(event, 0xC0 | eventNb, sizeof(event));
+    HOST_CHECK(TxQ_PutUrgent(event, sizeof(event)));
+    nbPushed += 2;
+
+    // More than the room left is refused rather than waited for
+    if (eventNb == 0)
+    {
+      uint8_t large[TXQ_URGENT_SIZE + 1] = {0};
+      HOST_CHECK(!TxQ_PutUrgent(large, sizeof(large)));
+    }
+
+    for (uint8_t pairNb = 0; pairNb < 2; pairNb++)
+    {
+      uint8_t marker = (pairNb ? 0xC0 : 0x80) | eventNb;
+      uint32_t position = find(base, marker);
+      HOST_CHECK(position < WIRE_SIZE);
+      if (position >= WIRE_SIZE)
+        break;
+
+      while (WireBytes < position + EVENT_NB_BYTES)
+        usleep(100);
+
+      for (uint8_t byteNb = 0; byteNb < EVENT_NB_BYTES; byteNb++)
+        whole = whole && (Wire[position + byteNb] == marker);
+      whole = whole && ((position - base) % PACKET_NB_BYTES == 0);
+
+      if (pairNb == 0 && position > due && position - due > worst)
+        worst = position - due;
+    }
+  }
+
+  pthread_join(thread, NULL);
+
+  uint32_t downloadBytes = NB_DOWNLOAD_PACKETS * 2 * PACKET_NB_BYTES;
+  for (unsigned tries = 0; tries < 100000 && (Busy || WireBytes < base + downloadBytes + nbPushed * EVENT_NB_BYTES); tries++)
+    usleep(50);
+
+  // Without the events, the download is intact
+  uint32_t nbDownloaded = 0, errors = 0;
+  for (uint32_t position = base; position < WireBytes; position++)
+  {
+    if (Wire[position] & 0x80)
+      continue;
+    errors += (Wire[position] != (uint8_t)(nbDownloaded & 0x7F));
+    nbDownloaded++;
+  }
+
+  printf("%u trip events pushed into a download: worst %u download bytes sent before the first of a pair, against %u in a span\n",
+         nbPushed, worst, TXQ_SPAN_NB_FRAMES * PACKET_NB_BYTES);
+
+  HOST_CHECK(whole);
+  HOST_CHECK(worst <= TXQ_SPAN_NB_FRAMES * PACKET_NB_BYTES);
+  HOST_CHECK(nbDownloaded == downloadBytes && errors == 0);
+  HOST_CHECK(WireBytes == base + downloadBytes + nbPushed * EVENT_NB_BYTES);
+}
+
+/*! @brief Checks UART_DMAErrorISR resumes a span from the failed byte, and drops it once out of retries.
+ *
+ */
+static void testDMAError(void)
+{
+  static const uint8_t first[PACKET_NB_BYTES] = {1, 2, 3, 4, 5};
+  static const uint8_t second[PACKET_NB_BYTES] = {6, 7, 8, 9, 10};
+
+  HOST_CHECK(UART_Init(115200, 60000000));
+
+  // The first packet starts the channel, the second waits behind it
+  UART_OutChars(first, PACKET_NB_BYTES);
+  uint32_t address = Host_DMA.TCD[0].SADDR;
+  HOST_CHECK(Host_DMA.TCD[0].CITER_ELINKNO == PACKET_NB_BYTES);
+
+  UART_OutChars(second, PACKET_NB_BYTES);
+  HOST_CHECK(Host_DMA.TCD[0].SADDR == address);
+
+  // An error with three bytes still to go resumes from the third byte
+  Host_DMA.TCD[0].CITER_ELINKNO = 3;
+  UART_DMAErrorISR();
+  HOST_CHECK(UART_DMAErrors() == 1);
+  HOST_CHECK(Host_DMA.TCD[0].SADDR == address + 2);
+  HOST_CHECK(Host_DMA.TCD[0].CITER_ELINKNO == 3);
+  HOST_CHECK(TxQ_NbTransfers() == 0);
+
+  // The retry fails without progress, and the next is the last
+  UART_DMAErrorISR();
+  HOST_CHECK(Host_DMA.TCD[0].SADDR == address + 2);
+  HOST_CHECK(TxQ_NbTransfers() == 0);
+
+  // Out of retries, the rest of the packet is dropped and the second starts
+  UART_DMAErrorISR();
+  HOST_CHECK(UART_DMAErrors() == 3);
+  HOST_CHECK(TxQ_NbTransfers() == 1);
+  HOST_CHECK(Host_DMA.TCD[0].SADDR == address + PACKET_NB_BYTES);
+  HOST_CHECK(Host_DMA.TCD[0].CITER_ELINKNO == PACKET_NB_BYTES);
+
+  // Which completes normally
+  UART_DMAISR();
+  HOST_CHECK(TxQ_NbTransfers() == 2);
+}
+
+int main(void)
+{
+  pthread_t thread;
+
+  HOST_CHECK(TxQ_Init(start, PACKET_NB_BYTES));
+  pthread_create(&thread, NULL, engine, NULL);
+
+  testBurst();
+  testBackToBack();
+  testDownload();
+
+  HOST_CHECK(WireBytes == ExpectedBytes);
+  HOST_CHECK(memcmp(Wire, Expected, ExpectedBytes) == 0);
+
+  testUrgent();
+
+  Stop = true;
+  pthread_join(thread, NULL);
+
+  HOST_CHECK(Overlaps == 0);
+
+  testDMAError();
+
+  return Host_Result();
+}
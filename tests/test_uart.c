@@ -0,0 +1,223 @@
+/*! @file test_uart.c
+ *
+ *  @brief Host test and benchmark of the UART receive path
+ *
+ *  A feeder thread plays the UART, setting the stand-in status and data registers and calling
+ *  UART_ISR at 115200 baud, while a receiver thread waits in UART_InWait and takes the bytes with
+ *  UART_InChars, as the packet thread does. Reports the ISR time per byte, the receiver's CPU time per kilobyte and the
+ *  receiver wakeups per packet, and checks a partial packet is handed over when the line goes
+ *  idle. The idle case waits for the receiver to block before it sends, so it does not depend on
+ *  how the host schedules the threads. Profile_Cycles counts host nanoseconds here, so the ISR figures UART.c
+ *  keeps are in nanoseconds, and the worst case takes in the host scheduler as well as the ISR.
+ *
+ *  @author 11989668
+ *  @date 2026-10-17
+ */
+
+#include "host.h"
+#include "UART.h"
+#include "packet.h"
+#include "MK70F12.h"
+
+#include <pthread.h>
+#include <time.h>
+
+// Line rate, and the time a byte of 10 bits takes at it
+#define BAUD_RATE 115200
+#define BYTE_TIME (10 * 1000000000ull / BAUD_RATE)
+
+// Packets received back to back at the line rate
+#define NB_PACKETS 2000
+
+// Bytes of a partial packet, handed over by the idle line
+#define NB_PARTIAL_BYTES 3
+
+static volatile uint32_t Received;  /*!< Bytes the receiver has taken */
+static volatile uint32_t Expected;  /*!< Bytes the receiver should take before it stops */
+static uint32_t Errors;             /*!< Bytes the receiver took out of sequence */
+static uint64_t ReceiverNanoseconds; /*!< CPU time the receiver thread used */
+
+uint32_t Profile_Cycles(void)
+{
+  return (uint32_t)Host_Nanoseconds();
+}
+
+/*! @brief The byte the feeder sends at a position in the stream.
+ *
+ *  @param byteNb The position.
+ *  @return uint8_t - The byte.
+ */
+static uint8_t pattern(const uint32_t byteNb)
+{
+  return (uint8_t)(byteNb * 7 + 3);
+}
+
+/*! @brief Raises a UART interrupt with the given status, as the hardware would.
+ *
+ *  @param status The S1 flags.
+ *  @param data The byte in the data register.
+ */
+static void interrupt(const uint8_t status, const uint8_t data)
+{
+  Host_UART2.S1 = status;
+  Host_UART2.D = data;
+  UART_ISR();
+}
+
+/*! @brief Takes bytes as the packet thread does until told to stop.
+ *
+ *  @param arg Unused.
+ *  @return void* - Unused.
+ */
+static void *receiver(void *arg)
+{
+  struct timespec start, end;
+  uint8_t data[64];
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+
+  while (Received < Expected)
+  {
+    UART_InWait();
+
+    uint16_t nbBytes = UART_InChars(data, sizeof(data));
+    for (uint16_t byteNb = 0; byteNb < nbBytes; byteNb++)
+      Errors += (data[byteNb] != pattern(Received + byteNb));
+
+    __atomic_store_n(&Received, Received + nbBytes, __ATOMIC_RELEASE);
+  }
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+  ReceiverNanoseconds = (end.tv_sec - start.tv_sec) * 1000000000ull + end.tv_nsec - start.tv_nsec;
+
+  return NULL;
+}
+
+/*! @brief Waits for the receiver to take a number of bytes.
+ *
+ *  @param nbBytes The bytes it should have taken in all.
+ *  @return bool - TRUE if it took them within a second.
+ */
+static bool drained(const uint32_t nbBytes)
+{
+  uint64_t deadline = Host_Nanoseconds() + 1000000000ull;
+
+  while (__atomic_load_n(&Received, __ATOMIC_ACQUIRE) < nbBytes)
+  {
+    if (Host_Nanoseconds() > deadline)
+      return false;
+    sched_yield();
+  }
+
+  return true;
+}
+
+/*! @brief Waits for the receiver to block for want of bytes.
+ *
+ *  @return bool - TRUE if it blocked within a second.
+ */
+static bool blocked(void)
+{
+  uint64_t deadline = Host_Nanoseconds() + 1000000000ull;
+
+  while (Host_SemaphoreBlocked() == 0)
+  {
+    if (Host_Nanoseconds() > deadline)
+      return false;
+    sched_yield();
+  }
+
+  return true;
+}
+
+/*! @brief Sends packets back to back at the line rate, so the line only goes idle after the last.
+ *
+ *  @return uint32_t - The receiver wakeups.
+ */
+static uint32_t testLineRate(void)
+{
+  struct timespec due;
+  uint32_t signals = Host_SemaphoreSignals();
+
+  clock_gettime(CLOCK_MONOTONIC, &due);
+
+  for (uint32_t byteNb = 0; byteNb < NB_PACKETS * PACKET_NB_BYTES; byteNb++)
+  {
+    struct timespec now;
+
+    // Bytes never arrive closer together than the line rate, so a feeder scheduled late doesn't catch up
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec > due.tv_sec || (now.tv_sec == due.tv_sec && now.tv_nsec > due.tv_nsec))
+      due = now;
+
+    due.tv_nsec += BYTE_TIME;
+    if (due.tv_nsec >= 1000000000)
+    {
+      due.tv_nsec -= 1000000000;
+      due.tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+
+    interrupt(UART_S1_RDRF_MASK | UART_S1_TDRE_MASK, pattern(byteNb));
+  }
+
+  // The receiver may have started on a packet early and left the end of one for the idle line
+  interrupt(UART_S1_IDLE_MASK, 0);
+  HOST_CHECK(drained(NB_PACKETS * PACKET_NB_BYTES));
+
+  return Host_SemaphoreSignals() - signals;
+}
+
+/*! @brief Sends part of a packet, checks the receiver waits for the rest, then lets the line go idle.
+ *
+ */
+static void testIdle(void)
+{
+  uint32_t sent = NB_PACKETS * PACKET_NB_BYTES;
+
+  // Once the receiver is blocked, only the ISR can wake it, so what it does with the bytes is all that is tested
+  HOST_CHECK(blocked());
+
+  uint32_t signals = Host_SemaphoreSignals();
+
+  for (uint32_t byteNb = sent; byteNb < sent + NB_PARTIAL_BYTES; byteNb++)
+    interrupt(UART_S1_RDRF_MASK, pattern(byteNb));
+
+  HOST_CHECK(Host_SemaphoreSignals() == signals);
+  HOST_CHECK(Received == sent);
+
+  interrupt(UART_S1_IDLE_MASK, 0);
+  HOST_CHECK(Host_SemaphoreSignals() == signals + 1);
+  HOST_CHECK(drained(sent + NB_PARTIAL_BYTES));
+}
+
+int main(void)
+{
+  pthread_t thread;
+
+  HOST_CHECK(UART_Init(BAUD_RATE, 60000000));
+
+  Expected = NB_PACKETS * PACKET_NB_BYTES + NB_PARTIAL_BYTES;
+  pthread_create(&thread, NULL, receiver, NULL);
+
+  uint32_t wakeups = testLineRate();
+  testIdle();
+
+  // A receiver still waiting for bytes that were lost would never finish
+  if (Received == Expected)
+    pthread_join(thread, NULL);
+
+  double isrNs = UART_ISRCyclesPerByte();
+
+  printf("%u packets at %u baud: %u bytes out of sequence, %.3f receiver wakeups per packet\n", NB_PACKETS, BAUD_RATE, Errors,
+         (double)wakeups / NB_PACKETS);
+  printf("host ns in the ISR per byte %.0f, worst %u; receiver CPU us per kB %.1f; ISR load at the line rate %.3f%%\n", isrNs,
+         UART_ISRMaxCycles(), ReceiverNanoseconds / 1e3 / (Expected / 1024.0), isrNs * (BAUD_RATE / 10) / 1e7);
+
+  HOST_CHECK(Errors == 0);
+
+  // A wakeup per whole packet, where handing each byte to a thread took two semaphore calls
+  HOST_CHECK(wakeups <= NB_PACKETS * 11 / 10);
+
+  return Host_Result();
+}